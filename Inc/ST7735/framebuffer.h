@@ -0,0 +1,89 @@
+/**
+ ******************************************************************************
+ * @file      framebuffer.h
+ * @brief     RGB565 framebuffer for the ST7735 with dirty rectangle tracking
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#ifndef __FRAMEBUFFER_H
+#define __FRAMEBUFFER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define FRAMEBUFFER_WIDTH       160
+#define FRAMEBUFFER_HEIGHT      80
+#define FRAMEBUFFER_MAX_DIRTY   8     // separate areas tracked before merging
+
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+    uint16_t w;
+    uint16_t h;
+} framebuffer_rect_t;
+
+/**
+ * @brief Clear to black and forget all dirty areas
+ * @note  Use when the panel content is known to match, e.g. after boot
+ */
+void framebuffer_init(void);
+
+/**
+ * @brief Fill the whole frame with a color, marks everything dirty
+ */
+void framebuffer_clear(uint16_t color);
+
+/**
+ * @brief Fill a rectangle, clipped to the frame
+ */
+void framebuffer_fill_rect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color);
+
+/**
+ * @brief Set one pixel, ignored when outside the frame
+ */
+void framebuffer_set_pixel(int32_t x, int32_t y, uint16_t color);
+
+/**
+ * @brief Draw a 1 bpp column-major bitmap (the font.h glyph layout)
+ * @param bits        bytes_per_col bytes per column, MSB is the top pixel
+ * @param transparent when true only set bits are drawn
+ */
+void framebuffer_draw_mono(int32_t x, int32_t y, const uint8_t *bits, uint8_t w, uint8_t h,
+                           uint8_t bytes_per_col, uint16_t fg, uint16_t bg, bool transparent);
+
+/**
+ * @brief Copy a block of pixels that are already in panel byte order
+ * @param pixels w * h pixels, row-major
+ * @note  Does not mark the area dirty, so a run of blits (e.g. a string)
+ *        can be marked once with framebuffer_mark_dirty()
+ */
+void framebuffer_blit(int32_t x, int32_t y, const uint16_t *pixels, int32_t w, int32_t h);
+
+/**
+ * @brief Add an area that has to be sent to the panel
+ */
+void framebuffer_mark_dirty(int32_t x, int32_t y, int32_t w, int32_t h);
+
+/**
+ * @brief Take the next dirty area
+ * @return false when nothing is left to flush
+ */
+bool framebuffer_take_dirty(framebuffer_rect_t *rect);
+
+/**
+ * @brief Address of a pixel, rows are FRAMEBUFFER_WIDTH pixels apart
+ * @note  Pixels are stored high byte first, the order the panel expects
+ */
+const uint16_t *framebuffer_get_pixels(uint16_t x, uint16_t y);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FRAMEBUFFER_H */
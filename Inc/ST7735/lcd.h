@@ -23,6 +23,9 @@
 #define LIGHTBLUE  0X7D7C
 #define GRAYBLUE   0X5458
 
+// High byte first, the order lcd_draw_pixels() expects
+#define LCD_PANEL_COLOR(c)  ((uint16_t)(((c) << 8) | ((uint16_t)(c) >> 8)))
+
 extern ST7735_Object_t st7735_pObj;
 extern uint32_t st7735_id;
 
@@ -32,6 +35,8 @@ extern uint16_t BACK_COLOR;
 extern void lcd_init(void);
 extern void lcd_show_bootlogo(void);
 extern void lcd_clear(void);
+extern void lcd_flush(void);
+extern void lcd_flush_async(void);
 
 extern void lcd_set_brightness(uint32_t Brightness);
 extern uint32_t lcd_get_brightness(void);
@@ -41,6 +46,7 @@ extern uint32_t lcd_get_height(void);
 
 extern void lcd_draw_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
 extern void lcd_draw_filled_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
+extern void lcd_draw_pixels(uint16_t x, uint16_t y, const uint16_t *pixels, uint16_t w, uint16_t h);
 
 
 extern void lcd_light(uint32_t Brightness_Dis,uint32_t time);
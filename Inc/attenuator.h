@@ -1,11 +1,24 @@
 #ifndef ATTENUATOR_H
 #define ATTENUATOR_H
 
+#include <stdbool.h>
+
 #define ATTENUATOR_MAX_DB   31.5f
 #define ATTENUATOR_MIN_DB   0.0f
 
+// auto ranging keeps the SA818 RSSI between LOW and HIGH, about 1 dB per step
+#define ATTENUATOR_AUTO_HIGH_RSSI     90    // receiver starts to compress above this
+#define ATTENUATOR_AUTO_LOW_RSSI      74
+#define ATTENUATOR_AUTO_TARGET_RSSI   82    // where a step aims for
+#define ATTENUATOR_AUTO_SETTLE_MS     200   // RSSI readings ignored after a step
+
 void attenuator_init(void);
 void attenuator_set(float attenuation_db);
 float attenuator_get(void);
 
+void attenuator_set_auto(bool enable);
+bool attenuator_is_auto(void);
+void attenuator_task(void);                 // run from main loop, follows the RSSI
+float attenuator_get_effective_rssi(void);  // RSSI + attenuation, keeps rising past saturation
+
 #endif // ATTENUATOR_H
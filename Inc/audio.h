@@ -0,0 +1,64 @@
+/**
+ ******************************************************************************
+ * @file      audio.h
+ * @brief     Continuous capture of the SA818 audio output in fixed blocks
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#ifndef __AUDIO_H
+#define __AUDIO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define AUDIO_SAMPLE_RATE_HZ    8000
+#define AUDIO_BLOCK_SIZE        128   // samples per callback, 16 ms at 8 kHz
+#define AUDIO_MAX_SUBSCRIBERS   6
+
+/**
+ * @brief Called with every captured block
+ * @param samples signed samples with the DC offset removed, only valid
+ *                during the call
+ */
+typedef void (*audio_block_cb_t)(const int16_t *samples, uint16_t count);
+
+/**
+ * @brief Set up the ADC, its sample timer and the DMA, and start capturing
+ */
+void audio_init(void);
+
+/**
+ * @brief Hands finished blocks to the subscribers
+ * @note  Should be called regularly from the main loop, at least once per
+ *        block, otherwise blocks are dropped and counted as overruns.
+ */
+void audio_task(void);
+
+/**
+ * @brief Register a block consumer
+ * @return false when all subscriber slots are taken
+ */
+bool audio_subscribe(audio_block_cb_t callback);
+
+/**
+ * @brief Hand a block to every subscriber as audio_task() does, for the
+ *        boot benchmark to run the decoders on a block of its own
+ */
+void audio_dispatch(const int16_t *samples, uint16_t count);
+
+/**
+ * @brief Number of blocks dropped because audio_task() was too late
+ */
+uint32_t audio_get_overruns(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __AUDIO_H */
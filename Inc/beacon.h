@@ -0,0 +1,118 @@
+/**
+ ******************************************************************************
+ * @file      beacon.h
+ * @brief     Fox beacon: scheduled transmissions with tone and MCW ID
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#ifndef __BEACON_H
+#define __BEACON_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BEACON_TICK_HZ          1000  // engine steps per second, all times in ms
+#define BEACON_CALLSIGN_LEN     15
+
+/*
+ * The schedule the beacon starts with. BEACON_CALLSIGN has no default, the
+ * MCW ID has to be the station's own callsign: build with e.g.
+ * -DBEACON_CALLSIGN=\"PA3XYZ\". The rest can be changed in the menu.
+ */
+#ifndef BEACON_INTERVAL_S
+#define BEACON_INTERVAL_S       60    // start of one transmission to the next
+#endif
+#ifndef BEACON_TONE_S
+#define BEACON_TONE_S           10    // continuous tone, 0 for ID only
+#endif
+#ifndef BEACON_ID_EVERY
+#define BEACON_ID_EVERY         1     // ID on every Nth transmission, 0 for never
+#endif
+
+typedef enum {
+    BEACON_STATE_OFF = 0,
+    BEACON_STATE_WAIT,      // PTT released, waiting for the next interval
+    BEACON_STATE_LEAD,      // PTT keyed, lets the SA818 settle before audio
+    BEACON_STATE_TONE,      // continuous tone for direction finding
+    BEACON_STATE_ID,        // MCW callsign
+    BEACON_STATE_TAIL       // audio off, PTT still keyed
+} beacon_state_t;
+
+typedef struct {
+    char callsign[BEACON_CALLSIGN_LEN + 1];
+    uint16_t interval_s;    // start of one transmission to the next
+    uint16_t tone_s;        // continuous tone per transmission, 0 for ID only
+    uint8_t id_every;       // ID on every Nth transmission, 0 for never
+    uint8_t wpm;            // MCW keying speed
+    uint16_t tone_hz;       // audio tone for both the carrier and the ID
+    uint16_t lead_ms;       // PTT to audio
+    uint16_t tail_ms;       // audio to PTT release
+} beacon_config_t;
+
+/**
+ * @brief Set up the tick timer and load the default schedule
+ */
+void beacon_init(void);
+
+/**
+ * @brief Start transmitting, the first transmission begins right away
+ */
+void beacon_start(void);
+
+/**
+ * @brief Stop at once, audio off and PTT released
+ */
+void beacon_stop(void);
+
+/**
+ * @brief Start and stop the tone output as the tick asks, on
+ *        SCHEDULER_EVENT_BEACON
+ * @note  The tick keys the running tone with testtone_key() only.
+ */
+void beacon_task(void);
+
+bool beacon_is_running(void);
+
+/**
+ * @brief Send a one-off MCW text (up to BEACON_CALLSIGN_LEN characters)
+ *        with the usual lead and tail, also when the beacon is stopped
+ * @return false while a transmission is already on the air
+ */
+bool beacon_send_text(const char *text);
+beacon_state_t beacon_get_state(void);
+
+/**
+ * @brief Transmissions made since beacon_start()
+ */
+uint32_t beacon_get_cycles(void);
+
+/**
+ * @brief Seconds until the next transmission starts, 0 while transmitting
+ */
+uint16_t beacon_get_seconds_to_next(void);
+
+const beacon_config_t *beacon_get_config(void);
+
+/**
+ * @brief Replace the schedule, takes effect with the next transmission
+ */
+void beacon_set_config(const beacon_config_t *config);
+
+/**
+ * @brief Advance the engine by one tick (1 / BEACON_TICK_HZ)
+ * @note  Called from the TIM17 interrupt. Time only passes through this
+ *        call, so a host build can step it in a loop as a simulated clock.
+ */
+void beacon_tick(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BEACON_H */
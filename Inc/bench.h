@@ -0,0 +1,60 @@
+/**
+ ******************************************************************************
+ * @file      bench.h
+ * @brief     Boot time benchmark of the DSP, the FFT, the ADC interrupt and
+ *            the menu redraw with the L1 caches off, on and emptied
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "profile.h"
+
+// Off unless asked for, it needs the profile table to report into
+#ifndef BENCH_ENABLE
+#define BENCH_ENABLE  0
+#endif
+
+#if BENCH_ENABLE && !PROFILE_ENABLE
+#error "BENCH_ENABLE needs PROFILE_ENABLE, the results go into the profile table"
+#endif
+
+#define BENCH_BLOCKS    64    // audio blocks per measurement, about 1 s of audio
+#define BENCH_REDRAWS   8     // full redraws, menu and home screen in turn
+
+/*
+ * The profile view shows every measurement three ways:
+ *
+ *   c0   L1 caches off
+ *   c1   caches on
+ *   cx   caches on, emptied before every call: what is left is the TCMs
+ *
+ * With TCM_PLACEMENT_ENABLE the ITCM_TEXT and DTCM_* code and data do not
+ * depend on the caches, so c0, c1 and cx of dsp, fft and irq stay close.
+ * A build with TCM_PLACEMENT_ENABLE=0 shows what they cost from flash and
+ * AXI SRAM. The menu redraw runs from flash either way, draw has no cx.
+ */
+
+/**
+ * @brief Run every measurement with the caches off, then on, then emptied,
+ *        and leave them as CPU_CACHE_ENABLE has them
+ * @note  Call once after menu_init(), before the scheduler starts. Takes
+ *        about 4 s. The ADC keeps running, so audio_get_overruns() counts
+ *        the blocks missed meanwhile. The other profile entries are reset
+ *        afterwards, they would have the caches off in them, and the
+ *        display opens on the profile view with the results.
+ */
+void bench_run(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BENCH_H */
@@ -0,0 +1,56 @@
+/**
+ ******************************************************************************
+ * @file      ctcss.h
+ * @brief     CTCSS sub-tone detector on the received audio (Goertzel bank)
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#ifndef __CTCSS_H
+#define __CTCSS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define CTCSS_TONE_COUNT        50
+#define CTCSS_DECIMATION        8     // 8 kHz audio down to 1 kHz
+#define CTCSS_WINDOW            500   // decimated samples, 0.5 s and 2 Hz bins
+#define CTCSS_MIN_CONFIDENCE    25    // percent of the window energy in the tone
+
+/**
+ * @brief Subscribe to the audio blocks, call after audio_init()
+ * @note  The SA818 removes the sub-tone unless its highpass filter is bypassed.
+ */
+void ctcss_init(void);
+
+/**
+ * @brief Detected tone, -1 when none
+ * @note  A tone is reported once it wins two windows in a row.
+ */
+int8_t ctcss_get_tone(void);
+
+/**
+ * @brief Frequency of a tone index in tenths of Hz, 0 for no tone
+ */
+uint16_t ctcss_get_tone_dhz(int8_t tone);
+
+/**
+ * @brief SA818 sub-audio code of a tone index (1..38), 0 if the module
+ *        does not support it or for no tone
+ */
+uint8_t ctcss_get_sa818_code(int8_t tone);
+
+/**
+ * @brief Share of the last window's energy in the strongest tone, percent
+ */
+uint8_t ctcss_get_confidence(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CTCSS_H */
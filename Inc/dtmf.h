@@ -0,0 +1,76 @@
+/**
+ ******************************************************************************
+ * @file      dtmf.h
+ * @brief     DTMF decoder on the received audio with a PIN protected
+ *            remote control
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#ifndef __DTMF_H
+#define __DTMF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define DTMF_WINDOW             205   // samples per decision, 25.6 ms at 8 kHz
+#define DTMF_PIN_LEN            4
+#define DTMF_MAX_DIGITS         12    // between '*' and '#'
+#define DTMF_TIMEOUT_WINDOWS    195   // about 5 s without a digit drops the command
+#define DTMF_MAX_BAD_PINS       3
+#define DTMF_LOCKOUT_WINDOWS    2344  // about 60 s of ignoring commands
+
+/*
+ * Commands are sent as '*', the PIN, the command and '#':
+ *
+ *   *<PIN>0#    status, answered in MCW: beacon, power and transmissions
+ *   *<PIN>10#   beacon off
+ *   *<PIN>11#   beacon on
+ *   *<PIN>20#   low power
+ *   *<PIN>21#   high power
+ *   *<PIN>3n#   volume n (1..8)
+ *   *<PIN>4n#   squelch n (0..8)
+ *
+ * Accepted commands are answered with "R" in MCW, anything else is ignored.
+ *
+ * There is no default PIN, the remote control stays off until one is set.
+ * Build with DTMF_PIN, e.g. -DDTMF_PIN=\"4711\", to set it in dtmf_init().
+ */
+
+/**
+ * @brief Subscribe to the audio blocks, call after audio_init()
+ * @note  Every audio sample costs eight filter updates and every window
+ *        one decision, so the time per block is fixed.
+ */
+void dtmf_init(void);
+
+/**
+ * @brief Last decoded key ('0'..'9', '*', '#', 'A'..'D'), '\0' before the first
+ */
+char dtmf_get_last_digit(void);
+
+/**
+ * @brief Incremented for every decoded key, to spot new ones
+ */
+uint32_t dtmf_get_digit_count(void);
+
+/**
+ * @brief Set the PIN and turn the remote control on
+ * @param pin DTMF_PIN_LEN digits '0'..'9', NULL or anything else turns the
+ *            remote control off
+ * @return true when the remote control is on
+ * @note  Nothing sets a PIN unless the build has DTMF_PIN. Without one the
+ *        keys are still decoded, but every command is ignored.
+ */
+bool dtmf_set_pin(const char *pin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DTMF_H */
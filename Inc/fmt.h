@@ -0,0 +1,68 @@
+/**
+ ******************************************************************************
+ * @file      fmt.h
+ * @brief     Allocation-free integer text formatting for UI and AT commands
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#ifndef __FMT_H
+#define __FMT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+// All functions write into buf, never more than size bytes including the
+// terminating '\0', and return the number of characters written. Output
+// that does not fit is truncated. Calls can be chained:
+//
+//     n  = fmt_str(buf, sizeof(buf), "RSSI: ");
+//     n += fmt_int(buf + n, sizeof(buf) - n, rssi);
+
+/**
+ * @brief Copy a string
+ */
+size_t fmt_str(char *buf, size_t size, const char *str);
+
+/**
+ * @brief Unsigned decimal
+ */
+size_t fmt_uint(char *buf, size_t size, uint32_t value);
+
+/**
+ * @brief Signed decimal
+ */
+size_t fmt_int(char *buf, size_t size, int32_t value);
+
+/**
+ * @brief Unsigned decimal, right aligned in a field of width characters
+ * @param pad Fill character, e.g. '0' or ' '
+ */
+size_t fmt_uint_pad(char *buf, size_t size, uint32_t value, uint8_t width, char pad);
+
+/**
+ * @brief Fixed-point decimal, value is scaled by 10^decimals
+ * @note  fmt_fixed(buf, size, -125, 1) gives "-12.5"
+ */
+size_t fmt_fixed(char *buf, size_t size, int32_t value, uint8_t decimals);
+
+/**
+ * @brief Frequency in MHz with four decimals (100 Hz resolution), "144.4500"
+ */
+size_t fmt_mhz(char *buf, size_t size, uint32_t freq_hz);
+
+/**
+ * @brief Level with unit, "-87 dBm"
+ */
+size_t fmt_dbm(char *buf, size_t size, int32_t dbm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FMT_H */
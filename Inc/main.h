@@ -36,6 +36,40 @@ extern "C" {
 
 /* Exported macro ------------------------------------------------------------*/
 
+/* Buffers that a DMA reads or writes, placed in D2 SRAM next to DMA1/DMA2.
+   The section is not zeroed by the startup code. The MPU keeps it out of
+   the D-cache (MPU_Config), so neither side needs cache maintenance. */
+#define DMA_BUFFER __attribute__((section(".dma_buffer"), aligned(32)))
+
+/* Size of the non-cacheable MPU region at the start of D2 SRAM, the
+   linker script checks that .dma_buffer fits in it */
+#define DMA_BUFFER_REGION_SIZE  MPU_REGION_SIZE_32KB
+
+/* Set to 0 to run with the L1 caches off, to compare timings */
+#ifndef CPU_CACHE_ENABLE
+#define CPU_CACHE_ENABLE  1
+#endif
+
+/* Set to 0 to leave the ITCM_TEXT and DTCM_* code and data in flash and
+   AXI SRAM, to compare timings */
+#ifndef TCM_PLACEMENT_ENABLE
+#define TCM_PLACEMENT_ENABLE  1
+#endif
+
+/* Hot code and data in the tightly coupled memories, zero wait states and
+   no cache to miss. The startup code copies them in. ITCM_TEXT functions
+   are never inlined into callers outside ITCM. DTCM_DATA is copied from
+   flash, DTCM_BSS is zeroed. DMA1/DMA2 cannot reach DTCM: no DMA buffers. */
+#if TCM_PLACEMENT_ENABLE
+#define ITCM_TEXT __attribute__((section(".itcm_text"), noinline))
+#define DTCM_DATA __attribute__((section(".dtcm_data")))
+#define DTCM_BSS  __attribute__((section(".dtcm_bss")))
+#else
+#define ITCM_TEXT
+#define DTCM_DATA
+#define DTCM_BSS
+#endif
+
 /* Exported functions prototypes ---------------------------------------------*/
 
 void Error_Handler(void);
@@ -5,6 +5,7 @@
 
 typedef enum {
     menu_item_attenuator = 0,
+    menu_item_sig_cal,
     menu_item_bandwidth,
     menu_item_tx_freq,
     menu_item_rx_freq,
@@ -17,6 +18,9 @@ typedef enum {
     menu_item_low,
     menu_item_tail,
     menu_item_mode,
+    menu_item_interval,
+    menu_item_tone_time,
+    menu_item_id_every,
     menu_item_power,
     menu_item_count
 } menu_item_t;
@@ -27,5 +31,6 @@ void menu_value_step(int step);
 void menu_toggle(void);   // toggles between home view and menu view
 void menu_task(void);     // run from main loop
 void menu_update_display_async(void);
+void menu_show_profile(void);   // profile view from its first page, nothing without PROFILE_ENABLE
 
 #endif // MENU_H
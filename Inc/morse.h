@@ -0,0 +1,57 @@
+/**
+ ******************************************************************************
+ * @file      morse.h
+ * @brief     Streaming CW/MCW Morse decoder on the received audio
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#ifndef __MORSE_H
+#define __MORSE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define MORSE_SEGMENT       64    // samples per keying decision, 8 ms at 8 kHz
+#define MORSE_BIN_COUNT     8     // tone bins 500..1200 Hz, 100 Hz apart
+#define MORSE_TEXT_LEN      24    // decoded characters kept
+
+/**
+ * @brief Subscribe to the audio blocks, call after audio_init()
+ * @note  Every audio sample costs MORSE_BIN_COUNT filter updates and every
+ *        segment one keying decision, so the time per block is fixed.
+ */
+void morse_init(void);
+
+/**
+ * @brief The most recently decoded text, oldest character first
+ * @note  Unknown codes show as '*', word gaps as a single space.
+ */
+const char *morse_get_text(void);
+
+/**
+ * @brief Incremented for every decoded character, to spot new text
+ */
+uint32_t morse_get_text_count(void);
+
+/**
+ * @brief Keying speed the decoder has locked on to, words per minute
+ */
+uint8_t morse_get_wpm(void);
+
+/**
+ * @brief Code of a character for sending, 0 if it has none
+ * @note  Same numbering as the decoder: the bits below the leading one are
+ *        the elements, first element first, a one for a dah.
+ */
+uint8_t morse_encode(char c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MORSE_H */
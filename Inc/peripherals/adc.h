@@ -30,12 +30,18 @@ extern "C" {
 
 /* Includes -------------------------------------------------------------------*/
 
+#include <stdint.h>
+
 /* Defines -------------------------------------------------------------------*/
 
 /* Typedefs -------------------------------------------------------------------*/
 
 /* Functions -------------------------------------------------------------------*/
 
+void audio_adc_init(uint32_t sample_rate);
+uint32_t audio_adc_start(uint16_t *buffer, uint32_t length);
+void audio_adc_stop(void);
+
 #ifdef __cplusplus
 }
 #endif
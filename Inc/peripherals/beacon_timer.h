@@ -0,0 +1,49 @@
+/**
+ ******************************************************************************
+ * @file      beacon_timer.h
+ * @brief     init and control functions for the beacon tick timer
+ * @version   version
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details detailed description
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2025 Ruben van Renswoude.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+/**
+ * @addtogroup  Peripherals
+ * @{
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __BEACON_TIMER_H
+#define __BEACON_TIMER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes -------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/* Defines -------------------------------------------------------------------*/
+
+/* Typedefs -------------------------------------------------------------------*/
+
+/* Functions -------------------------------------------------------------------*/
+
+void beacon_timer_init(uint32_t tick_hz);
+void beacon_timer_start(void);
+void beacon_timer_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BEACON_TIMER_H */
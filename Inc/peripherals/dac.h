@@ -30,12 +30,21 @@ extern "C" {
 
 /* Includes -------------------------------------------------------------------*/
 
+#include <stdint.h>
+
 /* Defines -------------------------------------------------------------------*/
 
+#define DAC_WAVE_MID    2048    // 12 bit mid scale, the idle level
+
 /* Typedefs -------------------------------------------------------------------*/
 
 /* Functions -------------------------------------------------------------------*/
 
+void dac_wave_init(void);
+uint32_t dac_wave_start(const uint16_t *table, uint32_t length, uint32_t sample_rate);
+void dac_wave_stop(void);
+void dac_wave_set_sample_rate(uint32_t sample_rate);
+
 #ifdef __cplusplus
 }
 #endif
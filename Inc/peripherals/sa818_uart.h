@@ -30,6 +30,10 @@ extern "C" {
 
 /* Includes -------------------------------------------------------------------*/
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
 /* Defines -------------------------------------------------------------------*/
 
 /* Typedefs -------------------------------------------------------------------*/
@@ -39,17 +43,16 @@ extern "C" {
 extern void sa818_uart_init(void);
 
 extern void sa818_uart_transmit(const char* cmd);
-extern size_t sa818_uart_receive(const char* rxbuf, size_t size, uint32_t timeout);
 extern void sa818_uart_flush(void);
 
 extern void sa818_uart_tx_dma(const char *data, uint16_t len);
-extern void sa818_uart_rx_dma(uint8_t *buf, uint16_t len);
-
 extern bool sa818_uart_tx_done(void);
-extern bool sa818_uart_rx_done(void);
-extern int  sa818_uart_rx_length(void);
 
-extern void sa818_uart_abort_rx(void);
+// Reception runs continuously, these return one complete line without the
+// CR/LF terminator, or 0 when no full line is available (yet)
+extern size_t sa818_uart_read_line(char *line, size_t size);
+extern size_t sa818_uart_receive_line(char *line, size_t size, uint32_t timeout);
+extern uint32_t sa818_uart_rx_dropped(void);
 
 #ifdef __cplusplus
 }
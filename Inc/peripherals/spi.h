@@ -30,10 +30,14 @@ extern "C" {
 
 /* Includes -------------------------------------------------------------------*/
 
+#include <stdbool.h>
+
 #include "main.h"
 
 /* Defines -------------------------------------------------------------------*/
 
+#define DISPLAY_SPI_INLINE_LEN    (8)   // transfers up to this size are copied
+
 /* Typedefs -------------------------------------------------------------------*/
 
 /* Functions -------------------------------------------------------------------*/
@@ -42,6 +46,12 @@ void display_spi_init(void);
 uint32_t display_spi_transmit(const uint8_t *data, uint16_t size, uint32_t timeout);
 uint32_t display_spi_receive(uint8_t *data, uint16_t size, uint32_t timeout);
 
+// Non-blocking DMA path, CS and RS are driven by the driver
+bool display_spi_queue_transfer(bool command, const uint8_t *data, uint16_t len);
+uint8_t display_spi_queue_free(void);
+bool display_spi_busy(void);
+void display_spi_wait_idle(void);
+
 #ifdef __cplusplus
 }
 #endif
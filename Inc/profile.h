@@ -0,0 +1,106 @@
+/**
+ ******************************************************************************
+ * @file      profile.h
+ * @brief     Cycle count profiling of tasks and code regions (DWT CYCCNT)
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#ifndef __PROFILE_H
+#define __PROFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "scheduler.h"
+
+// On in Debug builds, define PROFILE_ENABLE=0 to drop it there as well.
+// Disabled, the probes compile to nothing.
+#ifndef PROFILE_ENABLE
+#ifdef DEBUG
+#define PROFILE_ENABLE  1
+#else
+#define PROFILE_ENABLE  0
+#endif
+#endif
+
+typedef enum {
+    PROFILE_TASK_FIRST = 0,     // one per scheduler task, by task index
+    PROFILE_DRAW_HOME = PROFILE_TASK_FIRST + SCHEDULER_MAX_TASKS,
+    PROFILE_DRAW_MENU,
+    PROFILE_DRAW_WATERFALL,
+    PROFILE_DRAW_SCANNER,
+    PROFILE_LCD_FLUSH,
+    PROFILE_SA818_LINE,
+    PROFILE_ROTARY_SCAN,
+    PROFILE_AUDIO_IRQ,          // ADC DMA interrupt, the audio path entry
+    PROFILE_BENCH_FIRST,        // boot benchmark (bench.c), kept by profile_reset()
+    PROFILE_BENCH_DSP_C0 = PROFILE_BENCH_FIRST,     // L1 caches off
+    PROFILE_BENCH_DSP_C1,       // on
+    PROFILE_BENCH_DSP_CX,       // on, emptied before every call
+    PROFILE_BENCH_FFT_C0,
+    PROFILE_BENCH_FFT_C1,
+    PROFILE_BENCH_FFT_CX,
+    PROFILE_BENCH_IRQ_C0,
+    PROFILE_BENCH_IRQ_C1,
+    PROFILE_BENCH_IRQ_CX,
+    PROFILE_BENCH_DRAW_C0,
+    PROFILE_BENCH_DRAW_C1,
+    PROFILE_COUNT
+} profile_id_t;
+
+typedef struct {
+    const char *name;
+    uint32_t calls;
+    uint32_t min;               // cycles, probe cost taken off
+    uint32_t max;
+    uint64_t total;             // for the average
+    uint32_t last;              // latest sample as read, probe cost included
+} profile_entry_t;
+
+/**
+ * @brief Enable the cycle counter and clear the table
+ * @note  Always built, the scheduler and the spectrum use the counter too.
+ */
+void profile_init(void);
+
+#if PROFILE_ENABLE
+
+#include "stm32h7xx_hal.h"
+
+extern uint32_t profile_start[PROFILE_COUNT];
+
+#define PROFILE_BEGIN(id)       (profile_start[(id)] = DWT->CYCCNT)
+#define PROFILE_END(id)         profile_record((id), DWT->CYCCNT - profile_start[(id)])
+#define PROFILE_NAME(id, name)  profile_set_name((id), (name))
+
+void profile_record(profile_id_t id, uint32_t cycles);
+void profile_set_name(profile_id_t id, const char *name);
+
+/**
+ * @brief Table entry, NULL for a bad id
+ */
+const profile_entry_t *profile_get(profile_id_t id);
+
+/**
+ * @brief Clear the table, the boot benchmark results stay
+ */
+void profile_reset(void);
+
+#else
+
+#define PROFILE_BEGIN(id)       ((void)0)
+#define PROFILE_END(id)         ((void)0)
+#define PROFILE_NAME(id, name)  ((void)0)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PROFILE_H */
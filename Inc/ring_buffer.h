@@ -0,0 +1,68 @@
+/**
+ ******************************************************************************
+ * @file      ring_buffer.h
+ * @brief     Lock-free single producer / single consumer byte ring buffer
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#ifndef __RING_BUFFER_H
+#define __RING_BUFFER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * @brief Ring buffer state
+ * @note  Only the producer writes head and only the consumer writes tail,
+ *        so one side may run in an interrupt without any locking. The
+ *        storage size must be a power of two.
+ */
+typedef struct {
+    uint8_t *buf;
+    uint16_t mask;              // size - 1
+    volatile uint16_t head;     // next write position (producer)
+    volatile uint16_t tail;     // next read position (consumer)
+    volatile uint32_t dropped;  // bytes lost because the buffer was full
+} ring_buffer_t;
+
+/**
+ * @brief Initialize a ring buffer on top of the given storage
+ * @param size Storage size in bytes, must be a power of two
+ * @return false if size is not a power of two
+ */
+bool ring_buffer_init(ring_buffer_t *rb, uint8_t *storage, uint16_t size);
+
+/**
+ * @brief Append bytes (producer side)
+ * @return Number of bytes stored, the rest is counted as dropped
+ */
+size_t ring_buffer_write(ring_buffer_t *rb, const uint8_t *data, size_t len);
+
+/**
+ * @brief Take one byte (consumer side)
+ * @return false if the buffer is empty
+ */
+bool ring_buffer_read_byte(ring_buffer_t *rb, uint8_t *byte);
+
+/**
+ * @brief Number of bytes waiting to be read
+ */
+size_t ring_buffer_count(const ring_buffer_t *rb);
+
+/**
+ * @brief Discard everything currently stored (consumer side)
+ */
+void ring_buffer_flush(ring_buffer_t *rb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __RING_BUFFER_H */
@@ -8,13 +8,20 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 
+// ---------------------------------------------------------------------------
+// Frequencies
+// ---------------------------------------------------------------------------
+#define SA818_RASTER_NARROW_HZ   12500u   // channel raster at 12.5 kHz bandwidth
+#define SA818_RASTER_WIDE_HZ     25000u   // channel raster at 25 kHz bandwidth
+
 // ---------------------------------------------------------------------------
 // Types
 // ---------------------------------------------------------------------------
 typedef enum {
     SA818_OK = 0,
     SA818_ERROR,
-    SA818_TIMEOUT
+    SA818_TIMEOUT,
+    SA818_ABORTED
 } sa818_status_t;
 
 typedef enum {
@@ -29,8 +36,8 @@ typedef enum {
 
 typedef struct {
     uint8_t bandwidth;
-    float tx_frequency;
-    float rx_frequency;
+    uint32_t tx_frequency;  // Hz
+    uint32_t rx_frequency;  // Hz
     char tx_subaudio[5];
     char rx_subaudio[5];
     uint8_t squelch;
@@ -46,15 +53,22 @@ typedef struct {
     sa818_power_t power;
 } sa818_settings_t;
 
+// Result of one scanned channel, rssi is 0 unless status is SA818_OK
+typedef void (*sa818_scan_cb_t)(uint32_t freq_hz, sa818_status_t status, uint8_t rssi, bool signal);
+
 
 sa818_status_t sa818_init(void);
 void sa818_task(void);  // periodic task for RSSI updates
 
 const sa818_settings_t* sa818_get_settings(void);
+bool sa818_settings_synced(void);  // true once the module has acknowledged every change
+uint16_t sa818_get_rssi_rate(void);    // RSSI samples per second over the last second
+uint16_t sa818_get_rssi_rtt_ms(void);  // average RSSI? round trip time
+uint32_t sa818_get_rssi_count(void);   // RSSI polls answered, to spot a fresh reading
 
 void sa818_set_bandwidth(uint8_t bw);
-void sa818_set_tx_frequency(float freq);
-void sa818_set_rx_frequency(float freq);
+void sa818_set_tx_frequency(uint32_t freq_hz);  // snapped to the channel raster
+void sa818_set_rx_frequency(uint32_t freq_hz);  // snapped to the channel raster
 void sa818_set_tx_subaudio(const char *code);
 void sa818_set_rx_subaudio(const char *code);
 void sa818_set_squelch(uint8_t sq);
@@ -66,6 +80,15 @@ void sa818_set_tail_tone(uint8_t value);
 void sa818_set_mode(sa818_mode_t mode);
 void sa818_set_power_level(sa818_power_t power);
 
+// Band scan: S+ tunes to the channel and reports the squelch, an RSSI? read
+// follows. Results come back through cb from sa818_task(), in order.
+sa818_status_t sa818_scan_channel(uint32_t freq_hz, sa818_scan_cb_t cb);  // SA818_TIMEOUT when full
+uint8_t sa818_scan_pending(void);    // channels queued or on the wire
+void sa818_scan_end(void);           // drop the rest and go back to the rx frequency
+
+uint32_t sa818_get_raster_hz(void);  // channel raster for the current bandwidth
+uint32_t sa818_snap_frequency(uint32_t freq_hz, uint32_t raster_hz);
+
 #ifdef __cplusplus
 }
 #endif
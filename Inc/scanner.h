@@ -0,0 +1,82 @@
+/**
+ ******************************************************************************
+ * @file      scanner.h
+ * @brief     Background band scan with the SA818, per channel RSSI statistics
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#ifndef __SCANNER_H
+#define __SCANNER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SCANNER_MAX_CHANNELS    256
+#define SCANNER_AHEAD           3     // channels queued at the SA818 at once
+#define SCANNER_RATE_WINDOW_MS  1000
+
+typedef struct {
+    uint8_t last;       // RSSI of the latest read
+    uint8_t max;        // highest RSSI since the scan started
+    uint16_t avg_q4;    // running average, RSSI * 16
+    uint16_t reads;     // successful reads
+    bool signal;        // S+ reported a carrier on the latest read
+} scanner_channel_t;
+
+void scanner_init(void);
+
+/**
+ * @brief Scan start_hz up to and including stop_hz in step_hz steps
+ * @note  Clears the statistics, more than SCANNER_MAX_CHANNELS are cut off
+ */
+void scanner_set_range(uint32_t start_hz, uint32_t stop_hz, uint32_t step_hz);
+
+/**
+ * @brief Scan a list of frequencies instead of a range
+ */
+void scanner_set_list(const uint32_t *freqs_hz, uint16_t count);
+
+/**
+ * @brief Start or stop walking the channels, stopping retunes the SA818
+ *        to its rx frequency
+ */
+void scanner_start(void);
+void scanner_stop(void);
+bool scanner_is_running(void);
+
+/**
+ * @brief Keeps the SA818 command queue topped up, run from the main loop
+ * @note  Only scans while receiving, a transmission pauses it.
+ */
+void scanner_task(void);
+
+uint16_t scanner_get_channel_count(void);
+uint32_t scanner_get_frequency(uint16_t index);
+const scanner_channel_t *scanner_get_channel(uint16_t index);
+
+/**
+ * @brief Channels read per second over the last full window
+ */
+uint16_t scanner_get_rate(void);
+
+/**
+ * @brief Completed passes over all channels
+ */
+uint32_t scanner_get_sweeps(void);
+
+/**
+ * @brief Incremented for every channel read, to spot new results
+ */
+uint32_t scanner_get_update_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SCANNER_H */
@@ -0,0 +1,91 @@
+/**
+ ******************************************************************************
+ * @file      scheduler.h
+ * @brief     Run-to-completion task scheduler, sleeps until a task is ready
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#ifndef __SCHEDULER_H
+#define __SCHEDULER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SCHEDULER_MAX_TASKS     12
+
+typedef enum {
+    SCHEDULER_EVENT_AUDIO = 0,  // ADC half buffer filled
+    SCHEDULER_EVENT_SA818,      // UART data in, transmit done or command queued
+    SCHEDULER_EVENT_LCD,        // SPI transfer done, room in the display queue
+    SCHEDULER_EVENT_DISPLAY,    // something on screen needs a redraw
+    SCHEDULER_EVENT_BEACON,     // beacon went on or off the air
+    SCHEDULER_EVENT_COUNT
+} scheduler_event_t;
+
+#define SCHEDULER_EVENT_MASK(event)     (1u << (event))
+
+typedef void (*scheduler_task_fn_t)(void);
+
+typedef struct {
+    const char *name;
+    uint32_t runs;
+    uint32_t max_latency_us;    // ready to started, worst seen
+} scheduler_task_stats_t;
+
+#ifdef SCHEDULER_HOST
+// Host build: time only moves when the test moves it
+uint32_t scheduler_host_get_ms(void);
+uint32_t scheduler_host_get_us(void);
+void scheduler_host_idle(void);
+#endif
+
+/**
+ * @brief Start with an empty task list, call after profile_init()
+ */
+void scheduler_init(void);
+
+/**
+ * @brief Register a task, tasks added first run first within a pass
+ * @param period_ms Run every period, 0 for event driven only
+ * @param events    SCHEDULER_EVENT_MASK() of the events that wake the task
+ * @return Task index, -1 when the table is full
+ */
+int8_t scheduler_add(const char *name, scheduler_task_fn_t fn,
+                     uint32_t period_ms, uint32_t events);
+
+/**
+ * @brief Wake the tasks waiting for an event, safe from any interrupt
+ */
+void scheduler_post(scheduler_event_t event);
+
+/**
+ * @brief One pass: collect events and due periods, run every ready task once
+ * @return true if a task ran
+ */
+bool scheduler_run_once(void);
+
+/**
+ * @brief Run passes forever, with the core in WFI whenever nothing is ready
+ */
+void scheduler_run(void);
+
+uint8_t scheduler_get_task_count(void);
+
+/**
+ * @brief Run count and worst latency of a task, NULL for a bad index
+ */
+const scheduler_task_stats_t *scheduler_get_stats(uint8_t task);
+
+void scheduler_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SCHEDULER_H */
@@ -0,0 +1,72 @@
+/**
+ ******************************************************************************
+ * @file      signal_meter.h
+ * @brief     Signal strength from the received audio, fused with the SA818 RSSI
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#ifndef __SIGNAL_METER_H
+#define __SIGNAL_METER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define SIGNAL_METER_SEGMENT          64      // samples per estimate, 125 Hz at 8 kHz
+
+// Estimates, not measured against a signal generator yet. Until they are,
+// the level is relative: set the offset on the bench with
+// signal_meter_set_offset_db10() against a known carrier.
+#define SIGNAL_METER_RSSI_OFFSET_DBM  (-135)  // dBm at RSSI=0, about 1 dB per step
+#define SIGNAL_METER_FLOOR_DBM        (-125)  // level where the audio is only noise
+#define SIGNAL_METER_OFFSET_MAX_DB10  300     // calibration offset either way
+
+typedef struct {
+    uint16_t rms;            // audio RMS, ADC counts
+    uint16_t peak;           // peak envelope, fast attack and slow release
+    uint32_t noise_power;    // power of the sample to sample difference
+    uint32_t noise_ref;      // noise_power with no carrier, slow peak hold
+    int16_t quieting_db10;   // noise_ref over noise_power, tenths of dB
+    int16_t level_db10;      // fused signal level at the antenna, tenths of dB(m)
+} signal_meter_t;
+
+/**
+ * @brief Subscribe to the audio blocks, call after audio_init()
+ * @note  FM noise sits at the top of the audio band and drops as the
+ *        carrier gets stronger, well before the RSSI moves. This only works
+ *        with the squelch open, a closed squelch mutes the noise.
+ */
+void signal_meter_init(void);
+
+/**
+ * @brief Latest estimates, updated every SIGNAL_METER_SEGMENT samples
+ */
+const signal_meter_t *signal_meter_get(void);
+
+/**
+ * @brief Fused signal level in tenths of dB, dBm once the offset is calibrated
+ */
+int16_t signal_meter_get_level_db10(void);
+
+/**
+ * @brief Calibration offset added to the fused level, tenths of dB
+ * @note  Clamped to +-SIGNAL_METER_OFFSET_MAX_DB10. Not stored, it starts
+ *        at 0 after a reset. The level follows within a few estimates.
+ */
+void signal_meter_set_offset_db10(int16_t offset_db10);
+int16_t signal_meter_get_offset_db10(void);
+
+/**
+ * @brief Number of estimates made so far, to see the update rate
+ */
+uint32_t signal_meter_get_updates(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIGNAL_METER_H */
@@ -0,0 +1,54 @@
+/**
+ ******************************************************************************
+ * @file      spectrum.h
+ * @brief     Fixed point FFT of the received audio, one display row per frame
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#ifndef __SPECTRUM_H
+#define __SPECTRUM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SPECTRUM_FFT_LEN        512   // real samples, 15.6 Hz bins at 8 kHz
+#define SPECTRUM_HOP            384   // 3 audio blocks between rows, 20.8 rows/s
+#define SPECTRUM_WIDTH          160   // one level per panel column, 0..4 kHz
+#define SPECTRUM_RANGE_DB       50    // from the noise floor to full brightness
+
+/**
+ * @brief Subscribe to the audio blocks, call after audio_init()
+ */
+void spectrum_init(void);
+
+/**
+ * @brief Run the FFT or not, only worth it while the waterfall is shown
+ */
+void spectrum_enable(bool enable);
+
+/**
+ * @brief Latest row, SPECTRUM_WIDTH levels from 0 (floor) to 255
+ */
+const uint8_t *spectrum_get_row(void);
+
+/**
+ * @brief Incremented for every new row, to spot new ones
+ */
+uint32_t spectrum_get_row_count(void);
+
+/**
+ * @brief CPU cycles the last row took: window, FFT, log and binning
+ */
+uint32_t spectrum_get_cycles(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SPECTRUM_H */
@@ -0,0 +1,49 @@
+/**
+ ******************************************************************************
+ * @file      system_load.h
+ * @brief     CPU load from the time the core spends asleep in WFI
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#ifndef __SYSTEM_LOAD_H
+#define __SYSTEM_LOAD_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define SYSTEM_LOAD_WINDOW_MS   1000
+#define SYSTEM_LOAD_AVG_SHIFT   2       // a new window weighs in for 1/4
+
+/**
+ * @brief WFI, counting the time until the core wakes as idle
+ * @note  Call with interrupts masked, the waking interrupt runs once they
+ *        are unmasked again and counts as active.
+ */
+void system_load_sleep(void);
+
+/**
+ * @brief Close the measuring window every SYSTEM_LOAD_WINDOW_MS ticks,
+ *        call from SysTick_Handler()
+ */
+void system_load_tick(void);
+
+/**
+ * @brief Averaged share of the time the core was not asleep, percent
+ */
+uint8_t system_cpu_load_percent(void);
+
+/**
+ * @brief Load over the last window only, percent
+ */
+uint8_t system_cpu_load_last_percent(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SYSTEM_LOAD_H */
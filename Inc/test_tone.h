@@ -4,19 +4,29 @@
 #include <stdbool.h>
 #include "stm32h7xx_hal.h"
 
-// Default tone frequency (in Hz)
-#define TESTTONE_FREQUENCY_HZ  500.0f
+// Default tone frequency (in Hz) and level (percent of DAC full scale)
+#define TESTTONE_FREQUENCY_HZ       500
+#define TESTTONE_AMPLITUDE_PERCENT  50
 
-// Initialize the PA5 pin as output
+// Initialize the DAC output on PA5, parked at mid scale
 void testtone_init(void);
 
-// Enable or disable the tone generator
+// Enable or disable the tone generator, runs on DMA without CPU time
 void testtone_enable(bool enable);
 
 // Check if tone is active
 bool testtone_is_enabled(void);
 
-// Periodic task to be called from main loop
-void testtone_task(void);
+// Key the running tone on and off (on by default). Only rewrites the
+// table the DMA plays, no HAL calls, so it is safe from any interrupt.
+// Keyed up the output holds mid scale.
+void testtone_key(bool on);
+
+// Change the tone frequency, also while it plays (57 Hz .. several kHz)
+void testtone_set_frequency(uint32_t frequency_hz);
+uint32_t testtone_get_frequency(void);
+
+// Change the tone level, 0..100 % of the DAC range
+void testtone_set_amplitude(uint8_t percent);
 
 #endif // TESTTONE_H
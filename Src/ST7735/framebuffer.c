@@ -0,0 +1,213 @@
+/**
+ ******************************************************************************
+ * @file      framebuffer.c
+ * @brief     RGB565 framebuffer for the ST7735 with dirty rectangle tracking
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include <string.h>
+
+#include "main.h"
+#include "framebuffer.h"
+
+// ---------------------------------------------------------------------------
+// Internal state
+// ---------------------------------------------------------------------------
+
+// Stored in panel byte order so areas can be streamed without conversion.
+// Kept cacheable for drawing speed, lcd_flush_async() cleans the rows it
+// hands to the DMA. Rows are whole cache lines.
+static uint16_t framebuffer[FRAMEBUFFER_HEIGHT][FRAMEBUFFER_WIDTH] __attribute__((aligned(32)));
+
+static framebuffer_rect_t dirty_rects[FRAMEBUFFER_MAX_DIRTY];
+static uint8_t dirty_count = 0;
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+
+static inline uint16_t framebuffer_swap(uint16_t color)
+{
+    return (uint16_t)((color << 8) | (color >> 8));
+}
+
+// Clips a rectangle to the frame, returns false if nothing is left
+static bool framebuffer_clip(int32_t *x, int32_t *y, int32_t *w, int32_t *h)
+{
+    if (*x < 0) { *w += *x; *x = 0; }
+    if (*y < 0) { *h += *y; *y = 0; }
+    if (*x + *w > FRAMEBUFFER_WIDTH)  *w = FRAMEBUFFER_WIDTH - *x;
+    if (*y + *h > FRAMEBUFFER_HEIGHT) *h = FRAMEBUFFER_HEIGHT - *y;
+    return *w > 0 && *h > 0;
+}
+
+static uint32_t framebuffer_rect_area(const framebuffer_rect_t *r)
+{
+    return (uint32_t)r->w * r->h;
+}
+
+static framebuffer_rect_t framebuffer_rect_union(const framebuffer_rect_t *a, const framebuffer_rect_t *b)
+{
+    framebuffer_rect_t u;
+    uint16_t x1 = (a->x + a->w > b->x + b->w) ? a->x + a->w : b->x + b->w;
+    uint16_t y1 = (a->y + a->h > b->y + b->h) ? a->y + a->h : b->y + b->h;
+    u.x = (a->x < b->x) ? a->x : b->x;
+    u.y = (a->y < b->y) ? a->y : b->y;
+    u.w = x1 - u.x;
+    u.h = y1 - u.y;
+    return u;
+}
+
+// True if the rectangles overlap or share an edge
+static bool framebuffer_rect_touches(const framebuffer_rect_t *a, const framebuffer_rect_t *b)
+{
+    return a->x <= b->x + b->w && b->x <= a->x + a->w &&
+           a->y <= b->y + b->h && b->y <= a->y + a->h;
+}
+
+static void framebuffer_remove_dirty(uint8_t index)
+{
+    dirty_rects[index] = dirty_rects[--dirty_count];
+}
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+
+void framebuffer_init(void)
+{
+    memset(framebuffer, 0, sizeof(framebuffer));
+    dirty_count = 0;
+}
+
+void framebuffer_clear(uint16_t color)
+{
+    framebuffer_fill_rect(0, 0, FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT, color);
+}
+
+ITCM_TEXT void framebuffer_fill_rect(int32_t x, int32_t y, int32_t w, int32_t h, uint16_t color)
+{
+    if (!framebuffer_clip(&x, &y, &w, &h))
+        return;
+
+    uint16_t c = framebuffer_swap(color);
+
+    // Fill the first row, copy it to the others
+    for (int32_t i = 0; i < w; i++)
+        framebuffer[y][x + i] = c;
+    for (int32_t j = 1; j < h; j++)
+        memcpy(&framebuffer[y + j][x], &framebuffer[y][x], (size_t)w * sizeof(uint16_t));
+
+    framebuffer_mark_dirty(x, y, w, h);
+}
+
+void framebuffer_set_pixel(int32_t x, int32_t y, uint16_t color)
+{
+    if (x < 0 || y < 0 || x >= FRAMEBUFFER_WIDTH || y >= FRAMEBUFFER_HEIGHT)
+        return;
+
+    framebuffer[y][x] = framebuffer_swap(color);
+    framebuffer_mark_dirty(x, y, 1, 1);
+}
+
+void framebuffer_draw_mono(int32_t x, int32_t y, const uint8_t *bits, uint8_t w, uint8_t h,
+                           uint8_t bytes_per_col, uint16_t fg, uint16_t bg, bool transparent)
+{
+    uint16_t fg_swapped = framebuffer_swap(fg);
+    uint16_t bg_swapped = framebuffer_swap(bg);
+
+    for (int32_t col = 0; col < w; col++) {
+        int32_t px = x + col;
+        const uint8_t *column = bits + col * bytes_per_col;
+
+        if (px < 0 || px >= FRAMEBUFFER_WIDTH)
+            continue;
+
+        for (int32_t row = 0; row < h; row++) {
+            int32_t py = y + row;
+            bool set = (column[row >> 3] & (0x80 >> (row & 7))) != 0;
+
+            if (py < 0 || py >= FRAMEBUFFER_HEIGHT)
+                continue;
+
+            if (set)
+                framebuffer[py][px] = fg_swapped;
+            else if (!transparent)
+                framebuffer[py][px] = bg_swapped;
+        }
+    }
+
+    int32_t cw = w, ch = h;
+    if (framebuffer_clip(&x, &y, &cw, &ch))
+        framebuffer_mark_dirty(x, y, cw, ch);
+}
+
+ITCM_TEXT void framebuffer_blit(int32_t x, int32_t y, const uint16_t *pixels, int32_t w, int32_t h)
+{
+    int32_t cx = x, cy = y, cw = w, ch = h;
+
+    if (!framebuffer_clip(&cx, &cy, &cw, &ch))
+        return;
+
+    // Skip the clipped part of the source as well
+    pixels += (cy - y) * w + (cx - x);
+    for (int32_t row = 0; row < ch; row++)
+        memcpy(&framebuffer[cy + row][cx], pixels + row * w, (size_t)cw * sizeof(uint16_t));
+}
+
+void framebuffer_mark_dirty(int32_t x, int32_t y, int32_t w, int32_t h)
+{
+    if (!framebuffer_clip(&x, &y, &w, &h))
+        return;
+
+    framebuffer_rect_t r = { (uint16_t)x, (uint16_t)y, (uint16_t)w, (uint16_t)h };
+
+    // Grow into touching areas, repeat because a grown area may now
+    // reach others as well
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (uint8_t i = 0; i < dirty_count; i++) {
+            if (framebuffer_rect_touches(&r, &dirty_rects[i])) {
+                r = framebuffer_rect_union(&r, &dirty_rects[i]);
+                framebuffer_remove_dirty(i);
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    if (dirty_count < FRAMEBUFFER_MAX_DIRTY) {
+        dirty_rects[dirty_count++] = r;
+        return;
+    }
+
+    // List full, merge with the area that grows the least
+    uint8_t best = 0;
+    uint32_t best_growth = UINT32_MAX;
+    for (uint8_t i = 0; i < dirty_count; i++) {
+        framebuffer_rect_t u = framebuffer_rect_union(&r, &dirty_rects[i]);
+        uint32_t growth = framebuffer_rect_area(&u) - framebuffer_rect_area(&dirty_rects[i]);
+        if (growth < best_growth) {
+            best_growth = growth;
+            best = i;
+        }
+    }
+    dirty_rects[best] = framebuffer_rect_union(&r, &dirty_rects[best]);
+}
+
+bool framebuffer_take_dirty(framebuffer_rect_t *rect)
+{
+    if (dirty_count == 0)
+        return false;
+
+    *rect = dirty_rects[--dirty_count];
+    return true;
+}
+
+const uint16_t *framebuffer_get_pixels(uint16_t x, uint16_t y)
+{
+    return &framebuffer[y][x];
+}
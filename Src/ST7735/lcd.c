@@ -1,4 +1,5 @@
 #include "stm32h7xx_hal.h"
+#include "main.h"
 
 #include "lcd_brightness_timer.h"
 #include "spi.h"
@@ -6,6 +7,7 @@
 
 #include "font.h"
 #include "lcd.h"
+#include "framebuffer.h"
 
 #include "board.h"
 
@@ -39,6 +41,13 @@ ST7735_IO_t st7735_pIO = {
 ST7735_Object_t st7735_pObj;
 uint32_t st7735_id;
 
+// Bus writes go through the SPI DMA queue instead of blocking
+static bool lcd_async_io = false;
+
+// Worst case queue entries for one window write: CASET, RASET, RAMWR,
+// pixels and the full screen window restore, each register with its data
+#define LCD_FLUSH_XFERS_PER_RECT   (10)
+
 void lcd_init(void) {
   lcd_brightness_timer_init();
   lcd_brightness_timer_start();
@@ -74,12 +83,44 @@ void lcd_show_bootlogo(void)
 	lcd_light(0, 300);
 
 	ST7735_LCD_Driver.FillRect(&st7735_pObj, 0, 0, ST7735Ctx.Width,ST7735Ctx.Height, BLACK);
+	framebuffer_init();  // panel is black, matches the cleared framebuffer
 
 	lcd_light(100, 200);
 }
 
 void lcd_clear(void) {
-  ST7735_LCD_Driver.FillRect(&st7735_pObj, 0, 0, ST7735Ctx.Width,ST7735Ctx.Height, BLACK);
+  framebuffer_clear(BLACK);
+}
+
+// Sends every area changed since the last flush, one window write each
+void lcd_flush(void) {
+  framebuffer_rect_t rect;
+
+  while (framebuffer_take_dirty(&rect)) {
+    ST7735_FillRGBWindow(&st7735_pObj, rect.x, rect.y,
+                         (uint8_t *)framebuffer_get_pixels(rect.x, rect.y),
+                         rect.w, rect.h, FRAMEBUFFER_WIDTH * sizeof(uint16_t));
+  }
+}
+
+// Queues the changed areas for DMA and returns right away. Areas are
+// widened to whole rows so the pixels are one contiguous transfer straight
+// from the framebuffer. What does not fit in the queue stays dirty for the
+// next call, so call this every pass of the main loop.
+void lcd_flush_async(void) {
+  framebuffer_rect_t rect;
+
+  lcd_async_io = true;
+  while (display_spi_queue_free() >= LCD_FLUSH_XFERS_PER_RECT &&
+         framebuffer_take_dirty(&rect)) {
+    // Write the rows back from the D-cache before the DMA reads them
+    SCB_CleanDCache_by_Addr((uint32_t *)framebuffer_get_pixels(0, rect.y),
+                            (int32_t)(rect.h * FRAMEBUFFER_WIDTH * sizeof(uint16_t)));
+    ST7735_FillRGBWindow(&st7735_pObj, 0, rect.y,
+                         (uint8_t *)framebuffer_get_pixels(0, rect.y),
+                         FRAMEBUFFER_WIDTH, rect.h, FRAMEBUFFER_WIDTH * sizeof(uint16_t));
+  }
+  lcd_async_io = false;
 }
 
 void lcd_set_brightness(uint32_t brightness) {
@@ -102,19 +143,26 @@ uint32_t lcd_get_height(void) {
 void lcd_draw_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color)
 {
     // Top line
-    ST7735_LCD_Driver.FillRect(&st7735_pObj, x, y, w, 1, color);
+    framebuffer_fill_rect(x, y, w, 1, color);
     // Bottom line
-    ST7735_LCD_Driver.FillRect(&st7735_pObj, x, y + h - 1, w, 1, color);
+    framebuffer_fill_rect(x, y + h - 1, w, 1, color);
     // Left line
-    ST7735_LCD_Driver.FillRect(&st7735_pObj, x, y, 1, h, color);
+    framebuffer_fill_rect(x, y, 1, h, color);
     // Right line
-    ST7735_LCD_Driver.FillRect(&st7735_pObj, x + w - 1, y, 1, h, color);
+    framebuffer_fill_rect(x + w - 1, y, 1, h, color);
 }
 
 // Filled rectangle
 void lcd_draw_filled_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color)
 {
-    ST7735_LCD_Driver.FillRect(&st7735_pObj, x, y, w, h, color);
+    framebuffer_fill_rect(x, y, w, h, color);
+}
+
+// Block of pixels in panel byte order, see LCD_PANEL_COLOR()
+void lcd_draw_pixels(uint16_t x, uint16_t y, const uint16_t *pixels, uint16_t w, uint16_t h)
+{
+    framebuffer_blit(x, y, pixels, w, h);
+    framebuffer_mark_dirty(x, y, w, h);
 }
 
 void lcd_light(uint32_t Brightness_Dis,uint32_t time) {
@@ -159,97 +207,92 @@ void lcd_light(uint32_t Brightness_Dis,uint32_t time) {
 uint16_t POINT_COLOR=0xFFFF;
 uint16_t BACK_COLOR=BLACK;
 
-void lcd_show_char(uint16_t x,uint16_t y,uint8_t num,uint8_t size,uint8_t mode)
-{  							  
-  uint8_t temp,t1,t;
-	uint16_t y0=y;
-	uint16_t x0=x;
-	uint16_t colortemp=POINT_COLOR; 
-  uint32_t h,w;
-	
-	uint16_t write[size][size==12?6:8];
-	uint16_t count;
-	
-  ST7735_GetXSize(&st7735_pObj,&w);
-	ST7735_GetYSize(&st7735_pObj,&h);
+// Expanded glyphs, ready to copy into the framebuffer. Direct mapped on
+// character, font and colors: the UI uses only a few color pairs, so a
+// collision just expands the glyph again.
+#define LCD_GLYPH_CACHE_SLOTS   64    // power of two
+#define LCD_GLYPH_MAX_PIXELS    (8 * 16)
 
-	num=num-' ';
-	count = 0;
-	
-	if(!mode)
-	{
-		for(t=0;t<size;t++)
-		{   
-			if(size==12)temp=asc2_1206[num][t];
-			else temp=asc2_1608[num][t];
-			
-			for(t1=0;t1<8;t1++)
-			{			    
-				if(temp&0x80)
-					POINT_COLOR=(colortemp&0xFF)<<8|colortemp>>8;
-				else 
-					POINT_COLOR=(BACK_COLOR&0xFF)<<8|BACK_COLOR>>8;
-				
-				write[count][t/2]=POINT_COLOR;
-				count ++;
-				if(count >= size) count =0;
-				
-				temp<<=1;
-				y++;
-				if(y>=h){POINT_COLOR=colortemp;return;}
-				if((y-y0)==size)
-				{
-					y=y0;
-					x++;
-					if(x>=w){POINT_COLOR=colortemp;return;}
-					break;
-				}
-			}
+typedef struct {
+	uint16_t fg;
+	uint16_t bg;
+	uint8_t num;
+	uint8_t size;   // 0 = empty slot
+	uint16_t pixels[LCD_GLYPH_MAX_PIXELS];  // row-major, panel byte order
+} lcd_glyph_t;
+
+DTCM_BSS static lcd_glyph_t lcd_glyph_cache[LCD_GLYPH_CACHE_SLOTS];
+
+// Returns the size/2 x size pixels of a printable character, size is 12 or 16
+ITCM_TEXT static const uint16_t *lcd_get_glyph(uint8_t num, uint8_t size, uint16_t fg, uint16_t bg)
+{
+	uint32_t slot = (num + size * 7u + fg * 31u + bg * 17u) & (LCD_GLYPH_CACHE_SLOTS - 1);
+	lcd_glyph_t *glyph = &lcd_glyph_cache[slot];
+
+	if((glyph->size == size) && (glyph->num == num) && (glyph->fg == fg) && (glyph->bg == bg))
+		return glyph->pixels;
+
+	// Font data is column-major, 2 bytes per column, MSB is the top pixel
+	const uint8_t *bits = (size == 12) ? asc2_1206[num - ' '] : asc2_1608[num - ' '];
+	uint8_t w = size / 2;
+	uint16_t fg_swapped = (uint16_t)((fg << 8) | (fg >> 8));
+	uint16_t bg_swapped = (uint16_t)((bg << 8) | (bg >> 8));
+
+	for(uint8_t col = 0; col < w; col++) {
+		for(uint8_t row = 0; row < size; row++) {
+			bool set = (bits[col * 2 + (row >> 3)] & (0x80 >> (row & 7))) != 0;
+			glyph->pixels[row * w + col] = set ? fg_swapped : bg_swapped;
 		}
 	}
-	else
-	{
-		for(t=0;t<size;t++)
-		{   
-			if(size==12)temp=asc2_1206[num][t];
-			else temp=asc2_1608[num][t];
-			for(t1=0;t1<8;t1++)
-			{			    
-				if(temp&0x80)
-					write[count][t/2]=(POINT_COLOR&0xFF)<<8|POINT_COLOR>>8;
-				count ++;
-				if(count >= size) count =0;
-				
-				temp<<=1;
-				y++;
-				if(y>=h){POINT_COLOR=colortemp;return;}
-				if((y-y0)==size)
-				{
-					y=y0;
-					x++;
-					if(x>=w){POINT_COLOR=colortemp;return;}
-					break;
-				}
-			}  	 
-		}     
+
+	glyph->fg = fg;
+	glyph->bg = bg;
+	glyph->num = num;
+	glyph->size = size;
+	return glyph->pixels;
+}
+
+void lcd_show_char(uint16_t x,uint16_t y,uint8_t num,uint8_t size,uint8_t mode)
+{
+	if((num < ' ') || (num > '~'))
+		return;
+
+	if(size != 12)
+		size = 16;
+
+	if(mode) {
+		// Keep the background, only the set bits are drawn
+		const uint8_t *glyph = (size == 12) ? asc2_1206[num - ' '] : asc2_1608[num - ' '];
+		framebuffer_draw_mono(x, y, glyph, size / 2, size, 2, POINT_COLOR, BACK_COLOR, true);
+		return;
 	}
-	ST7735_FillRGBRect(&st7735_pObj,x0,y0,(uint8_t *)&write,size==12?6:8,size); 
-	POINT_COLOR=colortemp;	    	   	 	  
-}   
 
+	framebuffer_blit(x, y, lcd_get_glyph(num, size, POINT_COLOR, BACK_COLOR), size / 2, size);
+	framebuffer_mark_dirty(x, y, size / 2, size);
+}
+
+// Copies cached glyphs straight into the framebuffer and marks each line of
+// text as one dirty area, so it goes out as a single window write
 void lcd_show_string(uint16_t x,uint16_t y,uint16_t width,uint16_t height,uint8_t size,uint8_t *p)
 {         
 	uint8_t x0=x;
+	uint16_t run_x=x;
 	width+=x;
 	height+=y;
+	if(size != 12)
+		size = 16;
     while((*p<='~')&&(*p>=' '))
     {       
-        if(x>=width){x=x0;y+=size;}
+        if(x>=width){
+            framebuffer_mark_dirty(run_x, y, x - run_x, size);
+            x=x0;run_x=x;y+=size;
+        }
         if(y>=height)break;
-        lcd_show_char(x,y,*p,size,0);
+        framebuffer_blit(x, y, lcd_get_glyph(*p, size, POINT_COLOR, BACK_COLOR), size / 2, size);
         x+=size/2;
         p++;
     }  
+    framebuffer_mark_dirty(run_x, y, x - run_x, size);
 }
 
 static int32_t lcd_gettick(void)
@@ -260,6 +303,13 @@ static int32_t lcd_gettick(void)
 static int32_t lcd_writereg(uint8_t reg,uint8_t* pdata,uint32_t length)
 {
 	int32_t result;
+	if(lcd_async_io){
+		if(!display_spi_queue_transfer(true, &reg, 1) ||
+		   !display_spi_queue_transfer(false, pdata, length))
+			return -1;
+		return 0;
+	}
+	display_spi_wait_idle();
 	LCD_CS_RESET;
 	LCD_RS_RESET;
 	result = display_spi_transmit(&reg, 1, 100);
@@ -277,6 +327,7 @@ static int32_t lcd_writereg(uint8_t reg,uint8_t* pdata,uint32_t length)
 static int32_t lcd_readreg(uint8_t reg,uint8_t* pdata)
 {
 	int32_t result;
+	display_spi_wait_idle();
 	LCD_CS_RESET;
 	LCD_RS_RESET;
 	
@@ -294,6 +345,12 @@ static int32_t lcd_readreg(uint8_t reg,uint8_t* pdata)
 static int32_t lcd_senddata(uint8_t* pdata,uint32_t length)
 {
 	int32_t result;
+	if(lcd_async_io){
+		if(!display_spi_queue_transfer(false, pdata, length))
+			return -1;
+		return 0;
+	}
+	display_spi_wait_idle();
 	LCD_CS_RESET;
 	//LCD_RS_SET;
 	result =display_spi_transmit(pdata, length, 100);
@@ -308,6 +365,7 @@ static int32_t lcd_senddata(uint8_t* pdata,uint32_t length)
 static int32_t lcd_recvdata(uint8_t* pdata,uint32_t length)
 {
 	int32_t result;
+	display_spi_wait_idle();
 	LCD_CS_RESET;
 	//LCD_RS_SET;
 	result = display_spi_receive(pdata, length, 500);
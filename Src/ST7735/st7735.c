@@ -80,6 +80,7 @@ ST7735_Ctx_t ST7735Ctx;
   * @{
   */
 static int32_t ST7735_SetDisplayWindow(ST7735_Object_t *pObj, uint32_t Xpos, uint32_t Ypos, uint32_t Width, uint32_t Height);
+static int32_t ST7735_FillWindow(ST7735_Object_t *pObj, uint32_t Xpos, uint32_t Ypos, uint32_t Width, uint32_t Height, uint32_t Color);
 static int32_t ST7735_ReadRegWrap(void *Handle, uint8_t Reg, uint8_t* pData);
 static int32_t ST7735_WriteRegWrap(void *Handle, uint8_t Reg, uint8_t *pData, uint32_t Length);
 static int32_t ST7735_SendDataWrap(void *Handle, uint8_t *pData, uint32_t Length);
@@ -737,40 +738,60 @@ int32_t ST7735_FillRGBRect(ST7735_Object_t *pObj, uint32_t Xpos, uint32_t Ypos,
 }
 
 /**
-  * @brief  Draw Horizontal line.
+  * @brief  Draws a full RGB rectangle through one address window and one
+  *         memory write, rows may be part of a larger image.
   * @param  pObj Component object
   * @param  Xpos   specifies the X position.
   * @param  Ypos   specifies the Y position.
-  * @param  Length specifies the Line length.
-  * @param  Color  Specifies the RGB color in RGB565 format
+  * @param  pData  pointer to RGB data, already in panel byte order
+  * @param  Width  specifies the rectangle width.
+  * @param  Height Specifies the rectangle height
+  * @param  Stride distance in bytes between the start of two rows in pData
   * @retval The component status
   */
-int32_t ST7735_DrawHLine(ST7735_Object_t *pObj, uint32_t Xpos, uint32_t Ypos, uint32_t Length, uint32_t Color)
+int32_t ST7735_FillRGBWindow(ST7735_Object_t *pObj, uint32_t Xpos, uint32_t Ypos, uint8_t *pData, uint32_t Width, uint32_t Height, uint32_t Stride)
 {
   int32_t ret = ST7735_OK;
-  uint32_t i;
-  static uint8_t pdata[640];
-	
-  if((Xpos + Length) > ST7735Ctx.Width)
+  uint8_t tmp = 0U;
+  uint32_t j;
+
+  if((Width == 0U) || (Height == 0U) || ((Xpos + Width) > ST7735Ctx.Width) || ((Ypos + Height) > ST7735Ctx.Height))
   {
     ret = ST7735_ERROR;
-  }/* Set Cursor */
-  else if(ST7735_SetCursor(pObj, Xpos, Ypos) != ST7735_OK)
+  }
+  else if(ST7735_SetDisplayWindow(pObj, Xpos, Ypos, Width, Height) != ST7735_OK)
+  {
+    ret = ST7735_ERROR;
+  }
+  else if(st7735_write_reg(&pObj->Ctx, ST7735_WRITE_RAM, &tmp, 0) != ST7735_OK)
   {
     ret = ST7735_ERROR;
   }
   else
   {
-    for(i = 0; i < Length; i++)
+    if(Stride == (2U*Width))
     {
-      /* Exchange LSB and MSB to fit LCD specification */
-      pdata[2U*i] = (uint8_t)(Color >> 8);
-      pdata[(2U*i) + 1U] = (uint8_t)(Color);
-			
-//      pdata[(2U*i) + 1U] = (uint8_t)(Color >> 8);
-//      pdata[2U*i] = (uint8_t)(Color);			
+      /* Rows are contiguous, send all at once */
+      if(st7735_send_data(&pObj->Ctx, pData, 2U*Width*Height) != ST7735_OK)
+      {
+        ret = ST7735_ERROR;
+      }
     }
-    if(st7735_send_data(&pObj->Ctx, (uint8_t*)&pdata[0], 2U*Length) != ST7735_OK)
+    else
+    {
+      /* The window wraps rows, only the data has to be split */
+      for(j = 0; j < Height; j++)
+      {
+        if(st7735_send_data(&pObj->Ctx, pData + (j*Stride), 2U*Width) != ST7735_OK)
+        {
+          ret = ST7735_ERROR;
+          break;
+        }
+      }
+    }
+
+    /* Restore the full screen window, SetCursor only sets the start */
+    if(ST7735_SetDisplayWindow(pObj, 0U, 0U, ST7735Ctx.Width, ST7735Ctx.Height) != ST7735_OK)
     {
       ret = ST7735_ERROR;
     }
@@ -779,6 +800,31 @@ int32_t ST7735_DrawHLine(ST7735_Object_t *pObj, uint32_t Xpos, uint32_t Ypos, ui
   return ret;
 }
 
+/**
+  * @brief  Draw Horizontal line.
+  * @param  pObj Component object
+  * @param  Xpos   specifies the X position.
+  * @param  Ypos   specifies the Y position.
+  * @param  Length specifies the Line length.
+  * @param  Color  Specifies the RGB color in RGB565 format
+  * @retval The component status
+  */
+int32_t ST7735_DrawHLine(ST7735_Object_t *pObj, uint32_t Xpos, uint32_t Ypos, uint32_t Length, uint32_t Color)
+{
+  int32_t ret = ST7735_OK;
+
+  if(((Xpos + Length) > ST7735Ctx.Width) || (Ypos >= ST7735Ctx.Height))
+  {
+    ret = ST7735_ERROR;
+  }
+  else if(ST7735_FillWindow(pObj, Xpos, Ypos, Length, 1U, Color) != ST7735_OK)
+  {
+    ret = ST7735_ERROR;
+  }
+
+  return ret;
+}
+
 /**
   * @brief  Draw vertical line.
   * @param  pObj Component object
@@ -791,22 +837,14 @@ int32_t ST7735_DrawHLine(ST7735_Object_t *pObj, uint32_t Xpos, uint32_t Ypos, ui
 int32_t ST7735_DrawVLine(ST7735_Object_t *pObj, uint32_t Xpos, uint32_t Ypos, uint32_t Length, uint32_t Color)
 {
   int32_t ret = ST7735_OK;
-  uint32_t counter;
 
-  if((Ypos + Length) > ST7735Ctx.Height)
+  if(((Ypos + Length) > ST7735Ctx.Height) || (Xpos >= ST7735Ctx.Width))
   {
     ret = ST7735_ERROR;
-  }
-  else
+  }/* A one pixel wide window, the panel steps down the column */
+  else if(ST7735_FillWindow(pObj, Xpos, Ypos, 1U, Length, Color) != ST7735_OK)
   {
-    for(counter = 0; counter < Length; counter++)
-    {
-      if(ST7735_SetPixel(pObj, Xpos, Ypos + counter, Color) != ST7735_OK)
-      {
-        ret = ST7735_ERROR;
-        break;
-      }
-    }
+    ret = ST7735_ERROR;
   }
 
   return ret;
@@ -825,16 +863,14 @@ int32_t ST7735_DrawVLine(ST7735_Object_t *pObj, uint32_t Xpos, uint32_t Ypos, ui
 int32_t ST7735_FillRect(ST7735_Object_t *pObj, uint32_t Xpos, uint32_t Ypos, uint32_t Width, uint32_t Height, uint32_t Color)
 {
   int32_t ret = ST7735_OK;
-  uint32_t i, y_pos = Ypos;
 
-  for(i = 0; i < Height; i++)
+  if(((Xpos + Width) > ST7735Ctx.Width) || ((Ypos + Height) > ST7735Ctx.Height))
   {
-    if(ST7735_DrawHLine(pObj, Xpos, y_pos, Width, Color) != ST7735_OK)
-    {
-      ret = ST7735_ERROR;
-      break;
-    }
-    y_pos++;
+    ret = ST7735_ERROR;
+  }
+  else if(ST7735_FillWindow(pObj, Xpos, Ypos, Width, Height, Color) != ST7735_OK)
+  {
+    ret = ST7735_ERROR;
   }
 
   return ret;
@@ -951,6 +987,68 @@ int32_t ST7735_GetYSize(ST7735_Object_t *pObj, uint32_t *YSize)
 /** @defgroup ST7735_Private_Functions  Private Functions
   * @{
   */
+/**
+  * @brief  Fill a window with one color in a single RAMWR burst.
+  * @param  pObj   Component object
+  * @param  Xpos   specifies the X position.
+  * @param  Ypos   specifies the Y position.
+  * @param  Width  window width.
+  * @param  Height window height.
+  * @param  Color  the RGB pixel color in RGB565 format
+  * @retval Component status
+  */
+static int32_t ST7735_FillWindow(ST7735_Object_t *pObj, uint32_t Xpos, uint32_t Ypos, uint32_t Width, uint32_t Height, uint32_t Color)
+{
+  int32_t ret = ST7735_OK;
+  uint8_t tmp = 0U;
+  uint32_t i, chunk, remaining = Width * Height;
+  static uint8_t pdata[640];
+
+  if(remaining == 0U)
+  {
+    return ST7735_OK;
+  }
+
+  /* Repeated color, the window is sent in chunks of this buffer */
+  chunk = (remaining < (sizeof(pdata) / 2U)) ? remaining : (sizeof(pdata) / 2U);
+  for(i = 0; i < chunk; i++)
+  {
+    /* Exchange LSB and MSB to fit LCD specification */
+    pdata[2U*i] = (uint8_t)(Color >> 8);
+    pdata[(2U*i) + 1U] = (uint8_t)(Color);
+  }
+
+  if(ST7735_SetDisplayWindow(pObj, Xpos, Ypos, Width, Height) != ST7735_OK)
+  {
+    ret = ST7735_ERROR;
+  }
+  else if(st7735_write_reg(&pObj->Ctx, ST7735_WRITE_RAM, &tmp, 0) != ST7735_OK)
+  {
+    ret = ST7735_ERROR;
+  }
+  else
+  {
+    while(remaining > 0U)
+    {
+      chunk = (remaining < (sizeof(pdata) / 2U)) ? remaining : (sizeof(pdata) / 2U);
+      if(st7735_send_data(&pObj->Ctx, pdata, 2U*chunk) != ST7735_OK)
+      {
+        ret = ST7735_ERROR;
+        break;
+      }
+      remaining -= chunk;
+    }
+
+    /* Restore the full screen window, SetCursor only sets the start */
+    if(ST7735_SetDisplayWindow(pObj, 0U, 0U, ST7735Ctx.Width, ST7735Ctx.Height) != ST7735_OK)
+    {
+      ret = ST7735_ERROR;
+    }
+  }
+
+  return ret;
+}
+
 /**
   * @brief  Sets a display window
   * @param  Xpos   specifies the X bottom left position.
@@ -1,10 +1,18 @@
 #include "stm32h7xx_hal.h"
 #include "gpio.h"
+#include "sa818.h"
+#include "menu.h"
 #include "attenuator.h"
 
 // internal variable to hold current attenuation
 static float current_attenuation_db = 0.0f;
 
+// auto ranging
+static bool auto_enabled = false;
+static uint32_t last_change_tick = 0;       // tick the attenuation last changed
+static uint32_t rssi_seen_count = 0;        // sa818 RSSI reading last looked at
+static float effective_rssi = 0.0f;         // RSSI + attenuation of the last reading taken
+
 // attenuation step lookup table (value + pin bit)
 static const struct {
     float value;
@@ -41,6 +49,8 @@ void attenuator_set(float attenuation_db)
     else if (attenuation_db > ATTENUATOR_MAX_DB)
         attenuation_db = ATTENUATOR_MAX_DB;
 
+    if (attenuation_db != current_attenuation_db)
+        last_change_tick = HAL_GetTick();
     current_attenuation_db = attenuation_db;
 
     // compute pin mask
@@ -65,3 +75,59 @@ float attenuator_get(void)
 {
     return current_attenuation_db;
 }
+
+void attenuator_set_auto(bool enable)
+{
+    auto_enabled = enable;
+}
+
+bool attenuator_is_auto(void)
+{
+    return auto_enabled;
+}
+
+void attenuator_task(void)
+{
+    const sa818_settings_t *s = sa818_get_settings();
+    uint32_t count = sa818_get_rssi_count();
+
+    if (count == rssi_seen_count)
+        return;  // no new RSSI reading
+    rssi_seen_count = count;
+
+    // A reading taken while the step settles is neither the old nor the
+    // new attenuation, skip it and keep the previous effective value.
+    // s->rssi already holds it, so the value is cached here rather than
+    // summed on every read.
+    if (HAL_GetTick() - last_change_tick < ATTENUATOR_AUTO_SETTLE_MS)
+        return;
+    effective_rssi = (float)s->rssi + current_attenuation_db;
+
+    if (!auto_enabled || s->mode != SA818_MODE_RX)
+        return;
+
+    // Outside the window, step straight to the middle of it. A pinned RSSI
+    // reads low, so that takes a few steps.
+    int32_t rssi = s->rssi;
+    float target = current_attenuation_db;
+
+    if (rssi >= ATTENUATOR_AUTO_HIGH_RSSI)
+        target += (float)(rssi - ATTENUATOR_AUTO_TARGET_RSSI);
+    else if (rssi < ATTENUATOR_AUTO_LOW_RSSI)
+        target -= (float)(ATTENUATOR_AUTO_TARGET_RSSI - rssi);
+
+    if (target < ATTENUATOR_MIN_DB)
+        target = ATTENUATOR_MIN_DB;
+    else if (target > ATTENUATOR_MAX_DB)
+        target = ATTENUATOR_MAX_DB;
+
+    if (target != current_attenuation_db) {
+        attenuator_set(target);
+        menu_update_display_async();
+    }
+}
+
+float attenuator_get_effective_rssi(void)
+{
+    return effective_rssi;
+}
@@ -0,0 +1,128 @@
+/**
+ ******************************************************************************
+ * @file      audio.c
+ * @brief     Continuous capture of the SA818 audio output in fixed blocks
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include "stm32h7xx_hal.h"
+#include "main.h"
+#include "adc.h"
+#include "audio.h"
+#include "scheduler.h"
+
+// ---------------------------------------------------------------------------
+// Internal state
+// ---------------------------------------------------------------------------
+
+// Two blocks, the DMA fills one while the other is handed out
+DMA_BUFFER static uint16_t audio_dma_buf[2 * AUDIO_BLOCK_SIZE];
+
+DTCM_BSS static int16_t audio_block[AUDIO_BLOCK_SIZE];
+static volatile uint8_t audio_ready = 0;     // bit n: half n is filled
+static volatile uint32_t audio_overruns = 0;
+static uint8_t audio_next_half = 0;
+
+// Running DC estimate in Q12, follows the bias of the audio output
+static int32_t audio_dc_q12 = 32768 << 12;
+
+static audio_block_cb_t audio_subscribers[AUDIO_MAX_SUBSCRIBERS];
+static uint8_t audio_subscriber_count = 0;
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+
+ITCM_TEXT static void audio_half_done(uint8_t half)
+{
+    if (audio_ready & (1u << half))
+        audio_overruns++;  // not handed out yet and already overwritten
+    audio_ready |= (uint8_t)(1u << half);
+    scheduler_post(SCHEDULER_EVENT_AUDIO);
+}
+
+// Removes the DC bias (high pass around 1 Hz) and converts to signed
+ITCM_TEXT static void audio_convert(const uint16_t *raw, int16_t *out)
+{
+    int32_t dc = audio_dc_q12;
+
+    for (uint16_t i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+        int32_t x = raw[i];
+        dc += ((x << 12) - dc) >> 10;
+
+        int32_t s = x - (dc >> 12);
+        if (s > INT16_MAX) s = INT16_MAX;
+        if (s < INT16_MIN) s = INT16_MIN;
+        out[i] = (int16_t)s;
+    }
+
+    audio_dc_q12 = dc;
+}
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+
+void audio_init(void)
+{
+    audio_ready = 0;
+    audio_next_half = 0;
+
+    audio_adc_init(AUDIO_SAMPLE_RATE_HZ);
+    audio_adc_start(audio_dma_buf, 2 * AUDIO_BLOCK_SIZE);
+}
+
+void audio_task(void)
+{
+    // Oldest half first, both can be pending after a slow pass
+    while (audio_ready & (1u << audio_next_half)) {
+        uint8_t half = audio_next_half;
+
+        __disable_irq();
+        audio_ready &= (uint8_t)~(1u << half);
+        __enable_irq();
+
+        audio_convert(&audio_dma_buf[half * AUDIO_BLOCK_SIZE], audio_block);
+        audio_next_half ^= 1;
+
+        audio_dispatch(audio_block, AUDIO_BLOCK_SIZE);
+    }
+}
+
+bool audio_subscribe(audio_block_cb_t callback)
+{
+    if (callback == NULL || audio_subscriber_count >= AUDIO_MAX_SUBSCRIBERS)
+        return false;
+
+    audio_subscribers[audio_subscriber_count++] = callback;
+    return true;
+}
+
+void audio_dispatch(const int16_t *samples, uint16_t count)
+{
+    for (uint8_t i = 0; i < audio_subscriber_count; i++)
+        audio_subscribers[i](samples, count);
+}
+
+uint32_t audio_get_overruns(void)
+{
+    return audio_overruns;
+}
+
+// ---------------------------------------------------------------------------
+// HAL callbacks
+// ---------------------------------------------------------------------------
+
+ITCM_TEXT void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    if (hadc->Instance == ADC1)
+        audio_half_done(0);
+}
+
+ITCM_TEXT void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
+{
+    if (hadc->Instance == ADC1)
+        audio_half_done(1);
+}
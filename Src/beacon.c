@@ -0,0 +1,425 @@
+/**
+ ******************************************************************************
+ * @file      beacon.c
+ * @brief     Fox beacon: scheduled transmissions with tone and MCW ID
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include <string.h>
+
+#include "stm32h7xx_hal.h"
+#include "beacon_timer.h"
+#include "beacon.h"
+#include "morse.h"
+#include "sa818.h"
+#include "test_tone.h"
+#include "menu.h"
+#include "scheduler.h"
+
+// ---------------------------------------------------------------------------
+// Configuration
+// ---------------------------------------------------------------------------
+
+#ifndef BEACON_CALLSIGN
+#error "BEACON_CALLSIGN is not set, the MCW ID needs the station's callsign (see beacon.h)"
+#endif
+
+_Static_assert(sizeof(BEACON_CALLSIGN) > 1 && sizeof(BEACON_CALLSIGN) <= BEACON_CALLSIGN_LEN + 1,
+               "BEACON_CALLSIGN needs 1 to BEACON_CALLSIGN_LEN characters");
+
+#define BEACON_WPM_MIN      5
+#define BEACON_WPM_MAX      40
+
+static const beacon_config_t beacon_defaults = {
+    .callsign = BEACON_CALLSIGN,
+    .interval_s = BEACON_INTERVAL_S,
+    .tone_s = BEACON_TONE_S,
+    .id_every = BEACON_ID_EVERY,
+    .wpm = 15,
+    .tone_hz = 800,
+    .lead_ms = 300,
+    .tail_ms = 200,
+};
+
+// ---------------------------------------------------------------------------
+// Internal state
+// ---------------------------------------------------------------------------
+
+// Written from the main loop, copied when a transmission starts
+static beacon_config_t config;
+static uint8_t config_codes[BEACON_CALLSIGN_LEN];  // morse_encode() per character, 0 for a word gap
+static uint8_t config_code_count = 0;
+
+// What the running transmission uses, only touched from the tick
+static beacon_config_t active;
+static uint8_t active_codes[BEACON_CALLSIGN_LEN];
+static uint8_t active_code_count = 0;
+
+// One-off MCW text, sent in place of the ID
+static uint8_t message_codes[BEACON_CALLSIGN_LEN];
+static uint8_t message_code_count = 0;
+static bool message = false;
+static beacon_state_t message_resume;   // state to return to afterwards
+
+static volatile beacon_state_t state = BEACON_STATE_OFF;
+static volatile bool running = false;
+static uint32_t state_ms = 0;     // ticks left in the state, or of the MCW element
+static uint32_t cycle_ms = 0;     // ticks since the transmission started
+static volatile uint32_t cycles = 0;
+
+static uint8_t id_index = 0;      // character being sent
+static uint8_t id_elements = 0;   // elements of it still to send
+static bool id_key = false;
+
+// The tick only keys the tone. Starting and stopping the DAC output takes
+// HAL calls that wait on SysTick, which cannot run below the tick, so
+// beacon_task() does that when the tick asks for it.
+static volatile bool tone_wanted = false;
+static bool tone_started = false;     // by beacon_task(), only touched there
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+
+static void beacon_set_ptt(bool on)
+{
+    sa818_set_mode(on ? SA818_MODE_TX : SA818_MODE_RX);
+    menu_update_display_async();
+}
+
+static void beacon_enter(beacon_state_t next, uint32_t ms)
+{
+    state = next;
+    state_ms = ms;
+}
+
+static uint32_t beacon_dit_ms(void)
+{
+    return 1200u / active.wpm;
+}
+
+// Keyed up either way, a transmission starts silent
+static void beacon_request_tone(bool on)
+{
+    testtone_key(false);
+    tone_wanted = on;
+    scheduler_post(SCHEDULER_EVENT_BEACON);
+}
+
+static void beacon_begin_transmission(void)
+{
+    active = config;
+    memcpy(active_codes, config_codes, sizeof(active_codes));
+    active_code_count = config_code_count;
+
+    cycle_ms = 0;
+    beacon_request_tone(true);
+    beacon_set_ptt(true);
+    beacon_enter(BEACON_STATE_LEAD, active.lead_ms);
+}
+
+static void beacon_begin_message(void)
+{
+    active = config;
+    active.tone_s = 0;
+    memcpy(active_codes, message_codes, sizeof(active_codes));
+    active_code_count = message_code_count;
+
+    message_resume = state;
+    message = true;
+    beacon_request_tone(true);
+    beacon_set_ptt(true);
+    beacon_enter(BEACON_STATE_LEAD, active.lead_ms);
+}
+
+// Unknown characters count as spaces, runs of spaces as one word gap
+static uint8_t beacon_encode(const char *text, uint8_t *codes)
+{
+    uint8_t count = 0;
+
+    for (const char *p = text; *p != '\0' && count < BEACON_CALLSIGN_LEN; p++) {
+        uint8_t code = morse_encode(*p);
+
+        if (code != 0 || (count > 0 && codes[count - 1] != 0))
+            codes[count++] = code;
+    }
+    if (count > 0 && codes[count - 1] == 0)
+        count--;
+
+    return count;
+}
+
+static void beacon_id_next(void)
+{
+    uint32_t dit_ms = beacon_dit_ms();
+
+    if (id_key) {
+        testtone_key(false);
+        id_key = false;
+
+        // One dit between elements, three between characters, seven
+        // between words
+        if (id_elements > 0) {
+            state_ms = dit_ms;
+            return;
+        }
+
+        uint32_t gap = 3;
+        id_index++;
+        while (id_index < active_code_count && active_codes[id_index] == 0) {
+            gap = 7;
+            id_index++;
+        }
+
+        if (id_index >= active_code_count)
+            beacon_enter(BEACON_STATE_TAIL, active.tail_ms);
+        else
+            state_ms = gap * dit_ms;
+        return;
+    }
+
+    uint8_t code = active_codes[id_index];
+
+    if (id_elements == 0)
+        id_elements = (uint8_t)(31 - __builtin_clz(code));  // bits below the leading one
+    id_elements--;
+
+    testtone_key(true);
+    id_key = true;
+    state_ms = ((code >> id_elements) & 1u) ? 3 * dit_ms : dit_ms;
+}
+
+static void beacon_start_id(uint32_t gap_ms)
+{
+    bool due = active_code_count > 0 &&
+               (message || (active.id_every > 0 && (cycles % active.id_every) == 0));
+
+    if (!due) {
+        beacon_enter(BEACON_STATE_TAIL, active.tail_ms);
+        return;
+    }
+
+    id_index = 0;
+    id_elements = 0;
+    id_key = false;
+    beacon_enter(BEACON_STATE_ID, gap_ms);
+
+    if (gap_ms == 0)
+        beacon_id_next();
+}
+
+// The current state has run its time
+static void beacon_next(void)
+{
+    switch (state) {
+    case BEACON_STATE_LEAD:
+        if (active.tone_s > 0) {
+            testtone_key(true);
+            beacon_enter(BEACON_STATE_TONE, active.tone_s * 1000u);
+        } else {
+            beacon_start_id(0);
+        }
+        break;
+
+    case BEACON_STATE_TONE:
+        // A character gap between the tone and the ID
+        testtone_key(false);
+        beacon_start_id(3 * beacon_dit_ms());
+        break;
+
+    case BEACON_STATE_ID:
+        beacon_id_next();
+        break;
+
+    case BEACON_STATE_TAIL:
+        beacon_request_tone(false);
+        beacon_set_ptt(false);
+        if (message) {
+            // Back to waiting, or off again if the beacon is not running
+            message = false;
+            state = message_resume;
+            if (state == BEACON_STATE_OFF)
+                beacon_timer_stop();
+        } else {
+            cycles++;
+            state = BEACON_STATE_WAIT;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+
+void beacon_init(void)
+{
+    beacon_set_config(&beacon_defaults);
+    beacon_timer_init(BEACON_TICK_HZ);
+}
+
+void beacon_start(void)
+{
+    if (running)
+        return;
+
+    running = true;
+    cycles = 0;
+    cycle_ms = (uint32_t)config.interval_s * 1000u;  // first tick starts a transmission
+
+    // A message on the air carries on, it returns to waiting afterwards
+    __disable_irq();
+    if (state == BEACON_STATE_OFF) {
+        state = BEACON_STATE_WAIT;
+        beacon_timer_start();
+    } else {
+        message_resume = BEACON_STATE_WAIT;
+    }
+    __enable_irq();
+}
+
+void beacon_stop(void)
+{
+    // With the timer stopped the tick cannot run, the rest is safe to touch
+    beacon_timer_stop();
+
+    if (state != BEACON_STATE_OFF && state != BEACON_STATE_WAIT) {
+        beacon_request_tone(false);
+        beacon_task();
+        beacon_set_ptt(false);
+    }
+    state = BEACON_STATE_OFF;
+    running = false;
+    message = false;
+}
+
+void beacon_task(void)
+{
+    if (tone_wanted) {
+        // Also after an off and on in between, the tone may have changed
+        testtone_set_frequency(active.tone_hz);
+        testtone_enable(true);
+        tone_started = true;
+        return;
+    }
+
+    // Leave a test tone the menu started alone
+    if (!tone_started)
+        return;
+    tone_started = false;
+    testtone_enable(false);
+
+    // Keyed down again for the menu's test tone, unless the tick started
+    // the next transmission in the meantime
+    __disable_irq();
+    if (!tone_wanted)
+        testtone_key(true);
+    __enable_irq();
+}
+
+bool beacon_is_running(void)
+{
+    return running;
+}
+
+bool beacon_send_text(const char *text)
+{
+    uint8_t codes[BEACON_CALLSIGN_LEN];
+    uint8_t count = beacon_encode(text, codes);
+    bool sent = false;
+
+    if (count == 0)
+        return false;
+
+    __disable_irq();
+    if (state == BEACON_STATE_OFF || state == BEACON_STATE_WAIT) {
+        memcpy(message_codes, codes, count);
+        message_code_count = count;
+        if (state == BEACON_STATE_OFF)
+            beacon_timer_start();
+        beacon_begin_message();
+        sent = true;
+    }
+    __enable_irq();
+
+    return sent;
+}
+
+beacon_state_t beacon_get_state(void)
+{
+    return state;
+}
+
+uint32_t beacon_get_cycles(void)
+{
+    return cycles;
+}
+
+uint16_t beacon_get_seconds_to_next(void)
+{
+    uint32_t interval_ms = (uint32_t)config.interval_s * 1000u;
+    uint32_t elapsed = cycle_ms;
+
+    if (state != BEACON_STATE_WAIT || elapsed >= interval_ms)
+        return 0;
+    return (uint16_t)((interval_ms - elapsed + 999u) / 1000u);
+}
+
+const beacon_config_t *beacon_get_config(void)
+{
+    return &config;
+}
+
+void beacon_set_config(const beacon_config_t *new_config)
+{
+    beacon_config_t c = *new_config;
+    uint8_t codes[BEACON_CALLSIGN_LEN];
+
+    c.callsign[BEACON_CALLSIGN_LEN] = '\0';
+    if (c.wpm < BEACON_WPM_MIN) c.wpm = BEACON_WPM_MIN;
+    if (c.wpm > BEACON_WPM_MAX) c.wpm = BEACON_WPM_MAX;
+
+    uint8_t count = beacon_encode(c.callsign, codes);
+
+    // The tick copies these when a transmission starts
+    __disable_irq();
+    config = c;
+    memcpy(config_codes, codes, count);
+    config_code_count = count;
+    __enable_irq();
+}
+
+void beacon_tick(void)
+{
+    if (state == BEACON_STATE_OFF)
+        return;
+
+    cycle_ms++;
+
+    if (state == BEACON_STATE_WAIT) {
+        if (cycle_ms >= (uint32_t)config.interval_s * 1000u)
+            beacon_begin_transmission();
+        return;
+    }
+
+    if (state_ms > 1) {
+        state_ms--;
+        return;
+    }
+    beacon_next();
+}
+
+// ---------------------------------------------------------------------------
+// HAL callbacks
+// ---------------------------------------------------------------------------
+
+void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+{
+    if (htim->Instance == TIM17)
+        beacon_tick();
+}
@@ -0,0 +1,166 @@
+/**
+ ******************************************************************************
+ * @file      bench.c
+ * @brief     Boot time benchmark of the DSP, the FFT, the ADC interrupt and
+ *            the menu redraw with the L1 caches off, on and emptied
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include <stdbool.h>
+
+#include "stm32h7xx_hal.h"
+#include "main.h"
+#include "audio.h"
+#include "menu.h"
+#include "spectrum.h"
+#include "bench.h"
+
+#if BENCH_ENABLE
+
+#define BENCH_REDRAW_GAP_MS  50    // past the redraw interval, the last flush is out
+#define BENCH_IRQ_MS         1000  // about 62 ADC interrupts
+
+// ---------------------------------------------------------------------------
+// Internal state
+// ---------------------------------------------------------------------------
+
+static int16_t bench_block[AUDIO_BLOCK_SIZE];
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+
+// Quiet noise, nothing for the decoders to lock on to
+static void bench_make_block(void)
+{
+    uint32_t seed = 1;
+
+    for (uint32_t i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        bench_block[i] = (int16_t)((int32_t)seed >> 22);
+    }
+}
+
+static void bench_caches(bool on)
+{
+    if (on) {
+        SCB_EnableICache();
+        SCB_EnableDCache();
+    } else {
+        SCB_DisableDCache();  // cleans it first
+        SCB_DisableICache();
+    }
+}
+
+// Nothing of the code or data left in the caches, only the TCMs keep it
+static void bench_flush(void)
+{
+    SCB_CleanInvalidateDCache();
+    SCB_InvalidateICache();
+}
+
+// Every audio subscriber on one block: meter, CTCSS, Morse, DTMF, and the
+// spectrum only storing its history
+static void bench_dsp(profile_id_t id, bool flush)
+{
+    spectrum_enable(false);
+    for (uint32_t i = 0; i < BENCH_BLOCKS; i++) {
+        if (flush)
+            bench_flush();
+        PROFILE_BEGIN(id);
+        audio_dispatch(bench_block, AUDIO_BLOCK_SIZE);
+        PROFILE_END(id);
+    }
+}
+
+// The spectrum times its own rows, one every SPECTRUM_HOP samples
+static void bench_fft(profile_id_t id, bool flush)
+{
+    uint32_t rows = spectrum_get_row_count();
+
+    spectrum_enable(true);
+    for (uint32_t i = 0; i < BENCH_BLOCKS; i++) {
+        if (flush)
+            bench_flush();
+        audio_dispatch(bench_block, AUDIO_BLOCK_SIZE);
+        if (spectrum_get_row_count() != rows) {
+            rows = spectrum_get_row_count();
+            profile_record(id, spectrum_get_cycles());
+        }
+    }
+    spectrum_enable(false);
+}
+
+// The ADC DMA interrupt as it comes, taken from the adcirq entry. The core
+// sleeps in between, with flush set the caches are emptied before every
+// WFI so the interrupt that ends it starts cold. SysTick wakes it every
+// ms, so at most a SysTick runs between the flush and the ADC interrupt.
+static void bench_irq(profile_id_t id, bool flush)
+{
+    const profile_entry_t *irq = profile_get(PROFILE_AUDIO_IRQ);
+    uint32_t start = HAL_GetTick();
+
+    while (HAL_GetTick() - start < BENCH_IRQ_MS) {
+        uint32_t calls = irq->calls;
+
+        if (flush)
+            bench_flush();
+        __disable_irq();
+        if (irq->calls == calls)
+            __WFI();
+        __enable_irq();
+
+        if (irq->calls == calls + 1)
+            profile_record(id, irq->last);
+    }
+}
+
+// Switching between the menu and the home screen redraws all of it, the
+// flush only queues the DMA
+static void bench_redraw(profile_id_t id)
+{
+    for (uint32_t i = 0; i < BENCH_REDRAWS; i++) {
+        menu_toggle();
+        HAL_Delay(BENCH_REDRAW_GAP_MS);
+        PROFILE_BEGIN(id);
+        menu_task();
+        PROFILE_END(id);
+    }
+    HAL_Delay(BENCH_REDRAW_GAP_MS);
+}
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+
+void bench_run(void)
+{
+    bench_make_block();
+
+    bench_caches(false);
+    bench_dsp(PROFILE_BENCH_DSP_C0, false);
+    bench_fft(PROFILE_BENCH_FFT_C0, false);
+    bench_irq(PROFILE_BENCH_IRQ_C0, false);
+    bench_redraw(PROFILE_BENCH_DRAW_C0);
+
+    bench_caches(true);
+    bench_dsp(PROFILE_BENCH_DSP_C1, false);
+    bench_fft(PROFILE_BENCH_FFT_C1, false);
+    bench_irq(PROFILE_BENCH_IRQ_C1, false);
+    bench_redraw(PROFILE_BENCH_DRAW_C1);
+
+    bench_dsp(PROFILE_BENCH_DSP_CX, true);
+    bench_fft(PROFILE_BENCH_FFT_CX, true);
+    bench_irq(PROFILE_BENCH_IRQ_CX, true);
+
+    bench_caches(CPU_CACHE_ENABLE);
+
+    // The regular entries saw all of the above, start them over. That
+    // leaves the results alone on the first page of the profile view.
+    profile_reset();
+    menu_show_profile();
+}
+
+#endif
@@ -0,0 +1,200 @@
+/**
+ ******************************************************************************
+ * @file      ctcss.c
+ * @brief     CTCSS sub-tone detector on the received audio (Goertzel bank)
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include "main.h"
+#include "audio.h"
+#include "ctcss.h"
+
+// ---------------------------------------------------------------------------
+// Tone table
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    uint16_t dhz;         // tenths of Hz
+    int32_t coeff;        // 2 * cos(2 * pi * f / 1 kHz), Q14
+    uint8_t sa818_code;   // AT+DMOSETGROUP sub-audio code, 0 = not supported
+} ctcss_tone_t;
+
+static const ctcss_tone_t ctcss_tones[CTCSS_TONE_COUNT] = {
+    {  670, 29907,  1 },  //  67.0 Hz
+    {  693, 29710,  0 },  //  69.3 Hz
+    {  719, 29481,  2 },  //  71.9 Hz
+    {  744, 29252,  3 },  //  74.4 Hz
+    {  770, 29007,  4 },  //  77.0 Hz
+    {  797, 28745,  5 },  //  79.7 Hz
+    {  825, 28463,  6 },  //  82.5 Hz
+    {  854, 28163,  7 },  //  85.4 Hz
+    {  885, 27831,  8 },  //  88.5 Hz
+    {  915, 27500,  9 },  //  91.5 Hz
+    {  948, 27125, 10 },  //  94.8 Hz
+    {  974, 26821, 11 },  //  97.4 Hz
+    { 1000, 26510, 12 },  // 100.0 Hz
+    { 1035, 26080, 13 },  // 103.5 Hz
+    { 1072, 25612, 14 },  // 107.2 Hz
+    { 1109, 25130, 15 },  // 110.9 Hz
+    { 1148, 24607, 16 },  // 114.8 Hz
+    { 1188, 24055, 17 },  // 118.8 Hz
+    { 1230, 23460, 18 },  // 123.0 Hz
+    { 1273, 22833, 19 },  // 127.3 Hz
+    { 1318, 22160, 20 },  // 131.8 Hz
+    { 1365, 21437, 21 },  // 136.5 Hz
+    { 1413, 20680, 22 },  // 141.3 Hz
+    { 1462, 19888, 23 },  // 146.2 Hz
+    { 1514, 19027, 24 },  // 151.4 Hz
+    { 1567, 18128, 25 },  // 156.7 Hz
+    { 1598, 17593,  0 },  // 159.8 Hz
+    { 1622, 17174, 26 },  // 162.2 Hz
+    { 1655, 16592,  0 },  // 165.5 Hz
+    { 1679, 16164, 27 },  // 167.9 Hz
+    { 1713, 15551,  0 },  // 171.3 Hz
+    { 1738, 15096, 28 },  // 173.8 Hz
+    { 1773, 14453,  0 },  // 177.3 Hz
+    { 1799, 13971, 29 },  // 179.9 Hz
+    { 1835, 13297,  0 },  // 183.5 Hz
+    { 1862, 12787, 30 },  // 186.2 Hz
+    { 1899, 12082,  0 },  // 189.9 Hz
+    { 1928, 11525, 31 },  // 192.8 Hz
+    { 1966, 10789,  0 },  // 196.6 Hz
+    { 1995, 10224,  0 },  // 199.5 Hz
+    { 2035,  9438, 32 },  // 203.5 Hz
+    { 2065,  8845,  0 },  // 206.5 Hz
+    { 2107,  8009, 33 },  // 210.7 Hz
+    { 2181,  6524, 34 },  // 218.1 Hz
+    { 2257,  4984, 35 },  // 225.7 Hz
+    { 2291,  4291,  0 },  // 229.1 Hz
+    { 2336,  3371, 36 },  // 233.6 Hz
+    { 2418,  1688, 37 },  // 241.8 Hz
+    { 2503,   -62, 38 },  // 250.3 Hz
+    { 2541,  -844,  0 },  // 254.1 Hz
+};
+
+// ---------------------------------------------------------------------------
+// Internal state
+// ---------------------------------------------------------------------------
+
+DTCM_BSS static int32_t goertzel_s1[CTCSS_TONE_COUNT];
+DTCM_BSS static int32_t goertzel_s2[CTCSS_TONE_COUNT];
+static int64_t window_energy = 0;
+static uint16_t window_count = 0;
+
+static int32_t decim_sum = 0;
+static uint8_t decim_count = 0;
+
+static int8_t ctcss_candidate = -1;
+static int8_t ctcss_tone = -1;
+static uint8_t ctcss_confidence = 0;
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+
+static void ctcss_reset_window(void)
+{
+    for (uint8_t i = 0; i < CTCSS_TONE_COUNT; i++) {
+        goertzel_s1[i] = 0;
+        goertzel_s2[i] = 0;
+    }
+    window_energy = 0;
+    window_count = 0;
+}
+
+static void ctcss_evaluate(void)
+{
+    int64_t best_power = 0;
+    int8_t best = -1;
+
+    for (uint8_t i = 0; i < CTCSS_TONE_COUNT; i++) {
+        int64_t s1 = goertzel_s1[i];
+        int64_t s2 = goertzel_s2[i];
+        int64_t power = s1 * s1 + s2 * s2 - ((ctcss_tones[i].coeff * s1 >> 14) * s2);
+
+        if (power > best_power) {
+            best_power = power;
+            best = (int8_t)i;
+        }
+    }
+
+    // A pure tone of amplitude A gives power (N*A/2)^2 and energy N*A^2/2,
+    // so the ratio below is 100 % for a tone without anything else
+    uint32_t confidence = 0;
+    if (window_energy > 0)
+        confidence = (uint32_t)((best_power * 200) / ((int64_t)CTCSS_WINDOW * window_energy));
+    ctcss_confidence = (uint8_t)(confidence > 100 ? 100 : confidence);
+
+    if (ctcss_confidence < CTCSS_MIN_CONFIDENCE)
+        best = -1;
+
+    ctcss_tone = (best >= 0 && best == ctcss_candidate) ? best : -1;
+    ctcss_candidate = best;
+}
+
+// One decimated sample through every filter of the bank
+static void ctcss_goertzel_step(int32_t x)
+{
+    window_energy += (int64_t)x * x;
+
+    for (uint8_t i = 0; i < CTCSS_TONE_COUNT; i++) {
+        int32_t s = x + (int32_t)(((int64_t)ctcss_tones[i].coeff * goertzel_s1[i]) >> 14) - goertzel_s2[i];
+        goertzel_s2[i] = goertzel_s1[i];
+        goertzel_s1[i] = s;
+    }
+
+    if (++window_count == CTCSS_WINDOW) {
+        ctcss_evaluate();
+        ctcss_reset_window();
+    }
+}
+
+ITCM_TEXT static void ctcss_on_block(const int16_t *samples, uint16_t count)
+{
+    // Averaging 8 samples is the anti-alias filter, its first null is at
+    // 1 kHz and the tones are all below 255 Hz
+    for (uint16_t i = 0; i < count; i++) {
+        decim_sum += samples[i];
+        if (++decim_count == CTCSS_DECIMATION) {
+            ctcss_goertzel_step(decim_sum / CTCSS_DECIMATION);
+            decim_sum = 0;
+            decim_count = 0;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+
+void ctcss_init(void)
+{
+    ctcss_reset_window();
+    audio_subscribe(ctcss_on_block);
+}
+
+int8_t ctcss_get_tone(void)
+{
+    return ctcss_tone;
+}
+
+uint16_t ctcss_get_tone_dhz(int8_t tone)
+{
+    if (tone < 0 || tone >= CTCSS_TONE_COUNT)
+        return 0;
+    return ctcss_tones[tone].dhz;
+}
+
+uint8_t ctcss_get_sa818_code(int8_t tone)
+{
+    if (tone < 0 || tone >= CTCSS_TONE_COUNT)
+        return 0;
+    return ctcss_tones[tone].sa818_code;
+}
+
+uint8_t ctcss_get_confidence(void)
+{
+    return ctcss_confidence;
+}
@@ -0,0 +1,291 @@
+/**
+ ******************************************************************************
+ * @file      dtmf.c
+ * @brief     DTMF decoder on the received audio with a PIN protected
+ *            remote control
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "main.h"
+#include "audio.h"
+#include "beacon.h"
+#include "sa818.h"
+#include "fmt.h"
+#include "dtmf.h"
+
+// ---------------------------------------------------------------------------
+// Configuration
+// ---------------------------------------------------------------------------
+
+#define DTMF_MIN_POWER      20000   // mean square of the window, below is silence
+#define DTMF_TWIST_NORMAL   6       // column tone up to ~8 dB above the row tone
+#define DTMF_TWIST_REVERSE  3       // row tone up to ~5 dB above the column tone
+#define DTMF_PEAK_RATIO     4       // winner 6 dB over the rest of its group
+
+// ---------------------------------------------------------------------------
+// Tables
+// ---------------------------------------------------------------------------
+
+// 697, 770, 852, 941 Hz rows then 1209, 1336, 1477, 1633 Hz columns,
+// 2 * cos(2 * pi * f / 8 kHz) in Q14
+static const int32_t dtmf_coeff[8] = {
+    27980, 26956, 25701, 24219, 19073, 16325, 13085, 9315
+};
+
+static const char dtmf_keys[4][4] = {
+    { '1', '2', '3', 'A' },
+    { '4', '5', '6', 'B' },
+    { '7', '8', '9', 'C' },
+    { '*', '0', '#', 'D' }
+};
+
+// ---------------------------------------------------------------------------
+// Internal state
+// ---------------------------------------------------------------------------
+
+DTCM_BSS static int32_t bin_s1[8];
+DTCM_BSS static int32_t bin_s2[8];
+static uint64_t window_energy = 0;
+static uint16_t window_count = 0;
+static uint32_t windows = 0;        // time base for the timeouts
+
+static char window_prev = 0;        // key seen in the previous window
+static char key_held = 0;           // debounced key, 0 between keys
+static char last_digit = '\0';
+static uint32_t digit_count = 0;
+
+// Command being entered, empty PIN while the remote control is off
+static char pin[DTMF_PIN_LEN + 1] = "";
+static char command[DTMF_MAX_DIGITS + 1];
+static uint8_t command_len = 0;
+static bool command_open = false;
+static uint32_t command_last_window = 0;
+static uint8_t bad_pins = 0;
+static uint32_t lockout_until = 0;
+
+// ---------------------------------------------------------------------------
+// Command interpreter
+// ---------------------------------------------------------------------------
+
+static bool dtmf_execute(const char *cmd, uint8_t len)
+{
+    const sa818_settings_t *s = sa818_get_settings();
+    char reply[BEACON_CALLSIGN_LEN + 1];
+    size_t n;
+
+    if (len == 1 && cmd[0] == '0') {
+        // "B1 P0 12": beacon running, high power, transmissions made
+        n = fmt_str(reply, sizeof(reply), beacon_is_running() ? "B1 P" : "B0 P");
+        n += fmt_str(reply + n, sizeof(reply) - n, s->power == SA818_POWER_HIGH ? "1 " : "0 ");
+        fmt_uint(reply + n, sizeof(reply) - n, beacon_get_cycles());
+        return beacon_send_text(reply);
+    }
+
+    if (len != 2)
+        return false;
+
+    uint8_t arg = (uint8_t)(cmd[1] - '0');
+    if (arg > 9)
+        return false;
+
+    switch (cmd[0]) {
+    case '1':
+        if (arg > 1) return false;
+        if (arg) beacon_start(); else beacon_stop();
+        break;
+    case '2':
+        if (arg > 1) return false;
+        sa818_set_power_level(arg ? SA818_POWER_HIGH : SA818_POWER_LOW);
+        break;
+    case '3':
+        if (arg < 1 || arg > 8) return false;
+        sa818_set_volume_level(arg);
+        break;
+    case '4':
+        if (arg > 8) return false;
+        sa818_set_squelch(arg);
+        break;
+    default:
+        return false;
+    }
+
+    beacon_send_text("R");
+    return true;
+}
+
+static void dtmf_command_done(void)
+{
+    command_open = false;
+
+    if (pin[0] == '\0' || windows < lockout_until || command_len <= DTMF_PIN_LEN)
+        return;
+
+    if (memcmp(command, pin, DTMF_PIN_LEN) != 0) {
+        // A few tries, then deaf for a while against guessing
+        if (++bad_pins >= DTMF_MAX_BAD_PINS) {
+            bad_pins = 0;
+            lockout_until = windows + DTMF_LOCKOUT_WINDOWS;
+        }
+        return;
+    }
+
+    bad_pins = 0;
+    dtmf_execute(command + DTMF_PIN_LEN, command_len - DTMF_PIN_LEN);
+}
+
+static void dtmf_on_key(char key)
+{
+    last_digit = key;
+    digit_count++;
+    command_last_window = windows;
+
+    if (key == '*') {
+        command_open = true;
+        command_len = 0;
+    } else if (!command_open) {
+        return;
+    } else if (key == '#') {
+        dtmf_command_done();
+    } else if (key >= '0' && key <= '9' && command_len < DTMF_MAX_DIGITS) {
+        command[command_len++] = key;
+    } else {
+        command_open = false;  // A..D or too long
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Decoder
+// ---------------------------------------------------------------------------
+
+// Strongest bin of a group of four, 0xFF if it does not stand out
+static uint8_t dtmf_pick(const uint64_t *power, uint64_t *best)
+{
+    uint8_t pick = 0;
+
+    for (uint8_t i = 1; i < 4; i++) {
+        if (power[i] > power[pick])
+            pick = i;
+    }
+    for (uint8_t i = 0; i < 4; i++) {
+        if (i != pick && power[i] * DTMF_PEAK_RATIO > power[pick])
+            return 0xFF;
+    }
+
+    *best = power[pick];
+    return pick;
+}
+
+static char dtmf_window_done(void)
+{
+    uint64_t power[8];
+
+    for (uint8_t i = 0; i < 8; i++) {
+        int64_t s1 = bin_s1[i];
+        int64_t s2 = bin_s2[i];
+        int64_t p = s1 * s1 + s2 * s2 - ((dtmf_coeff[i] * s1 >> 14) * s2);
+
+        power[i] = (p > 0) ? (uint64_t)p : 0;
+        bin_s1[i] = 0;
+        bin_s2[i] = 0;
+    }
+
+    uint64_t energy = window_energy;
+    window_energy = 0;
+
+    if (energy < (uint64_t)DTMF_MIN_POWER * DTMF_WINDOW)
+        return 0;
+
+    uint64_t row_power, col_power;
+    uint8_t row = dtmf_pick(&power[0], &row_power);
+    uint8_t col = dtmf_pick(&power[4], &col_power);
+
+    if (row == 0xFF || col == 0xFF)
+        return 0;
+
+    // Twist, the two tones arrive at about the same level
+    if (col_power > row_power * DTMF_TWIST_NORMAL || row_power > col_power * DTMF_TWIST_REVERSE)
+        return 0;
+
+    // A pure tone pair puts energy * N / 2 in its two bins, speech and
+    // noise spread out. Ask for at least half of that.
+    if ((row_power + col_power) * 4 < energy * DTMF_WINDOW)
+        return 0;
+
+    return dtmf_keys[row][col];
+}
+
+ITCM_TEXT static void dtmf_on_block(const int16_t *samples, uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++) {
+        int32_t x = samples[i];
+
+        window_energy += (uint64_t)((int64_t)x * x);
+        for (uint8_t b = 0; b < 8; b++) {
+            int32_t s = x + (int32_t)(((int64_t)dtmf_coeff[b] * bin_s1[b]) >> 14) - bin_s2[b];
+            bin_s2[b] = bin_s1[b];
+            bin_s1[b] = s;
+        }
+
+        if (++window_count < DTMF_WINDOW)
+            continue;
+        window_count = 0;
+        windows++;
+
+        // A key counts once it is the same in two windows in a row, and
+        // again only after two windows of something else
+        char key = dtmf_window_done();
+        if (key == window_prev && key != key_held) {
+            key_held = key;
+            if (key)
+                dtmf_on_key(key);
+        }
+        window_prev = key;
+
+        if (command_open && windows - command_last_window > DTMF_TIMEOUT_WINDOWS)
+            command_open = false;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+
+void dtmf_init(void)
+{
+#ifdef DTMF_PIN
+    _Static_assert(sizeof(DTMF_PIN) == DTMF_PIN_LEN + 1, "DTMF_PIN needs DTMF_PIN_LEN digits");
+    dtmf_set_pin(DTMF_PIN);
+#endif
+    audio_subscribe(dtmf_on_block);
+}
+
+char dtmf_get_last_digit(void)
+{
+    return last_digit;
+}
+
+uint32_t dtmf_get_digit_count(void)
+{
+    return digit_count;
+}
+
+bool dtmf_set_pin(const char *new_pin)
+{
+    pin[0] = '\0';
+    bad_pins = 0;
+
+    if (new_pin == NULL || strlen(new_pin) != DTMF_PIN_LEN)
+        return false;
+    for (uint8_t i = 0; i < DTMF_PIN_LEN; i++) {
+        if (new_pin[i] < '0' || new_pin[i] > '9')
+            return false;
+    }
+
+    memcpy(pin, new_pin, DTMF_PIN_LEN + 1);
+    return true;
+}
@@ -0,0 +1,125 @@
+/**
+ ******************************************************************************
+ * @file      fmt.c
+ * @brief     Allocation-free integer text formatting for UI and AT commands
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include "fmt.h"
+
+// Longest output of any formatter: sign, 10 digits, point and padding
+#define FMT_TMP_LEN   24
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+
+// Writes value in reverse into tmp, returns the number of digits. At least
+// min_digits are produced, leading positions are filled with '0'.
+static size_t fmt_digits_reversed(char *tmp, uint32_t value, uint8_t min_digits)
+{
+    size_t n = 0;
+    do {
+        tmp[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value || n < min_digits);
+    return n;
+}
+
+// Copies a reversed temp string into buf
+static size_t fmt_emit_reversed(char *buf, size_t size, const char *tmp, size_t n)
+{
+    if (buf == NULL || size == 0)
+        return 0;
+
+    // Truncating keeps the leading characters
+    size_t len = (n > size - 1) ? size - 1 : n;
+
+    for (size_t i = 0; i < len; i++)
+        buf[i] = tmp[n - 1 - i];
+    buf[len] = '\0';
+    return len;
+}
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+
+size_t fmt_str(char *buf, size_t size, const char *str)
+{
+    if (buf == NULL || size == 0)
+        return 0;
+
+    size_t n = 0;
+    while (str && str[n] && n < size - 1) {
+        buf[n] = str[n];
+        n++;
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+size_t fmt_uint(char *buf, size_t size, uint32_t value)
+{
+    char tmp[FMT_TMP_LEN];
+    size_t n = fmt_digits_reversed(tmp, value, 1);
+    return fmt_emit_reversed(buf, size, tmp, n);
+}
+
+size_t fmt_int(char *buf, size_t size, int32_t value)
+{
+    return fmt_fixed(buf, size, value, 0);
+}
+
+size_t fmt_uint_pad(char *buf, size_t size, uint32_t value, uint8_t width, char pad)
+{
+    char tmp[FMT_TMP_LEN];
+    size_t n = fmt_digits_reversed(tmp, value, 1);
+
+    if (width > FMT_TMP_LEN)
+        width = FMT_TMP_LEN;
+    while (n < width)
+        tmp[n++] = pad;
+
+    return fmt_emit_reversed(buf, size, tmp, n);
+}
+
+size_t fmt_fixed(char *buf, size_t size, int32_t value, uint8_t decimals)
+{
+    char tmp[FMT_TMP_LEN];
+    // Negate in unsigned so INT32_MIN works as well
+    uint32_t mag = (value < 0) ? (uint32_t)0 - (uint32_t)value : (uint32_t)value;
+
+    if (decimals > 9)
+        decimals = 9;
+
+    // The integer part needs at least one digit, "0.5" not ".5"
+    size_t n = fmt_digits_reversed(tmp, mag, decimals + 1);
+
+    if (decimals) {
+        // Make room for the point between fraction and integer part
+        for (size_t i = n; i > decimals; i--)
+            tmp[i] = tmp[i - 1];
+        tmp[decimals] = '.';
+        n++;
+    }
+
+    if (value < 0)
+        tmp[n++] = '-';
+
+    return fmt_emit_reversed(buf, size, tmp, n);
+}
+
+size_t fmt_mhz(char *buf, size_t size, uint32_t freq_hz)
+{
+    // 100 Hz units, rounded
+    return fmt_fixed(buf, size, (int32_t)((freq_hz + 50) / 100), 4);
+}
+
+size_t fmt_dbm(char *buf, size_t size, int32_t dbm)
+{
+    size_t n = fmt_int(buf, size, dbm);
+    return n + fmt_str(buf + n, size - n, " dBm");
+}
@@ -1,4 +1,5 @@
 #include "gpio.h"
+#include "attenuator.h"
 #include "lcd.h"
 #include "rtc.h"
 #include "main.h"
@@ -8,6 +9,17 @@
 #include "menu.h"
 #include "led.h"
 #include "test_tone.h"
+#include "audio.h"
+#include "signal_meter.h"
+#include "ctcss.h"
+#include "morse.h"
+#include "beacon.h"
+#include "dtmf.h"
+#include "spectrum.h"
+#include "scanner.h"
+#include "scheduler.h"
+#include "profile.h"
+#include "bench.h"
 
 static void SystemClock_Config(void);
 static void MPU_Config(void);
@@ -21,30 +33,54 @@ static void MX_DMA_Init(void);
 int main(void)
 {
   MPU_Config();
+#if CPU_CACHE_ENABLE
+  SCB_EnableICache();
+  SCB_EnableDCache();
+#endif
   HAL_Init();
   SystemClock_Config();
   MX_DMA_Init();
+  profile_init();
+  scheduler_init();
 
   gpio_init();
   board_button_init();
   rotary_init();
   lcd_init();
   sa818_init();
+  attenuator_init();
   led_init();
   testtone_init();
+  beacon_init();
+  audio_init();
+  signal_meter_init();
+  ctcss_init();
+  morse_init();
+  dtmf_init();
+  spectrum_init();
+  scanner_init();
 
   // rotary setup...
   lcd_show_bootlogo();
   menu_init();
-
-  while (1)
-  {
-      rotary_task();
-      menu_task();
-      sa818_task();
-      led_task();
-      testtone_task();
-  }
+#if BENCH_ENABLE
+  bench_run();
+#endif
+
+  // Added in priority order. The periods are only there for the time
+  // based parts (debounce, timeouts, poll intervals), the events give
+  // the quick response.
+  scheduler_add("audio", audio_task, 0, SCHEDULER_EVENT_MASK(SCHEDULER_EVENT_AUDIO));
+  scheduler_add("sa818", sa818_task, 1, SCHEDULER_EVENT_MASK(SCHEDULER_EVENT_SA818));
+  scheduler_add("scanner", scanner_task, 10, SCHEDULER_EVENT_MASK(SCHEDULER_EVENT_SA818));
+  scheduler_add("attenuator", attenuator_task, 10, SCHEDULER_EVENT_MASK(SCHEDULER_EVENT_SA818));
+  scheduler_add("beacon", beacon_task, 0, SCHEDULER_EVENT_MASK(SCHEDULER_EVENT_BEACON));
+  scheduler_add("rotary", rotary_task, 1, 0);
+  scheduler_add("menu", menu_task, 5, SCHEDULER_EVENT_MASK(SCHEDULER_EVENT_DISPLAY) |
+                                      SCHEDULER_EVENT_MASK(SCHEDULER_EVENT_LCD));
+  scheduler_add("led", led_task, 10, 0);
+
+  scheduler_run();
 }
 
 /**
@@ -127,6 +163,22 @@ static void MPU_Config(void)
   MPU_InitStruct.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
   MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
 
+  HAL_MPU_ConfigRegion(&MPU_InitStruct);
+
+  /** DMA buffers at the start of D2 SRAM: normal memory, not cacheable
+  */
+  MPU_InitStruct.Enable = MPU_REGION_ENABLE;
+  MPU_InitStruct.Number = MPU_REGION_NUMBER1;
+  MPU_InitStruct.BaseAddress = 0x30000000;
+  MPU_InitStruct.Size = DMA_BUFFER_REGION_SIZE;
+  MPU_InitStruct.SubRegionDisable = 0x0;
+  MPU_InitStruct.TypeExtField = MPU_TEX_LEVEL1;
+  MPU_InitStruct.AccessPermission = MPU_REGION_FULL_ACCESS;
+  MPU_InitStruct.DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE;
+  MPU_InitStruct.IsShareable = MPU_ACCESS_NOT_SHAREABLE;
+  MPU_InitStruct.IsCacheable = MPU_ACCESS_NOT_CACHEABLE;
+  MPU_InitStruct.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+
   HAL_MPU_ConfigRegion(&MPU_InitStruct);
   /* Enables the MPU */
   HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
@@ -141,6 +193,17 @@ static void MX_DMA_Init(void)
   /* DMA controller clock enable */
   __HAL_RCC_DMA1_CLK_ENABLE();
 
+  /* D2 SRAM holds the DMA_BUFFER section */
+  __HAL_RCC_D2SRAM1_CLK_ENABLE();
+  __HAL_RCC_D2SRAM2_CLK_ENABLE();
+  __HAL_RCC_D2SRAM3_CLK_ENABLE();
+
+  HAL_NVIC_SetPriority(DMA1_Stream0_IRQn, 6, 0);  // ADC1 audio, only flags a finished block
+  HAL_NVIC_EnableIRQ(DMA1_Stream0_IRQn);
+
+  HAL_NVIC_SetPriority(DMA1_Stream1_IRQn, 8, 0);  // DAC1_CH2 tone, transfer errors only
+  HAL_NVIC_EnableIRQ(DMA1_Stream1_IRQn);
+
   HAL_NVIC_SetPriority(DMA1_Stream2_IRQn, 5, 0);  // USART3_RX (High priority)
   HAL_NVIC_EnableIRQ(DMA1_Stream2_IRQn);
 
@@ -149,6 +212,9 @@ static void MX_DMA_Init(void)
 
   HAL_NVIC_SetPriority(USART3_IRQn, 6, 0);        // UART IDLE interrupt in between
   HAL_NVIC_EnableIRQ(USART3_IRQn);
+
+  HAL_NVIC_SetPriority(DMA1_Stream4_IRQn, 8, 0);  // SPI4_TX (Display, lowest)
+  HAL_NVIC_EnableIRQ(DMA1_Stream4_IRQn);
 }
 
 /**
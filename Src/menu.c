@@ -2,11 +2,23 @@
 #include <string.h>
 
 #include "stm32h7xx_hal.h"
+#include "main.h"
 
 #include "menu.h"
 #include "lcd.h"
 #include "sa818.h"
 #include "attenuator.h"
+#include "fmt.h"
+#include "signal_meter.h"
+#include "ctcss.h"
+#include "morse.h"
+#include "beacon.h"
+#include "test_tone.h"
+#include "spectrum.h"
+#include "scanner.h"
+#include "scheduler.h"
+#include "profile.h"
+#include "system_load.h"
 
 
 
@@ -16,16 +28,31 @@
 #define MENU_COMMIT_DELAY_MS     200
 #define MENU_REDRAW_INTERVAL_MS  40
 #define MENU_VISIBLE_LINES       4
+#define MENU_ID_CHARS            15   // newest Morse characters on the home screen
+#define MENU_SHOW_CPU_LOAD       1    // CPU load right of the signal line on the home screen
+#define MENU_LOAD_WIDTH          24   // "100%" in the 12 px font
 
 #define LCD_FONT_SIZE            16
 #define LCD_LINE_SPACING         18
 
+#define WATERFALL_TOP            14   // below the frequency scale
+#define SCAN_BAR_TOP             14   // below the header line
+#define SCAN_RSSI_FULL           128  // RSSI of a full height bar
+#define PROFILE_ROW_HEIGHT       12
+#define PROFILE_ROWS             5    // below the header line, (80 - 12) / 12
+#define PROFILE_REFRESH_MS       500
+
 // ---------------------------------------------------------------------------
 // Internal state
 // ---------------------------------------------------------------------------
 typedef enum {
     ui_state_home = 0,
-    ui_state_menu
+    ui_state_menu,
+    ui_state_waterfall,
+    ui_state_scanner,
+#if PROFILE_ENABLE
+    ui_state_profile,
+#endif
 } ui_state_t;
 
 static ui_state_t ui_state = ui_state_home;
@@ -39,19 +66,40 @@ static uint8_t local_value = 0;
 static uint8_t update_display_async = 1;
 static uint8_t force_full_redraw = 0;
 
+static uint16_t waterfall_y = WATERFALL_TOP;   // row the next spectrum goes to
+static uint32_t waterfall_rows = 0;           // spectrum rows drawn
+
+static uint32_t scan_updates = 0;             // scanner results drawn
+static uint32_t scan_columns[SPECTRUM_WIDTH]; // what each bar shows, to skip unchanged ones
+
+#if PROFILE_ENABLE
+static uint8_t profile_page = 0;              // value knob pages through the table
+#endif
+
 // ---------------------------------------------------------------------------
 // Forward declarations
 // ---------------------------------------------------------------------------
 static void draw_home_screen(void);
 static void draw_menu_screen(void);
+static void draw_waterfall_screen(void);
+static void draw_scanner_screen(void);
+#if PROFILE_ENABLE
+static void draw_profile_screen(void);
+static uint8_t profile_page_count(void);
+#endif
+static void menu_enter_view(ui_state_t state);
 static void draw_scrollbar(uint8_t top, uint8_t total, uint8_t visible);
 static void menu_commit_if_pending(void);
 static void menu_on_value_committed(void);
+static size_t menu_format_atten(char *buf, size_t size);
 
 // SA818 menu handlers
 static const char* menu_atten_get_value(void);
 static void menu_atten_step_value(int step);
 
+static const char* menu_sig_cal_get_value(void);
+static void menu_sig_cal_step_value(int step);
+
 static const char* menu_bandwidth_get_value(void);
 static void menu_bandwidth_step_value(int step);
 
@@ -91,6 +139,16 @@ static void menu_mode_step_value(int step);
 static const char* menu_power_get_value(void);
 static void menu_power_step_value(int step);
 
+// Beacon schedule handlers
+static const char* menu_interval_get_value(void);
+static void menu_interval_step_value(int step);
+
+static const char* menu_tone_time_get_value(void);
+static void menu_tone_time_step_value(int step);
+
+static const char* menu_id_every_get_value(void);
+static void menu_id_every_step_value(int step);
+
 // ---------------------------------------------------------------------------
 // Menu table
 // ---------------------------------------------------------------------------
@@ -102,6 +160,7 @@ typedef struct {
 
 static const menu_descriptor_t menu_table[menu_item_count] = {
     { "Attenuator", menu_atten_get_value, menu_atten_step_value }, // NEW
+    { "Sig Cal",    menu_sig_cal_get_value,   menu_sig_cal_step_value   },
     { "Bandwidth",  menu_bandwidth_get_value, menu_bandwidth_step_value },
     { "TX Freq",    menu_tx_freq_get_value,   menu_tx_freq_step_value   },
     { "RX Freq",    menu_rx_freq_get_value,   menu_rx_freq_step_value   },
@@ -114,6 +173,9 @@ static const menu_descriptor_t menu_table[menu_item_count] = {
     { "Lowpass",    menu_low_get_value,       menu_low_step_value       },
     { "Tail Tone",  menu_tail_get_value,      menu_tail_step_value      },
     { "Mode",       menu_mode_get_value,      menu_mode_step_value      },
+    { "Interval",   menu_interval_get_value,  menu_interval_step_value  },
+    { "Tone Time",  menu_tone_time_get_value, menu_tone_time_step_value },
+    { "ID Every",   menu_id_every_get_value,  menu_id_every_step_value  },
     { "Power",      menu_power_get_value,     menu_power_step_value     },
 };
 
@@ -140,15 +202,47 @@ void menu_toggle(void)
     }
     else
     {
-        ui_state = ui_state_menu;
+        if (ui_state != ui_state_home)
+            lcd_clear();  // the menu lines do not cover the whole panel
+        menu_enter_view(ui_state_menu);
     }
 
     update_display_async = 1;
 }
 
+// The boot benchmark leaves its results here, on the first page once the
+// regular entries have been reset
+void menu_show_profile(void)
+{
+#if PROFILE_ENABLE
+    menu_commit_if_pending();
+    profile_page = 0;
+    menu_enter_view(ui_state_profile);
+    force_full_redraw = 1;
+    update_display_async = 1;
+#endif
+}
+
 void menu_step_through(int step)
 {
-    if (ui_state != ui_state_menu) return;
+    // Outside the menu the knob walks home, waterfall and band scan
+    if (ui_state != ui_state_menu) {
+        static const ui_state_t views[] = {
+            ui_state_home, ui_state_waterfall, ui_state_scanner,
+#if PROFILE_ENABLE
+            ui_state_profile,
+#endif
+        };
+        const uint8_t view_count = sizeof(views) / sizeof(views[0]);
+        uint8_t view = 0;
+        while (views[view] != ui_state)
+            view++;
+        view = (uint8_t)((view + (step > 0 ? 1 : view_count - 1)) % view_count);
+        menu_enter_view(views[view]);
+        force_full_redraw = 1;
+        update_display_async = 1;
+        return;
+    }
 
     menu_commit_if_pending();
 
@@ -168,6 +262,15 @@ void menu_step_through(int step)
 
 void menu_value_step(int step)
 {
+#if PROFILE_ENABLE
+    if (ui_state == ui_state_profile && step != 0) {
+        uint8_t pages = profile_page_count();
+        profile_page = (uint8_t)((profile_page + (step > 0 ? 1 : pages - 1)) % pages);
+        force_full_redraw = 1;
+        update_display_async = 1;
+        return;
+    }
+#endif
     if (ui_state != ui_state_menu || step == 0) return;
 
     menu_table[current_menu].step_value(step);
@@ -185,22 +288,64 @@ void menu_task(void)
         update_display_async = 1;
     }
 
+#if PROFILE_ENABLE
+    // Nothing announces new numbers, refresh on a timer
+    if (ui_state == ui_state_profile && now - last_draw_time >= PROFILE_REFRESH_MS)
+        update_display_async = 1;
+#endif
+
     if (update_display_async && (now - last_draw_time >= MENU_REDRAW_INTERVAL_MS)) {
-        if (ui_state == ui_state_home)
+        if (ui_state == ui_state_home) {
+            PROFILE_BEGIN(PROFILE_DRAW_HOME);
             draw_home_screen();
-        else
+            PROFILE_END(PROFILE_DRAW_HOME);
+        } else if (ui_state == ui_state_waterfall) {
+            PROFILE_BEGIN(PROFILE_DRAW_WATERFALL);
+            draw_waterfall_screen();
+            PROFILE_END(PROFILE_DRAW_WATERFALL);
+        } else if (ui_state == ui_state_scanner) {
+            PROFILE_BEGIN(PROFILE_DRAW_SCANNER);
+            draw_scanner_screen();
+            PROFILE_END(PROFILE_DRAW_SCANNER);
+#if PROFILE_ENABLE
+        } else if (ui_state == ui_state_profile) {
+            draw_profile_screen();
+#endif
+        } else {
+            PROFILE_BEGIN(PROFILE_DRAW_MENU);
             draw_menu_screen();
+            PROFILE_END(PROFILE_DRAW_MENU);
+        }
 
         last_draw_time = now;
         update_display_async = 0;
     }
+
+    // Queue what changed in the framebuffer, the DMA sends it in the
+    // background and anything left over goes out on a later pass
+    PROFILE_BEGIN(PROFILE_LCD_FLUSH);
+    lcd_flush_async();
+    PROFILE_END(PROFILE_LCD_FLUSH);
 }
 
 void menu_update_display_async(void)
 {
-    // Only redraw immediately if we are in the home view
-    if (ui_state == ui_state_home)
+    // Only redraw immediately if we are outside the menu
+    if (ui_state != ui_state_menu) {
         update_display_async = 1;
+        scheduler_post(SCHEDULER_EVENT_DISPLAY);
+    }
+}
+
+// The waterfall and the band scan only run while they are on screen
+static void menu_enter_view(ui_state_t state)
+{
+    ui_state = state;
+    spectrum_enable(state == ui_state_waterfall);
+    if (state == ui_state_scanner)
+        scanner_start();
+    else
+        scanner_stop();
 }
 
 // ---------------------------------------------------------------------------
@@ -215,6 +360,9 @@ static void draw_home_screen(void)
     static char prev_mode_freq[32] = "";
     static char prev_rssi[32] = "";
     static char prev_atten[32] = "";
+#if MENU_SHOW_CPU_LOAD
+    static char prev_load[8] = "";
+#endif
 
     // --- Force full redraw if requested ---
     if (force_full_redraw)
@@ -223,12 +371,24 @@ static void draw_home_screen(void)
         prev_mode_freq[0] = 0;
         prev_rssi[0] = 0;
         prev_atten[0] = 0;
+#if MENU_SHOW_CPU_LOAD
+        prev_load[0] = 0;
+#endif
         lcd_clear();
         force_full_redraw = 0;
     }
 
-    // --- Line 1: Title / version ---
-    snprintf(line, sizeof(line), "SA818 v%s", s->version);
+    // --- Line 1: Decoded Morse ID once there is one, else title / version ---
+    const char *id = morse_get_text();
+    size_t n;
+    if (id[0] != '\0') {
+        size_t len = strlen(id);
+        n = fmt_str(line, sizeof(line), "ID: ");
+        fmt_str(line + n, sizeof(line) - n, len > MENU_ID_CHARS ? id + len - MENU_ID_CHARS : id);
+    } else {
+        n = fmt_str(line, sizeof(line), "SA818 v");
+        fmt_str(line + n, sizeof(line) - n, s->version);
+    }
     if (strcmp(line, prev_version) != 0) {
         lcd_draw_filled_rect(0, 4, lcd_get_width(), LCD_LINE_SPACING, BLACK);
         lcd_show_string(4, 4, lcd_get_width(), 16, LCD_FONT_SIZE, (uint8_t*)line);
@@ -236,33 +396,311 @@ static void draw_home_screen(void)
     }
 
     // --- Line 2: Mode and frequency ---
-    snprintf(line, sizeof(line), "%s %.4f MHz",
-             s->mode == SA818_MODE_RX ? "RX" : "TX",
-             (s->mode == SA818_MODE_RX) ? s->rx_frequency : s->tx_frequency);
+    n = fmt_str(line, sizeof(line), s->mode == SA818_MODE_RX ? "RX " : "TX ");
+    n += fmt_mhz(line + n, sizeof(line) - n,
+                 (s->mode == SA818_MODE_RX) ? s->rx_frequency : s->tx_frequency);
+    fmt_str(line + n, sizeof(line) - n, " MHz");
     if (strcmp(line, prev_mode_freq) != 0) {
         lcd_draw_filled_rect(0, 22, lcd_get_width(), LCD_LINE_SPACING, BLACK);
         lcd_show_string(4, 22, lcd_get_width(), 16, LCD_FONT_SIZE, (uint8_t*)line);
         strncpy(prev_mode_freq, line, sizeof(prev_mode_freq));
     }
 
-    // --- Line 3: RSSI ---
-    snprintf(line, sizeof(line), "RSSI: %d dBm", s->rssi);
+    // --- Line 3: Signal level, RSSI fused with the audio noise ---
+    // Whole dB and no "m", the level is only relative until "Sig Cal" has
+    // been set against a signal generator
+    int32_t level_db10 = signal_meter_get_level_db10();
+    n = fmt_str(line, sizeof(line), "Sig: ");
+    n += fmt_int(line + n, sizeof(line) - n, (level_db10 + (level_db10 < 0 ? -5 : 5)) / 10);
+    fmt_str(line + n, sizeof(line) - n, " dB");
     if (strcmp(line, prev_rssi) != 0) {
+#if MENU_SHOW_CPU_LOAD
+        // Leaves the load to its right alone, "Sig: -130 dB" still fits
+        lcd_draw_filled_rect(0, 40, lcd_get_width() - MENU_LOAD_WIDTH, LCD_LINE_SPACING, BLACK);
+#else
         lcd_draw_filled_rect(0, 40, lcd_get_width(), LCD_LINE_SPACING, BLACK);
+#endif
         lcd_show_string(4, 40, lcd_get_width(), 16, LCD_FONT_SIZE, (uint8_t*)line);
         strncpy(prev_rssi, line, sizeof(prev_rssi));
     }
 
     // --- Line 4: Attenuator ---
-    snprintf(line, sizeof(line), "Atten: %.1f dB", attenuator_get());
+    n = fmt_str(line, sizeof(line), "Atten: ");
+    menu_format_atten(line + n, sizeof(line) - n);
     if (strcmp(line, prev_atten) != 0) {
         lcd_draw_filled_rect(0, 58, lcd_get_width(), LCD_LINE_SPACING, BLACK);
         lcd_show_string(4, 58, lcd_get_width(), 16, LCD_FONT_SIZE, (uint8_t*)line);
         strncpy(prev_atten, line, sizeof(prev_atten));
     }
+
+#if MENU_SHOW_CPU_LOAD
+    // --- CPU load, small, right of the signal line. The Atten line below
+    // can run the full width ("Atten: Auto 31.5 dB"), this one never does.
+    n = fmt_uint(line, sizeof(prev_load), system_cpu_load_percent());
+    fmt_str(line + n, sizeof(prev_load) - n, "%");
+    if (strcmp(line, prev_load) != 0) {
+        uint16_t w = (uint16_t)(strlen(line) * 6);
+        lcd_draw_filled_rect(lcd_get_width() - MENU_LOAD_WIDTH, 40, MENU_LOAD_WIDTH, LCD_LINE_SPACING, BLACK);
+        lcd_show_string(lcd_get_width() - w, 44, w, 12, 12, (uint8_t*)line);
+        strncpy(prev_load, line, sizeof(prev_load));
+    }
+#endif
+}
+
+
+
+// Dark blue through cyan and yellow to red
+static uint16_t waterfall_color(uint8_t level)
+{
+    uint8_t t = (uint8_t)((level & 63) << 2);
+    uint8_t r, g, b;
+
+    switch (level >> 6) {
+    case 0:  r = 0;   g = 0;       b = t;             break;
+    case 1:  r = 0;   g = t;       b = 255;           break;
+    case 2:  r = t;   g = 255;     b = (uint8_t)~t;   break;
+    default: r = 255; g = (uint8_t)~t; b = 0;         break;
+    }
+
+    return (uint16_t)(((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3));
+}
+
+// Rows are written top to bottom and wrap around, a gray line marks the
+// oldest. Only the new row and the marker go out to the panel.
+static void draw_waterfall_screen(void)
+{
+    uint16_t pixels[SPECTRUM_WIDTH];
+    char text[16];
+
+    static char prev_cost[16] = "";
+
+    POINT_COLOR = WHITE;
+    BACK_COLOR = BLACK;
+
+    if (force_full_redraw)
+    {
+        lcd_clear();
+        // 1 kHz per 40 columns
+        for (uint16_t x = 0; x < SPECTRUM_WIDTH; x += 20)
+            lcd_draw_filled_rect(x, WATERFALL_TOP - 3, 1, (x % 40) ? 1 : 2, GRAY);
+        lcd_show_string(34, 0, 12, 12, 12, (uint8_t*)"1k");
+        lcd_show_string(74, 0, 12, 12, 12, (uint8_t*)"2k");
+        lcd_show_string(114, 0, 12, 12, 12, (uint8_t*)"3k");
+        prev_cost[0] = 0;
+        waterfall_y = WATERFALL_TOP;
+        waterfall_rows = spectrum_get_row_count();
+        force_full_redraw = 0;
+        return;
+    }
+
+    uint32_t rows = spectrum_get_row_count();
+    if (rows == waterfall_rows)
+        return;
+    waterfall_rows = rows;
+
+    const uint8_t *row = spectrum_get_row();
+    for (uint16_t x = 0; x < SPECTRUM_WIDTH; x++)
+        pixels[x] = LCD_PANEL_COLOR(waterfall_color(row[x]));
+    lcd_draw_pixels(0, waterfall_y, pixels, SPECTRUM_WIDTH, 1);
+
+    if (++waterfall_y >= lcd_get_height())
+        waterfall_y = WATERFALL_TOP;
+    lcd_draw_filled_rect(0, waterfall_y, SPECTRUM_WIDTH, 1, GRAY);
+
+    // Time per row, about once a second so the text does not flicker
+    if ((rows % 20) == 0) {
+        size_t n = fmt_uint(text, sizeof(text), spectrum_get_cycles() / (SystemCoreClock / 1000000));
+        fmt_str(text + n, sizeof(text) - n, "us");
+        if (strcmp(text, prev_cost) != 0) {
+            uint16_t w = (uint16_t)(strlen(text) * 6);
+            lcd_draw_filled_rect(130, 0, SPECTRUM_WIDTH - 130, 12, BLACK);
+            lcd_show_string(SPECTRUM_WIDTH - w, 0, w, 12, 12, (uint8_t*)text);
+            strncpy(prev_cost, text, sizeof(prev_cost));
+        }
+    }
+}
+
+// One bar per column: the average in blue, green while S+ reports a
+// carrier, and the highest reading as a white dot
+static void draw_scanner_screen(void)
+{
+    uint16_t count = scanner_get_channel_count();
+    uint16_t height = (uint16_t)(lcd_get_height() - SCAN_BAR_TOP);
+    char line[32];
+
+    static char prev_header[32] = "";
+
+    POINT_COLOR = WHITE;
+    BACK_COLOR = BLACK;
+
+    if (force_full_redraw)
+    {
+        lcd_clear();
+        memset(scan_columns, 0xFF, sizeof(scan_columns));
+        prev_header[0] = 0;
+        force_full_redraw = 0;
+    }
+
+    uint32_t updates = scanner_get_update_count();
+    if (updates == scan_updates || count == 0)
+        return;
+    scan_updates = updates;
+
+    uint16_t peak = 0;
+    uint16_t peak_avg = 0;
+
+    for (uint16_t x = 0; x < SPECTRUM_WIDTH; x++) {
+        uint16_t first = (uint16_t)(x * count / SPECTRUM_WIDTH);
+        uint16_t last = (uint16_t)((x + 1) * count / SPECTRUM_WIDTH);
+        uint16_t avg = 0, max = 0;
+        bool signal = false;
+
+        if (last <= first)
+            last = first + 1;
+
+        for (uint16_t i = first; i < last; i++) {
+            const scanner_channel_t *ch = scanner_get_channel(i);
+            if (ch->avg_q4 > avg) avg = ch->avg_q4;
+            if (ch->max > max) max = ch->max;
+            signal |= ch->signal;
+            if (ch->avg_q4 > peak_avg) {
+                peak_avg = ch->avg_q4;
+                peak = i;
+            }
+        }
+
+        uint16_t bar = (uint16_t)((avg >> 4) * height / SCAN_RSSI_FULL);
+        uint16_t dot = (uint16_t)(max * height / SCAN_RSSI_FULL);
+        if (bar > height) bar = height;
+        if (dot >= height) dot = height - 1;
+
+        uint32_t column = (uint32_t)bar | ((uint32_t)dot << 8) | ((uint32_t)signal << 16);
+        if (column == scan_columns[x])
+            continue;
+        scan_columns[x] = column;
+
+        lcd_draw_filled_rect(x, SCAN_BAR_TOP, 1, height - bar, BLACK);
+        lcd_draw_filled_rect(x, SCAN_BAR_TOP + height - bar, 1, bar, signal ? GREEN : BLUE);
+        lcd_draw_filled_rect(x, SCAN_BAR_TOP + height - 1 - dot, 1, 1, WHITE);
+    }
+
+    // Strongest channel and the scan speed
+    size_t n = fmt_mhz(line, sizeof(line), scanner_get_frequency(peak));
+    n += fmt_str(line + n, sizeof(line) - n, scanner_get_channel(peak)->signal ? "* " : "  ");
+    n += fmt_uint(line + n, sizeof(line) - n, scanner_get_rate());
+    fmt_str(line + n, sizeof(line) - n, " ch/s");
+    if (strcmp(line, prev_header) != 0) {
+        lcd_draw_filled_rect(0, 0, lcd_get_width(), 12, BLACK);
+        lcd_show_string(0, 0, lcd_get_width(), 12, 12, (uint8_t*)line);
+        strncpy(prev_header, line, sizeof(prev_header));
+    }
+}
+
+#if PROFILE_ENABLE
+// Right aligned at x_end, microseconds with one decimal
+static void draw_profile_value(uint16_t x_end, uint16_t y, uint32_t cycles)
+{
+    char text[12];
+    uint32_t tenths = (uint32_t)((uint64_t)cycles * 10 / (SystemCoreClock / 1000000));
+    uint16_t w = (uint16_t)(fmt_fixed(text, sizeof(text), (int32_t)tenths, 1) * 6);
+
+    lcd_show_string(x_end - w, y, w, PROFILE_ROW_HEIGHT, 12, (uint8_t*)text);
+}
+
+// Right aligned at x_end
+static void draw_profile_count(uint16_t x_end, uint16_t y, uint32_t count)
+{
+    char text[12];
+    uint16_t w = (uint16_t)(fmt_uint(text, sizeof(text), count) * 6);
+
+    lcd_show_string(x_end - w, y, w, PROFILE_ROW_HEIGHT, 12, (uint8_t*)text);
+}
+
+// Pages the entries that have run fill, at least one
+static uint8_t profile_entry_pages(void)
+{
+    uint8_t shown = 0;
+
+    for (uint8_t id = 0; id < PROFILE_COUNT; id++) {
+        const profile_entry_t *e = profile_get((profile_id_t)id);
+        if (e->calls != 0 && e->name != NULL)
+            shown++;
+    }
+    return (shown > PROFILE_ROWS) ? (uint8_t)((shown + PROFILE_ROWS - 1) / PROFILE_ROWS) : 1;
+}
+
+// The entries first, then the scheduler tasks
+static uint8_t profile_page_count(void)
+{
+    uint8_t tasks = scheduler_get_task_count();
+
+    return (uint8_t)(profile_entry_pages() + (tasks + PROFILE_ROWS - 1) / PROFILE_ROWS);
 }
 
+// Min, average and max time of every task and region that has run, then
+// the run count and worst latency of every scheduler task. The value knob
+// pages through them.
+static void draw_profile_screen(void)
+{
+    uint8_t entry_pages = profile_entry_pages();
+    uint8_t row = 0;
+
+    // A reset can leave fewer pages than the one shown
+    if (profile_page >= profile_page_count())
+        profile_page = 0;
 
+    bool tasks = profile_page >= entry_pages;
+    uint8_t skip = (uint8_t)((tasks ? profile_page - entry_pages : profile_page) * PROFILE_ROWS);
+
+    POINT_COLOR = WHITE;
+    BACK_COLOR = BLACK;
+
+    if (force_full_redraw) {
+        lcd_clear();
+        // Which placement the times are from, the benchmark compares two builds
+        lcd_show_string(0, 0, lcd_get_width(), PROFILE_ROW_HEIGHT, 12,
+                        (uint8_t*)(tasks ? "us task        runs   lat" :
+                                   TCM_PLACEMENT_ENABLE ? "us TCM    min   avg   max" :
+                                                          "us no TCM min   avg   max"));
+        force_full_redraw = 0;
+    }
+
+    for (uint8_t i = skip; tasks && i < scheduler_get_task_count() && row < PROFILE_ROWS; i++) {
+        const scheduler_task_stats_t *t = scheduler_get_stats(i);
+
+        uint16_t y = (uint16_t)(PROFILE_ROW_HEIGHT * (row + 1));
+        lcd_draw_filled_rect(0, y, lcd_get_width(), PROFILE_ROW_HEIGHT, BLACK);
+        lcd_show_string(0, y, 60, PROFILE_ROW_HEIGHT, 12, (uint8_t*)t->name);
+        draw_profile_count(114, y, t->runs);
+        draw_profile_count(150, y, t->max_latency_us);
+        row++;
+    }
+
+    for (uint8_t id = 0; !tasks && id < PROFILE_COUNT && row < PROFILE_ROWS; id++) {
+        const profile_entry_t *e = profile_get((profile_id_t)id);
+
+        if (e->calls == 0 || e->name == NULL)
+            continue;
+        if (skip > 0) {
+            skip--;
+            continue;
+        }
+
+        uint16_t y = (uint16_t)(PROFILE_ROW_HEIGHT * (row + 1));
+        lcd_draw_filled_rect(0, y, lcd_get_width(), PROFILE_ROW_HEIGHT, BLACK);
+        lcd_show_string(0, y, 42, PROFILE_ROW_HEIGHT, 12, (uint8_t*)e->name);
+        draw_profile_value(78, y, e->min);
+        draw_profile_value(114, y, (uint32_t)(e->total / e->calls));
+        draw_profile_value(150, y, e->max);
+        row++;
+    }
+
+    // Clear what the other page or a shorter table left behind
+    uint16_t y = (uint16_t)(PROFILE_ROW_HEIGHT * (row + 1));
+    if (y < lcd_get_height())
+        lcd_draw_filled_rect(0, y, lcd_get_width(), lcd_get_height() - y, BLACK);
+}
+#endif
 
 static void draw_menu_screen(void)
 {
@@ -288,11 +726,11 @@ static void draw_menu_screen(void)
         // Draw menu name
         POINT_COLOR = text_color;
         BACK_COLOR  = bg_color;
-        snprintf((char*)text, sizeof(text), "%s", menu_table[index].name);
+        fmt_str((char*)text, sizeof(text), menu_table[index].name);
         lcd_show_string(4, y, 96, 16, LCD_FONT_SIZE, text);
 
         // Draw menu value
-        snprintf((char*)text, sizeof(text), "%s", menu_table[index].get_value());
+        fmt_str((char*)text, sizeof(text), menu_table[index].get_value());
         lcd_show_string(100, y, lcd_get_width() - 100, 16, LCD_FONT_SIZE, text);
     }
 
@@ -335,6 +773,16 @@ static void menu_on_value_committed(void)
            menu_table[current_menu].get_value());
 }
 
+// "12.5 dB", the attenuator works in 0.5 dB steps. "Auto 12.5 dB" while
+// it follows the RSSI.
+static size_t menu_format_atten(char *buf, size_t size)
+{
+    int32_t tenths = (int32_t)(attenuator_get() * 10.0f + 0.5f);
+    size_t n = attenuator_is_auto() ? fmt_str(buf, size, "Auto ") : 0;
+    n += fmt_fixed(buf + n, size - n, tenths, 1);
+    return n + fmt_str(buf + n, size - n, " dB");
+}
+
 // ---------------------------------------------------------------------------
 // SA818 MENU LOGIC
 // ---------------------------------------------------------------------------
@@ -343,18 +791,47 @@ static void menu_on_value_committed(void)
 static const char* menu_atten_get_value(void)
 {
     static char buf[16];
-    snprintf(buf, sizeof(buf), "%.1f dB", attenuator_get());
+    menu_format_atten(buf, sizeof(buf));
     return buf;
 }
 
+// Below 0 dB is Auto, stepping up from there continues by hand from
+// wherever the auto ranging left it
 static void menu_atten_step_value(int step)
 {
+    if (attenuator_is_auto()) {
+        if (step > 0)
+            attenuator_set_auto(false);
+        return;
+    }
+    if (step < 0 && attenuator_get() <= ATTENUATOR_MIN_DB) {
+        attenuator_set_auto(true);
+        return;
+    }
+
     float val = attenuator_get() + (step * 0.5f);  // 0.5 dB per tick
     if (val < ATTENUATOR_MIN_DB) val = ATTENUATOR_MIN_DB;
     if (val > ATTENUATOR_MAX_DB) val = ATTENUATOR_MAX_DB;
     attenuator_set(val);
 }
 
+// Calibration offset of the signal level, 0.5 dB per tick. "+2.5 dB"
+static const char* menu_sig_cal_get_value(void)
+{
+    static char buf[12];
+    int16_t offset = signal_meter_get_offset_db10();
+    size_t n = fmt_str(buf, sizeof(buf), offset > 0 ? "+" : "");
+
+    n += fmt_fixed(buf + n, sizeof(buf) - n, offset, 1);
+    fmt_str(buf + n, sizeof(buf) - n, " dB");
+    return buf;
+}
+
+static void menu_sig_cal_step_value(int step)
+{
+    signal_meter_set_offset_db10((int16_t)(signal_meter_get_offset_db10() + step * 5));
+}
+
 static const char* menu_bandwidth_get_value(void) {
     return S->bandwidth ? "25 kHz" : "12.5 kHz";
 }
@@ -364,20 +841,21 @@ static void menu_bandwidth_step_value(int step) {
 
 static const char* menu_tx_freq_get_value(void) {
     static char buf[16];
-    snprintf(buf, sizeof(buf), "%.4f", S->tx_frequency);
+    fmt_mhz(buf, sizeof(buf), S->tx_frequency);
     return buf;
 }
 static void menu_tx_freq_step_value(int step) {
-    sa818_set_tx_frequency(S->tx_frequency + (step * 0.005f));
+    // One channel per detent
+    sa818_set_tx_frequency((uint32_t)((int32_t)S->tx_frequency + step * (int32_t)sa818_get_raster_hz()));
 }
 
 static const char* menu_rx_freq_get_value(void) {
     static char buf[16];
-    snprintf(buf, sizeof(buf), "%.4f", S->rx_frequency);
+    fmt_mhz(buf, sizeof(buf), S->rx_frequency);
     return buf;
 }
 static void menu_rx_freq_step_value(int step) {
-    sa818_set_rx_frequency(S->rx_frequency + (step * 0.005f));
+    sa818_set_rx_frequency((uint32_t)((int32_t)S->rx_frequency + step * (int32_t)sa818_get_raster_hz()));
 }
 
 static const char* menu_tx_sub_get_value(void) {
@@ -391,12 +869,27 @@ static const char* menu_rx_sub_get_value(void) {
     return S->rx_subaudio;
 }
 static void menu_rx_sub_step_value(int step) {
-    (void)step; // placeholder
+    char code[5];
+    uint8_t detected = ctcss_get_sa818_code(ctcss_get_tone());
+    int32_t value = (int32_t)(S->rx_subaudio[2] - '0') * 10 + (S->rx_subaudio[3] - '0');
+
+    // CTCSS codes only (0000..0038). With no code set the first detent
+    // snaps to the tone the detector hears, after that it steps through
+    // the codes, past the detected one as well.
+    if (S->rx_subaudio[0] != '0' || S->rx_subaudio[1] != '0' || value > 38)
+        value = 0;
+    if (detected && value == 0)
+        value = detected;
+    else
+        value = (value + step + 39) % 39;
+
+    fmt_uint_pad(code, sizeof(code), (uint32_t)value, 4, '0');
+    sa818_set_rx_subaudio(code);
 }
 
 static const char* menu_squelch_get_value(void) {
     static char buf[8];
-    snprintf(buf, sizeof(buf), "%d", S->squelch);
+    fmt_uint(buf, sizeof(buf), S->squelch);
     return buf;
 }
 static void menu_squelch_step_value(int step) {
@@ -405,7 +898,7 @@ static void menu_squelch_step_value(int step) {
 
 static const char* menu_volume_get_value(void) {
     static char buf[8];
-    snprintf(buf, sizeof(buf), "%d", S->volume);
+    fmt_uint(buf, sizeof(buf), S->volume);
     return buf;
 }
 static void menu_volume_step_value(int step) {
@@ -445,11 +938,23 @@ static void menu_tail_step_value(int step) {
 }
 
 static const char* menu_mode_get_value(void) {
+    if (beacon_is_running())
+        return "Beacon";
     return S->mode == SA818_MODE_TX ? "TX" : "RX";
 }
 static void menu_mode_step_value(int step) {
     (void)step;
-    sa818_set_mode(S->mode == SA818_MODE_TX ? SA818_MODE_RX : SA818_MODE_TX);
+    // RX -> TX with the test tone -> Beacon -> RX
+    if (beacon_is_running()) {
+        beacon_stop();
+    } else if (S->mode == SA818_MODE_TX) {
+        testtone_enable(false);
+        sa818_set_mode(SA818_MODE_RX);
+        beacon_start();
+    } else {
+        sa818_set_mode(SA818_MODE_TX);
+        testtone_enable(true);
+    }
 }
 
 static const char* menu_power_get_value(void) {
@@ -459,3 +964,68 @@ static void menu_power_step_value(int step) {
     (void)step;
     sa818_set_power_level(S->power == SA818_POWER_HIGH ? SA818_POWER_LOW : SA818_POWER_HIGH);
 }
+
+// ---------------------------------------------------------------------------
+// BEACON SCHEDULE MENU LOGIC
+// ---------------------------------------------------------------------------
+#define B beacon_get_config()
+
+#define MENU_INTERVAL_STEP_S    10
+#define MENU_INTERVAL_MAX_S     3600
+#define MENU_TONE_MAX_S         60
+#define MENU_ID_EVERY_MAX       10
+
+// Takes effect with the next transmission
+static void menu_beacon_set(uint16_t interval_s, uint16_t tone_s, uint8_t id_every)
+{
+    beacon_config_t c = *B;
+
+    c.interval_s = interval_s;
+    c.tone_s = tone_s;
+    c.id_every = id_every;
+    beacon_set_config(&c);
+}
+
+static int menu_clamp(int val, int min, int max)
+{
+    if (val < min) return min;
+    if (val > max) return max;
+    return val;
+}
+
+static const char* menu_interval_get_value(void) {
+    static char buf[8];
+    size_t n = fmt_uint(buf, sizeof(buf), B->interval_s);
+    fmt_str(buf + n, sizeof(buf) - n, " s");
+    return buf;
+}
+static void menu_interval_step_value(int step) {
+    int val = menu_clamp(B->interval_s + step * MENU_INTERVAL_STEP_S,
+                         MENU_INTERVAL_STEP_S, MENU_INTERVAL_MAX_S);
+    menu_beacon_set((uint16_t)val, B->tone_s, B->id_every);
+}
+
+static const char* menu_tone_time_get_value(void) {
+    static char buf[8];
+    if (B->tone_s == 0)
+        return "Off";
+    size_t n = fmt_uint(buf, sizeof(buf), B->tone_s);
+    fmt_str(buf + n, sizeof(buf) - n, " s");
+    return buf;
+}
+static void menu_tone_time_step_value(int step) {
+    int val = menu_clamp(B->tone_s + step, 0, MENU_TONE_MAX_S);
+    menu_beacon_set(B->interval_s, (uint16_t)val, B->id_every);
+}
+
+static const char* menu_id_every_get_value(void) {
+    static char buf[8];
+    if (B->id_every == 0)
+        return "Never";
+    fmt_uint(buf, sizeof(buf), B->id_every);
+    return buf;
+}
+static void menu_id_every_step_value(int step) {
+    int val = menu_clamp(B->id_every + step, 0, MENU_ID_EVERY_MAX);
+    menu_beacon_set(B->interval_s, B->tone_s, (uint8_t)val);
+}
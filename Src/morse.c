@@ -0,0 +1,298 @@
+/**
+ ******************************************************************************
+ * @file      morse.c
+ * @brief     Streaming CW/MCW Morse decoder on the received audio
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "main.h"
+#include "audio.h"
+#include "menu.h"
+#include "morse.h"
+
+// ---------------------------------------------------------------------------
+// Configuration
+// ---------------------------------------------------------------------------
+
+#define MORSE_MIN_SPAN      64        // tone over floor before keying, log2 Q4 (~12 dB)
+#define MORSE_DIT_MIN_Q4    (2 << 4)  // 16 ms, 75 WPM
+#define MORSE_DIT_MAX_Q4    (30 << 4) // 240 ms, 5 WPM
+#define MORSE_MARK_MAX      125       // segments, 1 s, longer than a dah at 5 WPM
+
+// ---------------------------------------------------------------------------
+// Tables
+// ---------------------------------------------------------------------------
+
+// Goertzel bins over the usual MCW tones, 2 * cos(2 * pi * f / 8 kHz), Q14
+static const int32_t morse_bin_coeff[MORSE_BIN_COUNT] = {
+    30274, 29197, 27939, 26510, 24917, 23170, 21281, 19261
+};
+
+// Code tree: start at 1, every element doubles the index, plus one for a dah
+static const char morse_tree[] =
+    "**ETIANMSURWDKGOHVF*L*PJBXCYZQ**"
+    "54*3***2*******16=/*****7***8*90"
+    "************?********.**********"
+    "*******************,************";
+
+// ---------------------------------------------------------------------------
+// Internal state
+// ---------------------------------------------------------------------------
+
+DTCM_BSS static int32_t bin_s1[MORSE_BIN_COUNT];
+DTCM_BSS static int32_t bin_s2[MORSE_BIN_COUNT];
+static uint8_t segment_count = 0;
+
+// Tone level, its recent peak and floor, log2 of the power in Q4
+static int16_t level_peak = 0;
+static int16_t level_floor = INT16_MAX;
+static uint8_t level_decay = 0;
+
+static bool key_down = false;
+static bool mark_pending = false;     // mark ended, could still be a dropout
+static bool word_done = true;
+static uint16_t mark_len = 0;         // segments
+static uint16_t gap_len = 0;
+
+// Running dit and dah lengths, segments in Q4
+static int32_t dit_q4 = 6 << 4;
+static int32_t dah_q4 = 18 << 4;
+
+static uint8_t code = 1;              // index into morse_tree
+static bool code_overflow = false;
+
+static char text[MORSE_TEXT_LEN + 1];
+static uint8_t text_len = 0;
+static uint32_t text_count = 0;
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+
+static int16_t morse_log2_q4(uint64_t x)
+{
+    if (x < 2)
+        return 0;
+
+    int16_t msb = 63 - __builtin_clzll(x);
+    uint32_t frac = (msb >= 4) ? (uint32_t)(x >> (msb - 4)) : (uint32_t)(x << (4 - msb));
+    return (int16_t)((msb << 4) | (frac & 0x0F));
+}
+
+static void morse_add_char(char c)
+{
+    if (text_len == MORSE_TEXT_LEN) {
+        memmove(text, text + 1, MORSE_TEXT_LEN - 1);
+        text_len--;
+    }
+    text[text_len++] = c;
+    text[text_len] = '\0';
+    text_count++;
+
+    menu_update_display_async();
+}
+
+static void morse_end_character(void)
+{
+    morse_add_char(code_overflow ? '*' : morse_tree[code]);
+    code = 1;
+    code_overflow = false;
+}
+
+// Sorts a mark into dit or dah and follows the keying speed
+static void morse_add_element(uint16_t len)
+{
+    int32_t len_q4 = (int32_t)len << 4;
+
+    if (len_q4 < dit_q4 / 3)
+        return;  // click or noise burst
+
+    // Far shorter than a dit, the keying got faster. Averaging would not
+    // get there: with dits and dahs both under the threshold the dit
+    // settles between them.
+    if (len_q4 < dit_q4 * 5 / 8) {
+        dit_q4 = len_q4;
+        dah_q4 = 3 * len_q4;
+    }
+
+    bool dah = len_q4 > (dit_q4 + dah_q4) / 2;
+
+    // A dah is 3 dits, keep it between 2 and 4 so both follow the speed
+    if (dah) {
+        dah_q4 += (len_q4 - dah_q4) / 4;
+        if (dah_q4 < 2 * dit_q4 || dah_q4 > 4 * dit_q4)
+            dit_q4 = dah_q4 / 3;
+    } else {
+        dit_q4 += (len_q4 - dit_q4) / 4;
+        if (dah_q4 < 2 * dit_q4 || dah_q4 > 4 * dit_q4)
+            dah_q4 = 3 * dit_q4;
+    }
+
+    if (dit_q4 < MORSE_DIT_MIN_Q4) dit_q4 = MORSE_DIT_MIN_Q4;
+    if (dit_q4 > MORSE_DIT_MAX_Q4) dit_q4 = MORSE_DIT_MAX_Q4;
+
+    if (code >= 64)
+        code_overflow = true;
+    else
+        code = (uint8_t)(code * 2 + (dah ? 1 : 0));
+}
+
+static void morse_key(bool key)
+{
+    if (key) {
+        if (!key_down) {
+            // A dropout shorter than half a dit is part of the mark
+            if (mark_pending)
+                mark_len += gap_len;
+            else
+                mark_len = 0;
+            mark_pending = false;
+            word_done = false;
+            gap_len = 0;
+        }
+        mark_len++;
+    } else {
+        if (key_down)
+            mark_pending = true;
+        if (gap_len < UINT16_MAX)
+            gap_len++;
+
+        int32_t gap_q4 = (int32_t)gap_len << 4;
+
+        if (mark_pending && gap_q4 >= dit_q4 / 2) {
+            morse_add_element(mark_len);
+            mark_pending = false;
+        }
+        // Gaps are 1 dit inside a character, 3 between and 7 between words
+        if (!mark_pending && code > 1 && gap_q4 >= 2 * dit_q4)
+            morse_end_character();
+        if (!word_done && gap_q4 >= 5 * dit_q4) {
+            if (text_len > 0 && text[text_len - 1] != ' ')
+                morse_add_char(' ');
+            word_done = true;
+        }
+    }
+    key_down = key;
+}
+
+static void morse_segment_done(void)
+{
+    uint64_t best = 0;
+
+    // Strongest bin, the tone does not have to be known up front
+    for (uint8_t i = 0; i < MORSE_BIN_COUNT; i++) {
+        int64_t s1 = bin_s1[i];
+        int64_t s2 = bin_s2[i];
+        int64_t power = s1 * s1 + s2 * s2 - ((morse_bin_coeff[i] * s1 >> 14) * s2);
+
+        if (power > 0 && (uint64_t)power > best)
+            best = (uint64_t)power;
+        bin_s1[i] = 0;
+        bin_s2[i] = 0;
+    }
+
+    int16_t level = morse_log2_q4(best);
+
+    // A mark longer than any dah is a step in the noise level, when the
+    // squelch opens for example. Drop it and start over from there.
+    if (key_down && mark_len > MORSE_MARK_MAX) {
+        key_down = false;
+        level_floor = INT16_MAX;
+    }
+
+    // The peak jumps to new highs and creeps down. The floor follows the
+    // noise between the marks and falls quickly. It is not the lowest
+    // noise segment: that lies so far below the noise that the noise
+    // itself would key.
+    if (level > level_peak)
+        level_peak = level;
+    if (level_floor == INT16_MAX)
+        level_floor = level;
+    else if (level < level_floor)
+        level_floor += (level - level_floor) / 4;
+    else if (!key_down)
+        level_floor += (level - level_floor + 15) / 16;
+    if (++level_decay >= 4) {
+        level_decay = 0;
+        if (level_peak > level_floor)
+            level_peak--;
+    }
+
+    int16_t span = level_peak - level_floor;
+    bool key = key_down;
+
+    if (span < MORSE_MIN_SPAN) {
+        key = false;
+    } else {
+        int16_t mid = level_floor + span / 2;
+        int16_t hysteresis = span / 8;
+
+        if (level > mid + hysteresis)
+            key = true;
+        else if (level < mid - hysteresis)
+            key = false;
+    }
+
+    morse_key(key);
+}
+
+ITCM_TEXT static void morse_on_block(const int16_t *samples, uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++) {
+        int32_t x = samples[i];
+
+        for (uint8_t b = 0; b < MORSE_BIN_COUNT; b++) {
+            int32_t s = x + (int32_t)(((int64_t)morse_bin_coeff[b] * bin_s1[b]) >> 14) - bin_s2[b];
+            bin_s2[b] = bin_s1[b];
+            bin_s1[b] = s;
+        }
+
+        if (++segment_count == MORSE_SEGMENT) {
+            morse_segment_done();
+            segment_count = 0;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+
+void morse_init(void)
+{
+    text[0] = '\0';
+    audio_subscribe(morse_on_block);
+}
+
+const char *morse_get_text(void)
+{
+    return text;
+}
+
+uint32_t morse_get_text_count(void)
+{
+    return text_count;
+}
+
+uint8_t morse_get_wpm(void)
+{
+    // A dit is 1200 ms / WPM, a segment is 8 ms
+    return (uint8_t)((2400 + dit_q4 / 2) / dit_q4);
+}
+
+uint8_t morse_encode(char c)
+{
+    if (c >= 'a' && c <= 'z')
+        c = (char)(c - 'a' + 'A');
+
+    for (uint8_t i = 2; i < sizeof(morse_tree) - 1; i++) {
+        if (morse_tree[i] == c && c != '*')
+            return i;
+    }
+    return 0;
+}
@@ -1,7 +1,7 @@
 /**
  ******************************************************************************
  * @file      adc.c
- * @brief     short description
+ * @brief     ADC1 audio capture, triggered by TIM6 into a circular DMA buffer
  * @version   version
  * @author    R. van Renswoude
  * @date      2025
@@ -25,6 +25,7 @@
 
 #include "stm32h7xx_hal.h"
 #include "gpio.h"
+#include "adc.h"
 
 /* Defines -------------------------------------------------------------------*/
 
@@ -34,11 +35,86 @@
 
 ADC_HandleTypeDef hadc1;
 DMA_HandleTypeDef hdma_adc1;
+TIM_HandleTypeDef htim6;
 
 /* Function prototypes ---------------------------------------------------------*/
 
+static void adc1_init(void);
+static void adc_trigger_timer_init(uint32_t sample_rate);
+
 /* Functions -------------------------------------------------------------------*/
 
+/**
+  * @brief Set up ADC1 and its sample clock
+  * @param sample_rate conversions per second, made by TIM6
+  */
+void audio_adc_init(uint32_t sample_rate)
+{
+  adc_trigger_timer_init(sample_rate);
+  adc1_init();
+
+  // Offset calibration, the ADC has to be disabled
+  if (HAL_ADCEx_Calibration_Start(&hadc1, ADC_CALIB_OFFSET, ADC_SINGLE_ENDED) != HAL_OK)
+  {
+    //Error_Handler();
+  }
+}
+
+/**
+  * @brief Start converting into a circular buffer
+  * @param buffer  samples, DMA reachable memory (see DMA_BUFFER)
+  * @param length  samples in the buffer, the half and full transfer
+  *                callbacks fire at length/2 and length
+  */
+uint32_t audio_adc_start(uint16_t *buffer, uint32_t length)
+{
+  uint32_t status = HAL_ADC_Start_DMA(&hadc1, (uint32_t *)buffer, length);
+
+  if (status == HAL_OK)
+    status = HAL_TIM_Base_Start(&htim6);
+
+  return status;
+}
+
+void audio_adc_stop(void)
+{
+  HAL_TIM_Base_Stop(&htim6);
+  HAL_ADC_Stop_DMA(&hadc1);
+}
+
+/**
+  * @brief TIM6 Initialization Function, update event is the ADC trigger
+  * @param sample_rate trigger rate in Hz
+  */
+static void adc_trigger_timer_init(uint32_t sample_rate)
+{
+  TIM_MasterConfigTypeDef sMasterConfig = {0};
+  uint32_t timer_clock = HAL_RCC_GetPCLK1Freq();
+
+  // APB1 timers run at twice PCLK1 when APB1 is divided
+  if ((RCC->D2CFGR & RCC_D2CFGR_D2PPRE1) != RCC_APB1_DIV1)
+    timer_clock *= 2;
+
+  // Clock enabled here, HAL_TIM_Base_MspInit only handles TIM1
+  __HAL_RCC_TIM6_CLK_ENABLE();
+
+  htim6.Instance = TIM6;
+  htim6.Init.Prescaler = 0;
+  htim6.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim6.Init.Period = (timer_clock + sample_rate / 2) / sample_rate - 1;
+  htim6.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+  if (HAL_TIM_Base_Init(&htim6) != HAL_OK)
+  {
+    //Error_Handler();
+  }
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_UPDATE;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim6, &sMasterConfig) != HAL_OK)
+  {
+    //Error_Handler();
+  }
+}
+
 /**
   * @brief ADC1 Initialization Function
   * @param None
@@ -59,10 +135,10 @@ static void adc1_init(void)
   hadc1.Init.ContinuousConvMode = DISABLE;
   hadc1.Init.NbrOfConversion = 1;
   hadc1.Init.DiscontinuousConvMode = DISABLE;
-  hadc1.Init.ExternalTrigConv = ADC_SOFTWARE_START;
-  hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_NONE;
-  hadc1.Init.ConversionDataManagement = ADC_CONVERSIONDATA_DR;
-  hadc1.Init.Overrun = ADC_OVR_DATA_PRESERVED;
+  hadc1.Init.ExternalTrigConv = ADC_EXTERNALTRIG_T6_TRGO;
+  hadc1.Init.ExternalTrigConvEdge = ADC_EXTERNALTRIGCONVEDGE_RISING;
+  hadc1.Init.ConversionDataManagement = ADC_CONVERSIONDATA_DMA_CIRCULAR;
+  hadc1.Init.Overrun = ADC_OVR_DATA_OVERWRITTEN;
   hadc1.Init.LeftBitShift = ADC_LEFTBITSHIFT_NONE;
   hadc1.Init.OversamplingMode = DISABLE;
   hadc1.Init.Oversampling.Ratio = 1;
@@ -81,7 +157,7 @@ static void adc1_init(void)
   // Configure Regular Channel
   sConfig.Channel = ADC_CHANNEL_3;
   sConfig.Rank = ADC_REGULAR_RANK_1;
-  sConfig.SamplingTime = ADC_SAMPLETIME_1CYCLE_5;
+  sConfig.SamplingTime = ADC_SAMPLETIME_64CYCLES_5;  // audio output is not a low impedance source
   sConfig.SingleDiff = ADC_SINGLE_ENDED;
   sConfig.OffsetNumber = ADC_OFFSET_NONE;
   sConfig.Offset = 0;
@@ -0,0 +1,92 @@
+/**
+ ******************************************************************************
+ * @file      beacon_timer.c
+ * @brief     TIM17 periodic interrupt that paces the beacon engine
+ * @version   version
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details detailed description
+ ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; Copyright (c) 2025 Ruben van Renswoude.
+ * All rights reserved.</center></h2>
+ *
+ ******************************************************************************
+ */
+/**
+ * @addtogroup  Peripherals
+ * @{
+ */
+
+
+/* Includes -------------------------------------------------------------------*/
+
+#include "stm32h7xx_hal.h"
+#include "beacon_timer.h"
+
+/* Defines -------------------------------------------------------------------*/
+
+#define BEACON_TIMER_COUNT_HZ   1000000   // counter clock after the prescaler
+
+/* Typedefs -------------------------------------------------------------------*/
+
+/* Variables -------------------------------------------------------------------*/
+
+TIM_HandleTypeDef htim17;
+
+/* Function prototypes ---------------------------------------------------------*/
+
+static uint32_t beacon_timer_clock(void);
+
+/* Functions -------------------------------------------------------------------*/
+
+/**
+  * @brief TIM17 Initialization Function, update interrupt at tick_hz
+  * @param tick_hz interrupts per second, 16 Hz .. 1 MHz
+  * @retval None
+  */
+void beacon_timer_init(uint32_t tick_hz)
+{
+  // Clock enabled here, HAL_TIM_Base_MspInit only handles TIM1
+  __HAL_RCC_TIM17_CLK_ENABLE();
+
+  htim17.Instance = TIM17;
+  htim17.Init.Prescaler = beacon_timer_clock() / BEACON_TIMER_COUNT_HZ - 1;
+  htim17.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim17.Init.Period = BEACON_TIMER_COUNT_HZ / tick_hz - 1;
+  htim17.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim17.Init.RepetitionCounter = 0;
+  htim17.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+  if (HAL_TIM_Base_Init(&htim17) != HAL_OK)
+  {
+    //Error_Handler();
+  }
+
+  // Above the DMA and UART interrupts, a late tick shifts the keying
+  HAL_NVIC_SetPriority(TIM17_IRQn, 4, 0);
+  HAL_NVIC_EnableIRQ(TIM17_IRQn);
+}
+
+void beacon_timer_start(void)
+{
+  __HAL_TIM_SET_COUNTER(&htim17, 0);
+  HAL_TIM_Base_Start_IT(&htim17);
+}
+
+void beacon_timer_stop(void)
+{
+  HAL_TIM_Base_Stop_IT(&htim17);
+}
+
+// APB2 timers run at twice PCLK2 when APB2 is divided
+static uint32_t beacon_timer_clock(void)
+{
+  uint32_t timer_clock = HAL_RCC_GetPCLK2Freq();
+
+  if ((RCC->D2CFGR & RCC_D2CFGR_D2PPRE2) != RCC_APB2_DIV1)
+    timer_clock *= 2;
+
+  return timer_clock;
+}
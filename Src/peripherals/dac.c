@@ -1,7 +1,7 @@
 /**
  ******************************************************************************
  * @file      dac.c
- * @brief     short description
+ * @brief     DAC1 channel 2 waveform output, TIM7 paced circular DMA
  * @version   version
  * @author    R. van Renswoude
  * @date      2025
@@ -23,12 +23,200 @@
 
 /* Includes -------------------------------------------------------------------*/
 
+#include "stm32h7xx_hal.h"
+#include "gpio.h"
+#include "dac.h"
+
 /* Defines -------------------------------------------------------------------*/
 
 /* Typedefs -------------------------------------------------------------------*/
 
 /* Variables -------------------------------------------------------------------*/
 
+DAC_HandleTypeDef hdac1;
+DMA_HandleTypeDef hdma_dac1_ch2;
+TIM_HandleTypeDef htim7;
+
 /* Function prototypes ---------------------------------------------------------*/
 
+static uint32_t dac_timer_clock(void);
+
 /* Functions -------------------------------------------------------------------*/
+
+/**
+  * @brief DAC1 and TIM7 Initialization Function, output at mid scale
+  * @param None
+  * @retval None
+  */
+void dac_wave_init(void)
+{
+  DAC_ChannelConfTypeDef sConfig = {0};
+  TIM_MasterConfigTypeDef sMasterConfig = {0};
+
+  // Clock enabled here, HAL_TIM_Base_MspInit only handles TIM1
+  __HAL_RCC_TIM7_CLK_ENABLE();
+
+  htim7.Instance = TIM7;
+  htim7.Init.Prescaler = 0;
+  htim7.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim7.Init.Period = 0xFFFF;
+  htim7.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;  // rate changes take effect on the next update
+  if (HAL_TIM_Base_Init(&htim7) != HAL_OK)
+  {
+    //Error_Handler();
+  }
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_UPDATE;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  if (HAL_TIMEx_MasterConfigSynchronization(&htim7, &sMasterConfig) != HAL_OK)
+  {
+    //Error_Handler();
+  }
+
+  hdac1.Instance = DAC1;
+  if (HAL_DAC_Init(&hdac1) != HAL_OK)
+  {
+    //Error_Handler();
+  }
+
+  sConfig.DAC_SampleAndHold = DAC_SAMPLEANDHOLD_DISABLE;
+  sConfig.DAC_Trigger = DAC_TRIGGER_T7_TRGO;
+  sConfig.DAC_OutputBuffer = DAC_OUTPUTBUFFER_ENABLE;
+  sConfig.DAC_ConnectOnChipPeripheral = DAC_CHIPCONNECT_EXTERNAL;
+  sConfig.DAC_UserTrimming = DAC_TRIMMING_FACTORY;
+  if (HAL_DAC_ConfigChannel(&hdac1, &sConfig, DAC_CHANNEL_2) != HAL_OK)
+  {
+    //Error_Handler();
+  }
+
+  dac_wave_stop();
+}
+
+/**
+  * @brief Play a table over and over, the DMA feeds one sample per TIM7 update
+  * @param table       12 bit right aligned samples, DMA reachable memory
+  *                    (see DMA_BUFFER), read for as long as the output runs
+  * @param length      samples in the table
+  * @param sample_rate samples per second
+  */
+uint32_t dac_wave_start(const uint16_t *table, uint32_t length, uint32_t sample_rate)
+{
+  HAL_TIM_Base_Stop(&htim7);
+  HAL_DAC_Stop_DMA(&hdac1, DAC_CHANNEL_2);
+  dac_wave_set_sample_rate(sample_rate);
+
+  uint32_t status = HAL_DAC_Start_DMA(&hdac1, DAC_CHANNEL_2, (const uint32_t *)table, length, DAC_ALIGN_12B_R);
+
+  // Nothing to do per half or full table, keep the CPU out of it
+  __HAL_DMA_DISABLE_IT(&hdma_dac1_ch2, DMA_IT_HT | DMA_IT_TC);
+
+  if (status == HAL_OK)
+    status = HAL_TIM_Base_Start(&htim7);
+
+  return status;
+}
+
+/**
+  * @brief Stop the waveform and park the output at mid scale
+  */
+void dac_wave_stop(void)
+{
+  HAL_TIM_Base_Stop(&htim7);
+  HAL_DAC_Stop_DMA(&hdac1, DAC_CHANNEL_2);
+
+  // The channel only converts on a TIM7 trigger, one update event moves
+  // the parked value to the output
+  HAL_DAC_SetValue(&hdac1, DAC_CHANNEL_2, DAC_ALIGN_12B_R, DAC_WAVE_MID);
+  HAL_DAC_Start(&hdac1, DAC_CHANNEL_2);
+  htim7.Instance->EGR = TIM_EGR_UG;
+}
+
+/**
+  * @brief Change the sample rate of a running waveform without a restart
+  */
+void dac_wave_set_sample_rate(uint32_t sample_rate)
+{
+  if (sample_rate == 0)
+    return;
+
+  uint32_t period = (dac_timer_clock() + sample_rate / 2) / sample_rate;
+  if (period < 2) period = 2;
+  if (period > 0x10000) period = 0x10000;
+
+  __HAL_TIM_SET_AUTORELOAD(&htim7, period - 1);
+}
+
+// APB1 timers run at twice PCLK1 when APB1 is divided
+static uint32_t dac_timer_clock(void)
+{
+  uint32_t timer_clock = HAL_RCC_GetPCLK1Freq();
+
+  if ((RCC->D2CFGR & RCC_D2CFGR_D2PPRE1) != RCC_APB1_DIV1)
+    timer_clock *= 2;
+
+  return timer_clock;
+}
+
+/**
+  * @brief DAC MSP Initialization
+  * This function configures the hardware resources used in this example
+  * @param hdac: DAC handle pointer
+  * @retval None
+  */
+void HAL_DAC_MspInit(DAC_HandleTypeDef* hdac)
+{
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+  if(hdac->Instance==DAC1)
+  {
+    // Peripheral clock enable
+    __HAL_RCC_DAC12_CLK_ENABLE();
+
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    // DAC1 GPIO Configuration
+    // PA5     ------> DAC1_OUT2
+    GPIO_InitStruct.Pin = SA818_AUDIO_IN_Pin;
+    GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    HAL_GPIO_Init(SA818_AUDIO_IN_GPIO_Port, &GPIO_InitStruct);
+
+    // DAC1 DMA Init
+    // DAC1_CH2 Init
+    hdma_dac1_ch2.Instance = DMA1_Stream1;
+    hdma_dac1_ch2.Init.Request = DMA_REQUEST_DAC1_CH2;
+    hdma_dac1_ch2.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_dac1_ch2.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_dac1_ch2.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_dac1_ch2.Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+    hdma_dac1_ch2.Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    hdma_dac1_ch2.Init.Mode = DMA_CIRCULAR;
+    hdma_dac1_ch2.Init.Priority = DMA_PRIORITY_MEDIUM;
+    hdma_dac1_ch2.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(&hdma_dac1_ch2) != HAL_OK)
+    {
+      //Error_Handler();
+    }
+
+    __HAL_LINKDMA(hdac,DMA_Handle2,hdma_dac1_ch2);
+  }
+}
+
+/**
+  * @brief DAC MSP De-Initialization
+  * This function freeze the hardware resources used in this example
+  * @param hdac: DAC handle pointer
+  * @retval None
+  */
+void HAL_DAC_MspDeInit(DAC_HandleTypeDef* hdac)
+{
+  if(hdac->Instance==DAC1)
+  {
+    // Peripheral clock disable
+    __HAL_RCC_DAC12_CLK_DISABLE();
+
+    // DAC1 GPIO Configuration
+    // PA5     ------> DAC1_OUT2
+    HAL_GPIO_DeInit(SA818_AUDIO_IN_GPIO_Port, SA818_AUDIO_IN_Pin);
+
+    // DAC1 DMA DeInit
+    HAL_DMA_DeInit(hdac->DMA_Handle2);
+  }
+}
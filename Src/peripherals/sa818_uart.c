@@ -27,11 +27,19 @@
 #include <stdbool.h>
 
 #include "stm32h7xx_hal.h"
+#include "main.h"
 #include "gpio.h"
+#include "ring_buffer.h"
+#include "scheduler.h"
+#include "sa818_uart.h"
 
 /* Defines -------------------------------------------------------------------*/
 
 #define SA818_UART_TIMEOUT (200)
+#define SA818_UART_DMA_BUF_LEN    (64)    // circular DMA target, IRQ at half/full/idle
+#define SA818_UART_RING_LEN       (256)   // must be a power of two
+#define SA818_UART_LINE_MAX_LEN   (96)
+#define SA818_UART_TX_BUF_LEN     (64)    // longest command, copied for the DMA
 
 /* Typedefs -------------------------------------------------------------------*/
 
@@ -42,11 +50,22 @@ DMA_HandleTypeDef hdma_usart3_rx;
 DMA_HandleTypeDef hdma_usart3_tx;
 
 static volatile bool sa818_tx_complete = true;
-static volatile bool sa818_rx_complete = true;
-static volatile uint16_t sa818_rx_len = 0;
+
+// Receive path: circular DMA -> ring buffer (IRQ) -> line splitter (task)
+DMA_BUFFER static uint8_t sa818_rx_dma_buf[SA818_UART_DMA_BUF_LEN];
+DMA_BUFFER static uint8_t sa818_tx_dma_buf[SA818_UART_TX_BUF_LEN];
+static uint16_t sa818_rx_dma_pos = 0;     // first DMA byte not yet copied
+DTCM_BSS static uint8_t sa818_rx_ring_buf[SA818_UART_RING_LEN];  // CPU only, DMA fills the buffer above
+static ring_buffer_t sa818_rx_ring;
+
+static char sa818_line_buf[SA818_UART_LINE_MAX_LEN];
+static size_t sa818_line_len = 0;
+static bool sa818_line_overflow = false;
 
 /* Function prototypes ---------------------------------------------------------*/
 
+static void sa818_uart_start_rx(void);
+
 /* Functions -------------------------------------------------------------------*/
 
 /**
@@ -83,69 +102,107 @@ void sa818_uart_init(void)
   {
     //Error_Handler();
   }
+
+  ring_buffer_init(&sa818_rx_ring, sa818_rx_ring_buf, sizeof(sa818_rx_ring_buf));
+  sa818_line_len = 0;
+  sa818_line_overflow = false;
+  sa818_uart_start_rx();
+}
+
+/**
+  * @brief Start the always-running circular receive DMA
+  * @note  HAL reports the DMA write position at half transfer, full transfer
+  *        and on line idle, every report is copied into the ring buffer.
+  */
+static void sa818_uart_start_rx(void)
+{
+  sa818_rx_dma_pos = 0;
+  HAL_UARTEx_ReceiveToIdle_DMA(&sa818_uart_handle, sa818_rx_dma_buf, sizeof(sa818_rx_dma_buf));
 }
 
 void sa818_uart_transmit(const char* cmd) {
   HAL_UART_Transmit(&sa818_uart_handle, (uint8_t*)cmd, strlen(cmd), SA818_UART_TIMEOUT);
 }
 
-size_t sa818_uart_receive(char *rxbuf, size_t size, uint32_t timeout)
+// Line splitter -------------------------------------------------------
+size_t sa818_uart_read_line(char *line, size_t size)
 {
-    uint16_t rx_len = 0;
-    HAL_StatusTypeDef status;
-
-    memset(rxbuf, 0, size);
+    uint8_t c;
 
-    status = HAL_UARTEx_ReceiveToIdle(&sa818_uart_handle,
-                                      (uint8_t *)rxbuf,
-                                      size,
-                                      &rx_len,
-                                      timeout);
-
-    if (status == HAL_OK || status == HAL_TIMEOUT) {
-        return rx_len;  // number of bytes actually received
-    } else {
+    if (line == NULL || size == 0)
         return 0;
+
+    while (ring_buffer_read_byte(&sa818_rx_ring, &c)) {
+        if (c == '\r')
+            continue;
+
+        if (c != '\n') {
+            if (sa818_line_len < sizeof(sa818_line_buf) - 1)
+                sa818_line_buf[sa818_line_len++] = (char)c;
+            else
+                sa818_line_overflow = true;
+            continue;
+        }
+
+        // End of line, skip empty and truncated ones
+        size_t len = sa818_line_len;
+        bool overflow = sa818_line_overflow;
+        sa818_line_len = 0;
+        sa818_line_overflow = false;
+
+        if (len == 0 || overflow)
+            continue;
+
+        if (len > size - 1)
+            len = size - 1;
+        memcpy(line, sa818_line_buf, len);
+        line[len] = '\0';
+        return len;
     }
+
+    return 0;
+}
+
+size_t sa818_uart_receive_line(char *line, size_t size, uint32_t timeout)
+{
+    uint32_t start = HAL_GetTick();
+
+    do {
+        size_t len = sa818_uart_read_line(line, size);
+        if (len > 0)
+            return len;
+    } while (HAL_GetTick() - start < timeout);
+
+    return 0;
 }
 
 void sa818_uart_flush(void)
 {
-    __HAL_UART_CLEAR_OREFLAG(&sa818_uart_handle);  // clear overrun
-    __HAL_UART_CLEAR_NEFLAG(&sa818_uart_handle);   // clear noise flag
-    __HAL_UART_CLEAR_FEFLAG(&sa818_uart_handle);   // clear framing error
-    __HAL_UART_CLEAR_PEFLAG(&sa818_uart_handle);   // clear parity error
-
-    // Read out any pending bytes in RX FIFO
-    uint8_t dummy;
-    while (__HAL_UART_GET_FLAG(&sa818_uart_handle, UART_FLAG_RXNE) != RESET) {
-        dummy = (uint8_t)(sa818_uart_handle.Instance->RDR);
-        (void)dummy;
-    }
+    ring_buffer_flush(&sa818_rx_ring);
+    sa818_line_len = 0;
+    sa818_line_overflow = false;
+}
+
+uint32_t sa818_uart_rx_dropped(void)
+{
+    return sa818_rx_ring.dropped;
 }
 
 // TX DMA --------------------------------------------------------------
 void sa818_uart_tx_dma(const char *data, uint16_t len)
 {
-    if (len == 0 || data == NULL) return;
+    if (len == 0 || data == NULL || len > SA818_UART_TX_BUF_LEN) return;
 
     // Wait if a previous transfer is still running
     if (!sa818_tx_complete)
         return;
 
-    sa818_tx_complete = false;
-    HAL_UART_Transmit_DMA(&sa818_uart_handle, (uint8_t*)data, len);
-}
-
-// RX DMA --------------------------------------------------------------
-void sa818_uart_rx_dma(uint8_t *buf, uint16_t len)
-{
-    HAL_UART_AbortReceive(&sa818_uart_handle);
-    sa818_rx_complete = false;
-    sa818_rx_len = 0;
+    // Send from the uncached DMA buffer, the caller's copy may still be
+    // sitting in the D-cache
+    memcpy(sa818_tx_dma_buf, data, len);
 
-    HAL_UARTEx_ReceiveToIdle_DMA(&sa818_uart_handle, buf, len);
-    __HAL_DMA_DISABLE_IT(sa818_uart_handle.hdmarx, DMA_IT_HT); // disable half-transfer
+    sa818_tx_complete = false;
+    HAL_UART_Transmit_DMA(&sa818_uart_handle, sa818_tx_dma_buf, len);
 }
 
 // Status checks -------------------------------------------------------
@@ -154,58 +211,52 @@ bool sa818_uart_tx_done(void)
     return sa818_tx_complete;
 }
 
-bool sa818_uart_rx_done(void)
-{
-    return sa818_rx_complete;
-}
-
-int sa818_uart_rx_length(void)
-{
-    return sa818_rx_len;
-}
-
-void sa818_uart_abort_rx(void)
-{
-    HAL_UART_AbortReceive(&sa818_uart_handle);
-    sa818_rx_complete = true;
-    sa818_rx_len = 0;
-}
-
 // ---------------------------------------------------------------------------
 // HAL Callbacks
 // ---------------------------------------------------------------------------
-void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+ITCM_TEXT void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
 {
-    if (huart->Instance == USART3)
+    if (huart->Instance == USART3) {
         sa818_tx_complete = true;
-}
-
-void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
-{
-    if (huart->Instance == USART3)
-    {
-        sa818_rx_complete = true;
-        // If full-length DMA completed (not idle)
-        sa818_rx_len = huart->RxXferSize;
+        scheduler_post(SCHEDULER_EVENT_SA818);
     }
 }
 
-void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t size)
+// size is the DMA write position inside sa818_rx_dma_buf, everything
+// between the previous position and size is new
+ITCM_TEXT void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t size)
 {
-    if (huart->Instance == USART3)
-    {
-        sa818_rx_complete = true;
-        sa818_rx_len = size;
+    if (huart->Instance != USART3)
+        return;
+
+    if (size > sa818_rx_dma_pos) {
+        ring_buffer_write(&sa818_rx_ring, &sa818_rx_dma_buf[sa818_rx_dma_pos],
+                          size - sa818_rx_dma_pos);
+    } else if (size < sa818_rx_dma_pos) {
+        // Wrapped without a full transfer report in between
+        ring_buffer_write(&sa818_rx_ring, &sa818_rx_dma_buf[sa818_rx_dma_pos],
+                          SA818_UART_DMA_BUF_LEN - sa818_rx_dma_pos);
+        ring_buffer_write(&sa818_rx_ring, sa818_rx_dma_buf, size);
     }
+
+    sa818_rx_dma_pos = (size >= SA818_UART_DMA_BUF_LEN) ? 0 : size;
+    scheduler_post(SCHEDULER_EVENT_SA818);
 }
 
 void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
 {
     if (huart->Instance == USART3)
     {
-        sa818_tx_complete = true;
-        sa818_rx_complete = true;
-        sa818_rx_len = 0;
+        // Only a TX error ends the transmission, the HAL then puts gState
+        // back to ready. An RX error leaves a running TX DMA busy.
+        if (huart->gState == HAL_UART_STATE_READY)
+            sa818_tx_complete = true;
+
+        // Overrun and DMA errors stop the reception, restart it
+        if (huart->RxState == HAL_UART_STATE_READY)
+            sa818_uart_start_rx();
+
+        scheduler_post(SCHEDULER_EVENT_SA818);
     }
 }
 
@@ -251,7 +302,7 @@ void HAL_UART_MspInit(UART_HandleTypeDef* huart)
     hdma_usart3_rx.Init.MemInc = DMA_MINC_ENABLE;
     hdma_usart3_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
     hdma_usart3_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
-    hdma_usart3_rx.Init.Mode = DMA_NORMAL;
+    hdma_usart3_rx.Init.Mode = DMA_CIRCULAR;
     hdma_usart3_rx.Init.Priority = DMA_PRIORITY_HIGH;
     hdma_usart3_rx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
     if (HAL_DMA_Init(&hdma_usart3_rx) != HAL_OK)
@@ -23,19 +23,44 @@
 
 /* Includes -------------------------------------------------------------------*/
 
+#include <string.h>
+
 #include "stm32h7xx_hal.h"
+#include "main.h"
 #include "spi.h"
+#include "gpio.h"
+#include "scheduler.h"
 
 /* Defines -------------------------------------------------------------------*/
 
+#define DISPLAY_SPI_QUEUE_LEN     (32)
+
 /* Typedefs -------------------------------------------------------------------*/
 
+// One queued transfer, short data is copied so callers may pass stack
+// variables, longer data is sent from the caller's buffer
+typedef struct {
+  const uint8_t *data;
+  uint16_t len;
+  bool command;   // RS low while sending
+  uint8_t inline_data[DISPLAY_SPI_INLINE_LEN];
+} display_spi_xfer_t;
+
 /* Variables -------------------------------------------------------------------*/
 
 SPI_HandleTypeDef display_spi_handle;
+DMA_HandleTypeDef hdma_spi4_tx;
+
+// The DMA sends inline_data straight from the queue
+DMA_BUFFER static display_spi_xfer_t display_spi_queue[DISPLAY_SPI_QUEUE_LEN];
+static volatile uint8_t display_spi_queue_head = 0;   // transfer on the wire
+static volatile uint8_t display_spi_queue_count = 0;
+static volatile bool display_spi_dma_active = false;
 
 /* Function prototypes ---------------------------------------------------------*/
 
+static void display_spi_start_next(void);
+
 /* Functions -------------------------------------------------------------------*/
 
 /**
@@ -84,6 +109,121 @@ uint32_t display_spi_receive(uint8_t *data, uint16_t size, uint32_t timeout) {
   return HAL_SPI_Receive(&display_spi_handle, data, size, timeout);
 }
 
+/**
+  * @brief Queue a transfer for the DMA, returns right away
+  * @param command true to send with RS low (register), false for data
+  * @param data    up to DISPLAY_SPI_INLINE_LEN bytes are copied, longer
+  *                buffers must stay valid until display_spi_busy() is false
+  * @retval false if the queue is full
+  */
+bool display_spi_queue_transfer(bool command, const uint8_t *data, uint16_t len)
+{
+  if (data == NULL || len == 0)
+    return true;
+
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+
+  // Append short data to the last queued data transfer that has not been
+  // started yet, the window setup sends its arguments one byte at a time
+  if (!command && len <= DISPLAY_SPI_INLINE_LEN && display_spi_queue_count > 1) {
+    display_spi_xfer_t *last = &display_spi_queue[(display_spi_queue_head + display_spi_queue_count - 1) % DISPLAY_SPI_QUEUE_LEN];
+    if (!last->command && last->data == NULL && last->len + len <= DISPLAY_SPI_INLINE_LEN) {
+      memcpy(&last->inline_data[last->len], data, len);
+      last->len += len;
+      __set_PRIMASK(primask);
+      return true;
+    }
+  }
+
+  if (display_spi_queue_count >= DISPLAY_SPI_QUEUE_LEN) {
+    __set_PRIMASK(primask);
+    return false;
+  }
+
+  display_spi_xfer_t *xfer = &display_spi_queue[(display_spi_queue_head + display_spi_queue_count) % DISPLAY_SPI_QUEUE_LEN];
+  xfer->command = command;
+  xfer->len = len;
+  if (len <= DISPLAY_SPI_INLINE_LEN) {
+    memcpy(xfer->inline_data, data, len);
+    xfer->data = NULL;
+  } else {
+    xfer->data = data;
+  }
+  display_spi_queue_count++;
+
+  if (!display_spi_dma_active) {
+    HAL_GPIO_WritePin(LCD_CS_GPIO_Port, LCD_CS_Pin, GPIO_PIN_RESET);
+    display_spi_start_next();
+  }
+
+  __set_PRIMASK(primask);
+  return true;
+}
+
+uint8_t display_spi_queue_free(void)
+{
+  return DISPLAY_SPI_QUEUE_LEN - display_spi_queue_count;
+}
+
+bool display_spi_busy(void)
+{
+  return display_spi_dma_active;
+}
+
+void display_spi_wait_idle(void)
+{
+  while (display_spi_dma_active) {
+  }
+}
+
+/**
+  * @brief Start the transfer at the queue head, or release CS when done
+  * @note  Runs from the completion interrupt, RS may only change here
+  *        because the previous transfer has fully left the shift register
+  */
+static void display_spi_start_next(void)
+{
+  if (display_spi_queue_count == 0) {
+    display_spi_dma_active = false;
+    HAL_GPIO_WritePin(LCD_CS_GPIO_Port, LCD_CS_Pin, GPIO_PIN_SET);
+    return;
+  }
+
+  display_spi_xfer_t *xfer = &display_spi_queue[display_spi_queue_head];
+  HAL_GPIO_WritePin(LCD_WR_RS_GPIO_Port, LCD_WR_RS_Pin,
+                    xfer->command ? GPIO_PIN_RESET : GPIO_PIN_SET);
+
+  display_spi_dma_active = true;
+  if (HAL_SPI_Transmit_DMA(&display_spi_handle,
+                           xfer->data ? xfer->data : xfer->inline_data,
+                           xfer->len) != HAL_OK) {
+    // Drop the queue rather than leave CS low forever
+    display_spi_queue_count = 0;
+    display_spi_dma_active = false;
+    HAL_GPIO_WritePin(LCD_CS_GPIO_Port, LCD_CS_Pin, GPIO_PIN_SET);
+  }
+}
+
+ITCM_TEXT void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+  if (hspi->Instance == SPI4) {
+    display_spi_queue_head = (display_spi_queue_head + 1) % DISPLAY_SPI_QUEUE_LEN;
+    display_spi_queue_count--;
+    display_spi_start_next();
+    scheduler_post(SCHEDULER_EVENT_LCD);
+  }
+}
+
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+  if (hspi->Instance == SPI4) {
+    display_spi_queue_count = 0;
+    display_spi_dma_active = false;
+    HAL_GPIO_WritePin(LCD_CS_GPIO_Port, LCD_CS_Pin, GPIO_PIN_SET);
+  }
+}
+
 /**
   * @brief SPI MSP Initialization
   * This function configures the hardware resources used in this example
@@ -113,6 +253,29 @@ void HAL_SPI_MspInit(SPI_HandleTypeDef* hspi)
     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
     GPIO_InitStruct.Alternate = GPIO_AF5_SPI4;
     HAL_GPIO_Init(GPIOE, &GPIO_InitStruct);
+
+    // SPI4 DMA Init
+    // SPI4_TX Init
+    hdma_spi4_tx.Instance = DMA1_Stream4;
+    hdma_spi4_tx.Init.Request = DMA_REQUEST_SPI4_TX;
+    hdma_spi4_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    hdma_spi4_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_spi4_tx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_spi4_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_spi4_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_spi4_tx.Init.Mode = DMA_NORMAL;
+    hdma_spi4_tx.Init.Priority = DMA_PRIORITY_LOW;
+    hdma_spi4_tx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(&hdma_spi4_tx) != HAL_OK)
+    {
+      //Error_Handler();
+    }
+
+    __HAL_LINKDMA(hspi,hdmatx,hdma_spi4_tx);
+
+    // SPI4 interrupt Init, signals the end of each DMA transfer
+    HAL_NVIC_SetPriority(SPI4_IRQn, 8, 0);
+    HAL_NVIC_EnableIRQ(SPI4_IRQn);
   }
 }
 
@@ -128,5 +291,8 @@ void HAL_SPI_MspDeInit(SPI_HandleTypeDef* hspi)
   {
     __HAL_RCC_SPI4_CLK_DISABLE();
     HAL_GPIO_DeInit(GPIOE, GPIO_PIN_12|GPIO_PIN_14);
+
+    HAL_DMA_DeInit(hspi->hdmatx);
+    HAL_NVIC_DisableIRQ(SPI4_IRQn);
   }
 }
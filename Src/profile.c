@@ -0,0 +1,121 @@
+/**
+ ******************************************************************************
+ * @file      profile.c
+ * @brief     Cycle count profiling of tasks and code regions (DWT CYCCNT)
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include <stddef.h>
+
+#include "stm32h7xx_hal.h"
+#include "profile.h"
+
+// ---------------------------------------------------------------------------
+// Internal state
+// ---------------------------------------------------------------------------
+
+#if PROFILE_ENABLE
+
+uint32_t profile_start[PROFILE_COUNT];
+
+static profile_entry_t entries[PROFILE_COUNT] = {
+    [PROFILE_DRAW_HOME]      = { .name = "home" },
+    [PROFILE_DRAW_MENU]      = { .name = "menu" },
+    [PROFILE_DRAW_WATERFALL] = { .name = "wfall" },
+    [PROFILE_DRAW_SCANNER]   = { .name = "scan" },
+    [PROFILE_LCD_FLUSH]      = { .name = "flush" },
+    [PROFILE_SA818_LINE]     = { .name = "line" },
+    [PROFILE_ROTARY_SCAN]    = { .name = "rotary" },
+    [PROFILE_AUDIO_IRQ]      = { .name = "adcirq" },
+    [PROFILE_BENCH_DSP_C0]   = { .name = "dsp c0" },
+    [PROFILE_BENCH_DSP_C1]   = { .name = "dsp c1" },
+    [PROFILE_BENCH_DSP_CX]   = { .name = "dsp cx" },
+    [PROFILE_BENCH_FFT_C0]   = { .name = "fft c0" },
+    [PROFILE_BENCH_FFT_C1]   = { .name = "fft c1" },
+    [PROFILE_BENCH_FFT_CX]   = { .name = "fft cx" },
+    [PROFILE_BENCH_IRQ_C0]   = { .name = "irq c0" },
+    [PROFILE_BENCH_IRQ_C1]   = { .name = "irq c1" },
+    [PROFILE_BENCH_IRQ_CX]   = { .name = "irq cx" },
+    [PROFILE_BENCH_DRAW_C0]  = { .name = "draw c0" },
+    [PROFILE_BENCH_DRAW_C1]  = { .name = "draw c1" },
+};
+
+// Cycles an empty BEGIN/END pair reads, taken off every sample
+static uint32_t probe_cycles = 0;
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+
+static void profile_clear(uint8_t first, uint8_t end)
+{
+    for (uint8_t i = first; i < end; i++) {
+        entries[i].calls = 0;
+        entries[i].min = UINT32_MAX;
+        entries[i].max = 0;
+        entries[i].total = 0;
+        entries[i].last = 0;
+    }
+}
+
+#endif
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+
+void profile_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55;  // the M7 locks the DWT until this key is written
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+#if PROFILE_ENABLE
+    profile_clear(0, PROFILE_COUNT);
+
+    // Read back the cost of the probes themselves
+    probe_cycles = 0;
+    PROFILE_BEGIN(PROFILE_TASK_FIRST);
+    PROFILE_END(PROFILE_TASK_FIRST);
+    probe_cycles = entries[PROFILE_TASK_FIRST].max;
+    profile_clear(0, PROFILE_COUNT);
+#endif
+}
+
+#if PROFILE_ENABLE
+
+void profile_record(profile_id_t id, uint32_t cycles)
+{
+    profile_entry_t *e = &entries[id];
+
+    e->last = cycles;
+    cycles = (cycles > probe_cycles) ? cycles - probe_cycles : 0;
+
+    e->calls++;
+    e->total += cycles;
+    if (cycles < e->min)
+        e->min = cycles;
+    if (cycles > e->max)
+        e->max = cycles;
+}
+
+void profile_set_name(profile_id_t id, const char *name)
+{
+    if (id < PROFILE_COUNT)
+        entries[id].name = name;
+}
+
+const profile_entry_t *profile_get(profile_id_t id)
+{
+    return (id < PROFILE_COUNT) ? &entries[id] : NULL;
+}
+
+void profile_reset(void)
+{
+    profile_clear(0, PROFILE_BENCH_FIRST);
+}
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ ******************************************************************************
+ * @file      ring_buffer.c
+ * @brief     Lock-free single producer / single consumer byte ring buffer
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include "stm32h7xx_hal.h"
+#include "main.h"
+#include "ring_buffer.h"
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+
+bool ring_buffer_init(ring_buffer_t *rb, uint8_t *storage, uint16_t size)
+{
+    if (rb == NULL || storage == NULL || size == 0 || (size & (size - 1)) != 0)
+        return false;
+
+    rb->buf = storage;
+    rb->mask = size - 1;
+    rb->head = 0;
+    rb->tail = 0;
+    rb->dropped = 0;
+    return true;
+}
+
+ITCM_TEXT size_t ring_buffer_write(ring_buffer_t *rb, const uint8_t *data, size_t len)
+{
+    uint16_t head = rb->head;
+    uint16_t space = rb->mask - (uint16_t)((head - rb->tail) & rb->mask);
+    size_t n = (len < space) ? len : space;
+
+    for (size_t i = 0; i < n; i++) {
+        rb->buf[head] = data[i];
+        head = (head + 1) & rb->mask;
+    }
+
+    // Data must be in memory before the consumer can see the new head
+    __DMB();
+    rb->head = head;
+
+    rb->dropped += (uint32_t)(len - n);
+    return n;
+}
+
+ITCM_TEXT bool ring_buffer_read_byte(ring_buffer_t *rb, uint8_t *byte)
+{
+    uint16_t tail = rb->tail;
+    if (tail == rb->head)
+        return false;
+
+    __DMB();
+    *byte = rb->buf[tail];
+    rb->tail = (tail + 1) & rb->mask;
+    return true;
+}
+
+size_t ring_buffer_count(const ring_buffer_t *rb)
+{
+    return (size_t)((rb->head - rb->tail) & rb->mask);
+}
+
+void ring_buffer_flush(ring_buffer_t *rb)
+{
+    rb->tail = rb->head;
+}
@@ -4,6 +4,7 @@
 #include "lcd.h"
 #include "menu.h"
 #include "gpio.h"
+#include "profile.h"
 
 // Optional time structure (if you already have RTC code)
 extern RTC_TimeTypeDef stimestructureget;
@@ -62,7 +63,9 @@ void rotary_init(void)
 void rotary_task(void)
 {
     for (uint8_t i = 0; i < rotary_count; i++) {
+        PROFILE_BEGIN(PROFILE_ROTARY_SCAN);
         rotary_scan(&rotaries[i]);
+        PROFILE_END(PROFILE_ROTARY_SCAN);
     }
 }
 
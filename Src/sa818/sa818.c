@@ -1,30 +1,37 @@
-#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
 #include "stm32h7xx_hal.h"
 #include "sa818.h"
 #include "sa818_uart.h"
+#include "fmt.h"
 #include "gpio.h"
-#include "test_tone.h"
 #include "menu.h"
+#include "profile.h"
+#include "scheduler.h"
 
 // ---------------------------------------------------------------------------
 // Configuration
 // ---------------------------------------------------------------------------
 #define CRLF "\r\n"
-#define SA818_RSSI_POLL_INTERVAL_MS   10
+#define SA818_RSSI_POLL_MAX_INTERVAL_MS  250   // back-off limit while RSSI is steady
+#define SA818_RSSI_CHANGE_THRESHOLD      2     // difference that counts as a changing signal
+#define SA818_RSSI_RATE_WINDOW_MS        1000
 #define SA818_CMD_TIMEOUT_MS          300
+#define SA818_SYNC_MAX_RETRIES        3
 // #define DEBUG_SA818  // Uncomment for debug prints
 
 // ---------------------------------------------------------------------------
 // Internal command state
 // ---------------------------------------------------------------------------
+#define SA818_CMD_QUEUE_LEN           8     // slots per priority level
+#define SA818_CMD_MAX_LEN             64
+#define SA818_EXPECT_MAX_LEN          16
+
 typedef enum {
     SA818_CMD_IDLE = 0,
     SA818_CMD_TX,
-    SA818_CMD_RX_WAIT,
-    SA818_CMD_PROCESS
+    SA818_CMD_RX_WAIT
 } sa818_cmd_state_t;
 
 typedef enum {
@@ -33,24 +40,90 @@ typedef enum {
     SA818_SCHED_ERROR
 } sa818_sched_status_t;
 
+// Lower value = served first, config writes always go ahead of polls
+typedef enum {
+    SA818_PRIO_CONFIG = 0,
+    SA818_PRIO_POLL,
+    SA818_PRIO_COUNT
+} sa818_cmd_prio_t;
+
+// Called from sa818_task() once a command completes, times out or is
+// aborted. resp holds the reply line (empty if nothing arrived).
+typedef void (*sa818_cmd_cb_t)(sa818_status_t status, const char *resp);
+
 typedef struct {
-    char cmd[96];
-    char expect[32];
+    char cmd[SA818_CMD_MAX_LEN];
+    char expect[SA818_EXPECT_MAX_LEN];
     uint32_t timeout_ms;
-    bool active;
+    sa818_cmd_prio_t prio;
+    sa818_cmd_cb_t on_done;
 } sa818_cmd_request_t;
 
+// Fixed-capacity ring of pending requests, one per priority level
+typedef struct {
+    sa818_cmd_request_t slots[SA818_CMD_QUEUE_LEN];
+    uint8_t head;
+    uint8_t count;
+} sa818_cmd_queue_t;
+
 static sa818_cmd_state_t sa818_state = SA818_CMD_IDLE;
-static sa818_cmd_request_t sa818_pending;  // single queued command
+static sa818_cmd_queue_t sa818_queue[SA818_PRIO_COUNT];
+static sa818_cmd_request_t sa818_active;   // command currently on the wire
 
-static uint8_t sa818_rxbuf[128];
+static char sa818_line[96];                  // last line read from the module
 static uint32_t sa818_deadline = 0;
-static uint32_t last_rssi_poll = 0;
+static uint32_t sa818_cmd_started = 0;      // tick the active command went on the wire
+
+// ---------------------------------------------------------------------------
+// Adaptive RSSI polling
+// ---------------------------------------------------------------------------
+// Polls run back-to-back while the signal changes, so the update rate is
+// limited only by the measured round trip. While RSSI is steady the idle
+// time between polls doubles up to SA818_RSSI_POLL_MAX_INTERVAL_MS.
+static uint32_t last_rssi_poll = 0;         // tick the last poll completed
+static uint32_t sa818_rssi_interval = 0;    // idle time between polls, 0 = back-to-back
+static uint32_t sa818_rssi_rtt_q4 = 0;      // round trip average, ms * 16
+static uint8_t sa818_rssi_ref = 0;         // value at the last detected change
+static uint16_t sa818_rssi_samples = 0;     // samples in the current rate window
+static uint32_t sa818_rssi_window_start = 0;
+static uint16_t sa818_rssi_rate = 0;        // samples/s over the last full window
+static uint32_t sa818_rssi_count = 0;       // polls answered since start up
+
+// ---------------------------------------------------------------------------
+// Band scan
+// ---------------------------------------------------------------------------
+// Every channel is an S+ (tunes the receiver there and reports the squelch)
+// followed by an RSSI? read. Channels are queued a few ahead so the link
+// never waits on the caller, their frequencies are kept here in order.
+#define SA818_SCAN_DEPTH   4
+
+static uint32_t sa818_scan_freq[SA818_SCAN_DEPTH];
+static uint8_t sa818_scan_head = 0;
+static uint8_t sa818_scan_count = 0;
+static sa818_status_t sa818_scan_status = SA818_OK;   // of the S+ of the current channel
+static bool sa818_scan_signal = false;
+static bool sa818_scanning = false;                  // receiver may be off the rx frequency
+static sa818_scan_cb_t sa818_scan_cb = NULL;
 
 // ---------------------------------------------------------------------------
 // Settings
 // ---------------------------------------------------------------------------
-sa818_settings_t sa818_settings;
+
+// Setting groups that are written with one AT command each
+typedef enum {
+    SA818_SYNC_GROUP  = (1 << 0),   // AT+DMOSETGROUP
+    SA818_SYNC_VOLUME = (1 << 1),   // AT+DMOSETVOLUME
+    SA818_SYNC_FILTER = (1 << 2),   // AT+SETFILTER
+    SA818_SYNC_TAIL   = (1 << 3),   // AT+SETTAIL
+    SA818_SYNC_ALL    = 0x0F
+} sa818_sync_t;
+
+sa818_settings_t sa818_settings;            // desired state, edited by the setters
+static sa818_settings_t sa818_applied;      // last state acknowledged by the module
+static sa818_settings_t sa818_inflight;     // snapshot of the commands on their way
+static uint8_t sa818_dirty = 0;             // groups where desired may differ from applied
+static uint8_t sa818_busy = 0;              // groups with a command queued or in flight
+static uint8_t sa818_retries[4];
 
 // ---------------------------------------------------------------------------
 // Private helpers
@@ -62,13 +135,30 @@ static sa818_status_t sa818_set_group_dma(const sa818_settings_t *cfg);
 static sa818_status_t sa818_set_volume_dma(uint8_t level);
 static sa818_status_t sa818_set_filter_dma(uint8_t pre_de_emph, uint8_t highpass, uint8_t lowpass);
 static sa818_status_t sa818_set_tail_dma(uint8_t tail_on);
-static sa818_status_t sa818_scan_frequency_dma(float rx_freq, bool *signal_found);
+static sa818_status_t sa818_scan_frequency_dma(uint32_t rx_freq, sa818_cmd_cb_t on_done);
 static sa818_status_t sa818_get_rssi_dma(uint8_t *rssi);
 static sa818_status_t sa818_get_version_dma(char *version_str, int max_len);
-static sa818_sched_status_t sa818_schedule_cmd(const char *cmd, const char *expect, uint32_t timeout_ms);
-static void sa818_start_cmd(const char *cmd, const char *expect, uint32_t timeout_ms);
-static void sa818_process_response(void);
+static sa818_sched_status_t sa818_schedule_cmd(const char *cmd, const char *expect, uint32_t timeout_ms,
+                                               sa818_cmd_prio_t prio, sa818_cmd_cb_t on_done);
+static bool sa818_dequeue_cmd(sa818_cmd_request_t *req);
+static void sa818_start_cmd(const sa818_cmd_request_t *req);
+static void sa818_finish_cmd(sa818_status_t status, const char *resp);
+static void sa818_receive_lines(void);
+static bool sa818_process_line(const char *line, sa818_status_t *status);
 static bool sa818_is_command_active(void);
+static void sa818_on_rssi_done(sa818_status_t status, const char *resp);
+static void sa818_on_scan_done(sa818_status_t status, const char *resp);
+static void sa818_on_scan_rssi_done(sa818_status_t status, const char *resp);
+
+// Desired vs. applied settings sync
+static void sa818_sync_settings(void);
+static bool sa818_sync_differs(const sa818_settings_t *a, const sa818_settings_t *b, sa818_sync_t group);
+static void sa818_sync_copy(sa818_settings_t *dst, const sa818_settings_t *src, sa818_sync_t group);
+static void sa818_sync_done(sa818_sync_t group, sa818_status_t status);
+static void sa818_on_group_done(sa818_status_t status, const char *resp);
+static void sa818_on_volume_done(sa818_status_t status, const char *resp);
+static void sa818_on_filter_done(sa818_status_t status, const char *resp);
+static void sa818_on_tail_done(sa818_status_t status, const char *resp);
 
 // Blocking uart helpers
 static sa818_status_t sa818_handshake_blocking(void);
@@ -76,11 +166,16 @@ static sa818_status_t sa818_set_group_blocking(const sa818_settings_t *cfg);
 static sa818_status_t sa818_set_volume_blocking(uint8_t level);
 static sa818_status_t sa818_set_filter_blocking(uint8_t pre_de_emph, uint8_t highpass, uint8_t lowpass);
 static sa818_status_t sa818_set_tail_blocking(uint8_t tail_on);
-static sa818_status_t sa818_scan_frequency_blocking(float rx_freq, bool *signal_found);
+static sa818_status_t sa818_scan_frequency_blocking(uint32_t rx_freq, bool *signal_found);
 static sa818_status_t sa818_get_rssi_blocking(uint8_t *rssi);
 static sa818_status_t sa818_get_version_blocking(char *version_str, int max_len);
 static sa818_status_t sa818_send_cmd_blocking(const char *cmd, const char *expect, char *resp, int resp_len, int timeout_ms);
 
+// AT command builders, shared by both helper sets
+static size_t sa818_build_group_cmd(char *cmd, size_t size, const sa818_settings_t *cfg);
+static size_t sa818_build_value_cmd(char *cmd, size_t size, const char *prefix, const uint8_t *values, uint8_t count);
+static size_t sa818_build_scan_cmd(char *cmd, size_t size, uint32_t rx_freq);
+
 // GPIO helpers
 static void sa818_set_power_on_off(pin_level_t level);
 static void sa818_set_ptt_level(pin_level_t level);
@@ -102,8 +197,8 @@ sa818_status_t sa818_init(void)
     memset(&sa818_settings, 0, sizeof(sa818_settings_t));
 
     sa818_settings.bandwidth     = 0;
-    sa818_settings.tx_frequency  = 144.4500f;
-    sa818_settings.rx_frequency  = 144.4500f;
+    sa818_settings.tx_frequency  = 144450000;
+    sa818_settings.rx_frequency  = 144450000;
     strncpy(sa818_settings.tx_subaudio, "0000", sizeof(sa818_settings.tx_subaudio));
     strncpy(sa818_settings.rx_subaudio, "0000", sizeof(sa818_settings.rx_subaudio));
     sa818_settings.squelch       = 4;
@@ -116,8 +211,17 @@ sa818_status_t sa818_init(void)
     sa818_settings.power         = SA818_POWER_LOW;
 
     sa818_state = SA818_CMD_IDLE;
-    sa818_pending.active = false;
+    memset(sa818_queue, 0, sizeof(sa818_queue));
+    sa818_dirty = 0;
+    sa818_busy = 0;
+    memset(sa818_retries, 0, sizeof(sa818_retries));
     last_rssi_poll = HAL_GetTick();
+    sa818_rssi_interval = 0;
+    sa818_rssi_rtt_q4 = 0;
+    sa818_rssi_samples = 0;
+    sa818_rssi_window_start = last_rssi_poll;
+    sa818_rssi_rate = 0;
+    sa818_rssi_count = 0;
 
 	if (sa818_handshake_blocking() != SA818_OK) {
 		return SA818_ERROR;
@@ -145,6 +249,9 @@ sa818_status_t sa818_init(void)
 		return SA818_ERROR;
 	}
 
+	// Everything above was acknowledged, this is now the applied state
+	sa818_applied = sa818_settings;
+
 	return SA818_OK;
 }
 
@@ -155,44 +262,60 @@ void sa818_task(void)
 {
     uint32_t now = HAL_GetTick();
 
+    // Check this before reading lines, the main loop may have been away
+    // long enough for the reply to be waiting already
+    if (sa818_state == SA818_CMD_TX && sa818_uart_tx_done()) {
+        sa818_state = SA818_CMD_RX_WAIT;
+    }
+
+    // Parse everything the module sent since the last call, this may
+    // complete the active command
+    sa818_receive_lines();
+
+    if (now - sa818_rssi_window_start >= SA818_RSSI_RATE_WINDOW_MS) {
+        sa818_rssi_rate = (uint16_t)((sa818_rssi_samples * 1000u) / (now - sa818_rssi_window_start));
+        sa818_rssi_samples = 0;
+        sa818_rssi_window_start = now;
+    }
+
+    // Turn changed settings into at most one command per group. Also
+    // while a command is on the wire, a queued write ends a waiting poll.
+    sa818_sync_settings();
+
     switch (sa818_state)
     {
     case SA818_CMD_IDLE:
-        // If we have a queued command, start it
-        if (sa818_pending.active) {
-            sa818_start_cmd(sa818_pending.cmd, sa818_pending.expect, sa818_pending.timeout_ms);
-            sa818_pending.active = false;
-            break;
+        // Only poll RSSI when nothing else is waiting, so a poll never
+        // sits in front of a configuration write
+        if (sa818_settings.mode == SA818_MODE_RX &&
+            !sa818_scanning &&
+            !sa818_is_command_active() &&
+            now - last_rssi_poll >= sa818_rssi_interval) {
+            sa818_schedule_cmd("RSSI?\r\n", "RSSI=", SA818_CMD_TIMEOUT_MS,
+                               SA818_PRIO_POLL, sa818_on_rssi_done);
         }
 
-        // Otherwise handle periodic RSSI polling
-        if (sa818_settings.mode == SA818_MODE_RX &&
-            now - last_rssi_poll >= SA818_RSSI_POLL_INTERVAL_MS) {
-            sa818_start_cmd("RSSI?\r\n", "RSSI=", SA818_CMD_TIMEOUT_MS);
-            last_rssi_poll = now;
+        // Start the highest priority queued command
+        if (sa818_dequeue_cmd(&sa818_active)) {
+            sa818_start_cmd(&sa818_active);
         }
         break;
 
     case SA818_CMD_TX:
-        if (sa818_uart_tx_done()) {
-            sa818_uart_rx_dma(sa818_rxbuf, sizeof(sa818_rxbuf));
-            sa818_state = SA818_CMD_RX_WAIT;
-        }
+        // Waiting for the transmit DMA, handled above
         break;
 
     case SA818_CMD_RX_WAIT:
-        if (sa818_uart_rx_done()) {
-            sa818_state = SA818_CMD_PROCESS;
-        } else if (now > sa818_deadline) {
-            sa818_uart_abort_rx();
-            sa818_state = SA818_CMD_IDLE;
+        if ((int32_t)(now - sa818_deadline) > 0) {
+            sa818_finish_cmd(SA818_TIMEOUT, "");
+        } else if (sa818_active.prio > SA818_PRIO_CONFIG &&
+                   sa818_queue[SA818_PRIO_CONFIG].count > 0) {
+            // A config write is waiting, drop the poll instead of holding
+            // the link until its reply or timeout. A late reply is still
+            // parsed by sa818_receive_lines().
+            sa818_finish_cmd(SA818_ABORTED, "");
         }
         break;
-
-    case SA818_CMD_PROCESS:
-        sa818_process_response();
-        sa818_state = SA818_CMD_IDLE;
-        break;
     }
 }
 
@@ -200,23 +323,42 @@ const sa818_settings_t* sa818_get_settings(void) {
     return &sa818_settings;
 }
 
+bool sa818_settings_synced(void) {
+    return sa818_dirty == 0 && sa818_busy == 0;
+}
+
+uint16_t sa818_get_rssi_rate(void) {
+    return sa818_rssi_rate;
+}
+
+uint16_t sa818_get_rssi_rtt_ms(void) {
+    return (uint16_t)(sa818_rssi_rtt_q4 >> 4);
+}
+
+uint32_t sa818_get_rssi_count(void) {
+    return sa818_rssi_count;
+}
+
 void sa818_set_bandwidth(uint8_t bw)
 {
     sa818_settings.bandwidth = bw ? 1 : 0;
-    sa818_set_group_dma(&sa818_settings);
+    // Keep both frequencies on the raster of the new bandwidth
+    sa818_settings.tx_frequency = sa818_snap_frequency(sa818_settings.tx_frequency, sa818_get_raster_hz());
+    sa818_settings.rx_frequency = sa818_snap_frequency(sa818_settings.rx_frequency, sa818_get_raster_hz());
+    sa818_dirty |= SA818_SYNC_GROUP;
 }
 
-void sa818_set_tx_frequency(float freq)
+void sa818_set_tx_frequency(uint32_t freq_hz)
 {
-    sa818_settings.tx_frequency = freq;
+    sa818_settings.tx_frequency = sa818_snap_frequency(freq_hz, sa818_get_raster_hz());
     // Update both TX/RX frequencies (they share same group config)
-    sa818_set_group_dma(&sa818_settings);
+    sa818_dirty |= SA818_SYNC_GROUP;
 }
 
-void sa818_set_rx_frequency(float freq)
+void sa818_set_rx_frequency(uint32_t freq_hz)
 {
-    sa818_settings.rx_frequency = freq;
-    sa818_set_group_dma(&sa818_settings);
+    sa818_settings.rx_frequency = sa818_snap_frequency(freq_hz, sa818_get_raster_hz());
+    sa818_dirty |= SA818_SYNC_GROUP;
 }
 
 void sa818_set_tx_subaudio(const char *code)
@@ -225,7 +367,7 @@ void sa818_set_tx_subaudio(const char *code)
         strncpy(sa818_settings.tx_subaudio, code, sizeof(sa818_settings.tx_subaudio) - 1);
         sa818_settings.tx_subaudio[sizeof(sa818_settings.tx_subaudio) - 1] = '\0';
     }
-    sa818_set_group_dma(&sa818_settings);
+    sa818_dirty |= SA818_SYNC_GROUP;
 }
 
 void sa818_set_rx_subaudio(const char *code)
@@ -234,14 +376,14 @@ void sa818_set_rx_subaudio(const char *code)
         strncpy(sa818_settings.rx_subaudio, code, sizeof(sa818_settings.rx_subaudio) - 1);
         sa818_settings.rx_subaudio[sizeof(sa818_settings.rx_subaudio) - 1] = '\0';
     }
-    sa818_set_group_dma(&sa818_settings);
+    sa818_dirty |= SA818_SYNC_GROUP;
 }
 
 void sa818_set_squelch(uint8_t sq)
 {
     if (sq > 8) sq = 8;
     sa818_settings.squelch = sq;
-    sa818_set_group_dma(&sa818_settings);
+    sa818_dirty |= SA818_SYNC_GROUP;
 }
 
 void sa818_set_volume_level(uint8_t vol)
@@ -249,47 +391,36 @@ void sa818_set_volume_level(uint8_t vol)
     if (vol < 1) vol = 1;
     if (vol > 8) vol = 8;
     sa818_settings.volume = vol;
-    sa818_set_volume_dma(vol);
+    sa818_dirty |= SA818_SYNC_VOLUME;
 }
 
 void sa818_set_pre_de_emph(uint8_t value)
 {
     sa818_settings.pre_de_emph = value ? 1 : 0;
-    sa818_set_filter_dma(sa818_settings.pre_de_emph,
-                         sa818_settings.highpass,
-                         sa818_settings.lowpass);
+    sa818_dirty |= SA818_SYNC_FILTER;
 }
 
 void sa818_set_highpass(uint8_t value)
 {
     sa818_settings.highpass = value ? 1 : 0;
-    sa818_set_filter_dma(sa818_settings.pre_de_emph,
-                         sa818_settings.highpass,
-                         sa818_settings.lowpass);
+    sa818_dirty |= SA818_SYNC_FILTER;
 }
 
 void sa818_set_lowpass(uint8_t value)
 {
     sa818_settings.lowpass = value ? 1 : 0;
-    sa818_set_filter_dma(sa818_settings.pre_de_emph,
-                         sa818_settings.highpass,
-                         sa818_settings.lowpass);
+    sa818_dirty |= SA818_SYNC_FILTER;
 }
 
 void sa818_set_tail_tone(uint8_t value)
 {
     sa818_settings.tail_tone = value ? 1 : 0;
-    sa818_set_tail_dma(sa818_settings.tail_tone);
+    sa818_dirty |= SA818_SYNC_TAIL;
 }
 
 void sa818_set_mode(sa818_mode_t mode) {
     sa818_settings.mode = mode;
     sa818_set_ptt_level(mode == SA818_MODE_TX ? LOW : HIGH);
-    if(mode == SA818_MODE_TX) {
-    	testtone_enable(true);
-    } else if (mode == SA818_MODE_RX) {
-    	testtone_enable(false);
-    }
 }
 
 void sa818_set_power_level(sa818_power_t power) {
@@ -300,6 +431,67 @@ void sa818_set_power_level(sa818_power_t power) {
         sa818_set_low_power();
 }
 
+// ---------------------------------------------------------------------------
+// Band scan
+// ---------------------------------------------------------------------------
+sa818_status_t sa818_scan_channel(uint32_t freq_hz, sa818_scan_cb_t cb)
+{
+    // Both commands of the channel or neither
+    if (sa818_scan_count >= SA818_SCAN_DEPTH ||
+        sa818_queue[SA818_PRIO_POLL].count + 2 > SA818_CMD_QUEUE_LEN)
+        return SA818_TIMEOUT;
+
+    if (sa818_scan_frequency_dma(freq_hz, sa818_on_scan_done) != SA818_OK ||
+        sa818_schedule_cmd("RSSI?\r\n", "RSSI=", SA818_CMD_TIMEOUT_MS,
+                           SA818_PRIO_POLL, sa818_on_scan_rssi_done) != SA818_SCHED_OK)
+        return SA818_ERROR;
+
+    sa818_scan_freq[(sa818_scan_head + sa818_scan_count) % SA818_SCAN_DEPTH] = freq_hz;
+    sa818_scan_count++;
+    sa818_scan_cb = cb;
+    sa818_scanning = true;
+    return SA818_OK;
+}
+
+uint8_t sa818_scan_pending(void)
+{
+    return sa818_scan_count;
+}
+
+void sa818_scan_end(void)
+{
+    if (!sa818_scanning)
+        return;
+
+    // Drop the channels still queued, only polls share their queue
+    sa818_queue[SA818_PRIO_POLL].count = 0;
+    sa818_scan_count = 0;
+    sa818_scan_cb = NULL;
+    sa818_scanning = false;
+
+    // S+ left the receiver on a scan channel. Make the applied group look
+    // different so the rx frequency is sent again, it goes ahead of any
+    // poll and waits for a scan command that is still on the wire.
+    sa818_applied.rx_frequency = 0;
+    sa818_dirty |= SA818_SYNC_GROUP;
+}
+
+// ---------------------------------------------------------------------------
+// Frequency helpers
+// ---------------------------------------------------------------------------
+uint32_t sa818_get_raster_hz(void)
+{
+    return sa818_settings.bandwidth ? SA818_RASTER_WIDE_HZ : SA818_RASTER_NARROW_HZ;
+}
+
+// Rounds to the nearest channel, halfway rounds up
+uint32_t sa818_snap_frequency(uint32_t freq_hz, uint32_t raster_hz)
+{
+    if (raster_hz == 0)
+        return freq_hz;
+    return ((freq_hz + raster_hz / 2) / raster_hz) * raster_hz;
+}
+
 // ---------------------------------------------------------------------------
 // NON-BLOCKING UART HELPERS (internal)
 // ---------------------------------------------------------------------------
@@ -307,7 +499,8 @@ void sa818_set_power_level(sa818_power_t power) {
 static sa818_status_t sa818_handshake_dma(void)
 {
     sa818_sched_status_t result =
-        sa818_schedule_cmd("AT+DMOCONNECT\r\n", "+DMOCONNECT:0", 1000);
+        sa818_schedule_cmd("AT+DMOCONNECT\r\n", "+DMOCONNECT:0", 1000,
+                           SA818_PRIO_CONFIG, NULL);
 
     return (result == SA818_SCHED_OK) ? SA818_OK :
            (result == SA818_SCHED_BUSY ? SA818_TIMEOUT : SA818_ERROR);
@@ -315,17 +508,12 @@ static sa818_status_t sa818_handshake_dma(void)
 
 static sa818_status_t sa818_set_group_dma(const sa818_settings_t *cfg)
 {
-    char cmd[96];
-    snprintf(cmd, sizeof(cmd),
-             "AT+DMOSETGROUP=%d,%.4f,%.4f,%s,%d,%s\r\n",
-             cfg->bandwidth,
-             cfg->tx_frequency,
-             cfg->rx_frequency,
-             cfg->tx_subaudio,
-             cfg->squelch,
-             cfg->rx_subaudio);
-
-    sa818_sched_status_t result = sa818_schedule_cmd(cmd, "+DMOSETGROUP:0", SA818_CMD_TIMEOUT_MS);
+    char cmd[SA818_CMD_MAX_LEN];
+    sa818_build_group_cmd(cmd, sizeof(cmd), cfg);
+
+    sa818_sched_status_t result =
+        sa818_schedule_cmd(cmd, "+DMOSETGROUP:0", SA818_CMD_TIMEOUT_MS,
+                           SA818_PRIO_CONFIG, sa818_on_group_done);
     return (result == SA818_SCHED_OK) ? SA818_OK :
            (result == SA818_SCHED_BUSY ? SA818_TIMEOUT : SA818_ERROR);
 }
@@ -335,18 +523,22 @@ static sa818_status_t sa818_set_volume_dma(uint8_t level)
     if (level < 1) level = 1;
     if (level > 8) level = 8;
     char cmd[32];
-    snprintf(cmd, sizeof(cmd), "AT+DMOSETVOLUME=%d\r\n", level);
-    sa818_sched_status_t result = sa818_schedule_cmd(cmd, "+DMOSETVOLUME:0", SA818_CMD_TIMEOUT_MS);
+    sa818_build_value_cmd(cmd, sizeof(cmd), "AT+DMOSETVOLUME=", &level, 1);
+    sa818_sched_status_t result =
+        sa818_schedule_cmd(cmd, "+DMOSETVOLUME:0", SA818_CMD_TIMEOUT_MS,
+                           SA818_PRIO_CONFIG, sa818_on_volume_done);
     return (result == SA818_SCHED_OK) ? SA818_OK :
            (result == SA818_SCHED_BUSY ? SA818_TIMEOUT : SA818_ERROR);
 }
 
 static sa818_status_t sa818_set_filter_dma(uint8_t pre_de_emph, uint8_t highpass, uint8_t lowpass)
 {
-    char cmd[48];
-    snprintf(cmd, sizeof(cmd), "AT+SETFILTER=%d,%d,%d\r\n",
-             pre_de_emph, highpass, lowpass);
-    sa818_sched_status_t result = sa818_schedule_cmd(cmd, "+DMOSETFILTER:0", SA818_CMD_TIMEOUT_MS);
+    char cmd[32];
+    const uint8_t values[] = { pre_de_emph, highpass, lowpass };
+    sa818_build_value_cmd(cmd, sizeof(cmd), "AT+SETFILTER=", values, 3);
+    sa818_sched_status_t result =
+        sa818_schedule_cmd(cmd, "+DMOSETFILTER:0", SA818_CMD_TIMEOUT_MS,
+                           SA818_PRIO_CONFIG, sa818_on_filter_done);
     return (result == SA818_SCHED_OK) ? SA818_OK :
            (result == SA818_SCHED_BUSY ? SA818_TIMEOUT : SA818_ERROR);
 }
@@ -354,26 +546,27 @@ static sa818_status_t sa818_set_filter_dma(uint8_t pre_de_emph, uint8_t highpass
 static sa818_status_t sa818_set_tail_dma(uint8_t tail_on)
 {
     char cmd[32];
-    snprintf(cmd, sizeof(cmd), "AT+SETTAIL=%d\r\n", tail_on);
-    sa818_sched_status_t result = sa818_schedule_cmd(cmd, "+DMOSETTAIL:0", SA818_CMD_TIMEOUT_MS);
+    sa818_build_value_cmd(cmd, sizeof(cmd), "AT+SETTAIL=", &tail_on, 1);
+    sa818_sched_status_t result =
+        sa818_schedule_cmd(cmd, "+DMOSETTAIL:0", SA818_CMD_TIMEOUT_MS,
+                           SA818_PRIO_CONFIG, sa818_on_tail_done);
     return (result == SA818_SCHED_OK) ? SA818_OK :
            (result == SA818_SCHED_BUSY ? SA818_TIMEOUT : SA818_ERROR);
 }
 
-static sa818_status_t sa818_scan_frequency_dma(float rx_freq, bool *signal_found)
+static sa818_status_t sa818_scan_frequency_dma(uint32_t rx_freq, sa818_cmd_cb_t on_done)
 {
-    if (signal_found == NULL)
-        return SA818_ERROR;
-
     char cmd[32];
-    snprintf(cmd, sizeof(cmd), "S+%.4f\r\n", rx_freq);
-    sa818_sched_status_t result = sa818_schedule_cmd(cmd, "S=", SA818_CMD_TIMEOUT_MS);
+    sa818_build_scan_cmd(cmd, sizeof(cmd), rx_freq);
+    sa818_sched_status_t result =
+        sa818_schedule_cmd(cmd, "S=", SA818_CMD_TIMEOUT_MS,
+                           SA818_PRIO_POLL, on_done);
 
     if (result != SA818_SCHED_OK)
         return SA818_ERROR;
 
     // Response "S=0" means signal found, "S=1" means none
-    // Parsing is handled in sa818_process_response
+    // Parsing is handled in sa818_process_line
     return SA818_OK;
 }
 
@@ -382,7 +575,9 @@ static sa818_status_t sa818_get_rssi_dma(uint8_t *rssi)
     if (rssi == NULL)
         return SA818_ERROR;
 
-    sa818_sched_status_t result = sa818_schedule_cmd("RSSI?\r\n", "RSSI=", SA818_CMD_TIMEOUT_MS);
+    sa818_sched_status_t result =
+        sa818_schedule_cmd("RSSI?\r\n", "RSSI=", SA818_CMD_TIMEOUT_MS,
+                           SA818_PRIO_POLL, sa818_on_rssi_done);
     return (result == SA818_SCHED_OK) ? SA818_OK :
            (result == SA818_SCHED_BUSY ? SA818_TIMEOUT : SA818_ERROR);
 }
@@ -392,93 +587,352 @@ static sa818_status_t sa818_get_version_dma(char *version_str, int max_len)
     if (version_str == NULL || max_len <= 0)
         return SA818_ERROR;
 
-    sa818_sched_status_t result = sa818_schedule_cmd("AT+VERSION\r\n", "+VERSION:", SA818_CMD_TIMEOUT_MS);
+    sa818_sched_status_t result =
+        sa818_schedule_cmd("AT+VERSION\r\n", "+VERSION:", SA818_CMD_TIMEOUT_MS,
+                           SA818_PRIO_CONFIG, NULL);
     if (result != SA818_SCHED_OK)
         return SA818_ERROR;
 
-    // Version parsing done asynchronously in sa818_process_response
+    // Version parsing done asynchronously in sa818_process_line
     version_str[0] = '\0';
     return SA818_OK;
 }
 
-static sa818_sched_status_t sa818_schedule_cmd(const char *cmd, const char *expect, uint32_t timeout_ms)
+static sa818_sched_status_t sa818_schedule_cmd(const char *cmd, const char *expect, uint32_t timeout_ms,
+                                               sa818_cmd_prio_t prio, sa818_cmd_cb_t on_done)
 {
-    if (cmd == NULL || strlen(cmd) == 0) {
+    if (cmd == NULL || strlen(cmd) == 0 || strlen(cmd) >= SA818_CMD_MAX_LEN ||
+        prio >= SA818_PRIO_COUNT) {
     	return SA818_SCHED_ERROR;
     }
 
-    // Reject new command if one is busy or queued
-    if (sa818_state != SA818_CMD_IDLE || sa818_pending.active) {
+    sa818_cmd_queue_t *q = &sa818_queue[prio];
+
+    // Reject only when this priority level is full
+    if (q->count >= SA818_CMD_QUEUE_LEN) {
         return SA818_SCHED_BUSY;
     }
 
-    memset(&sa818_pending, 0, sizeof(sa818_pending));
-    strncpy(sa818_pending.cmd, cmd, sizeof(sa818_pending.cmd) - 1);
+    sa818_cmd_request_t *req = &q->slots[(q->head + q->count) % SA818_CMD_QUEUE_LEN];
+    memset(req, 0, sizeof(*req));
+    strncpy(req->cmd, cmd, sizeof(req->cmd) - 1);
     if (expect) {
-    	strncpy(sa818_pending.expect, expect, sizeof(sa818_pending.expect) - 1);
-    } else {
-    	sa818_pending.expect[0] = '\0';
+    	strncpy(req->expect, expect, sizeof(req->expect) - 1);
     }
 
-    sa818_pending.timeout_ms = timeout_ms;
-    sa818_pending.active = true;
+    req->timeout_ms = timeout_ms;
+    req->prio = prio;
+    req->on_done = on_done;
+    q->count++;
 
-    // Cancel RSSI if active
-    if (sa818_state == SA818_CMD_RX_WAIT || sa818_state == SA818_CMD_TX) {
-        sa818_uart_abort_rx();
-        sa818_state = SA818_CMD_IDLE;
-    }
+    // Start it on the next pass rather than the next tick
+    scheduler_post(SCHEDULER_EVENT_SA818);
 
     return SA818_SCHED_OK;
 }
 
-static void sa818_start_cmd(const char *cmd, const char *expect, uint32_t timeout_ms)
+static bool sa818_dequeue_cmd(sa818_cmd_request_t *req)
+{
+    for (int prio = 0; prio < SA818_PRIO_COUNT; prio++) {
+        sa818_cmd_queue_t *q = &sa818_queue[prio];
+        if (q->count > 0) {
+            *req = q->slots[q->head];
+            q->head = (q->head + 1) % SA818_CMD_QUEUE_LEN;
+            q->count--;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void sa818_start_cmd(const sa818_cmd_request_t *req)
 {
-    memset(sa818_rxbuf, 0, sizeof(sa818_rxbuf));
-    sa818_deadline = HAL_GetTick() + timeout_ms;
-    sa818_uart_tx_dma(cmd, strlen(cmd));
+    sa818_cmd_started = HAL_GetTick();
+    sa818_deadline = sa818_cmd_started + req->timeout_ms;
+    sa818_uart_tx_dma(req->cmd, strlen(req->cmd));
     sa818_state = SA818_CMD_TX;
 }
 
-static void sa818_process_response(void)
+static void sa818_finish_cmd(sa818_status_t status, const char *resp)
 {
-    int len = sa818_uart_rx_length();
-    if (len <= 0) {
-        return;
+    sa818_state = SA818_CMD_IDLE;
+    if (sa818_active.on_done) {
+        sa818_active.on_done(status, resp);
     }
+}
 
-    sa818_rxbuf[len] = 0;
-
-    // --- Parse RSSI ---
-    if (strstr((char*)sa818_rxbuf, "RSSI=")) {
-        char *eq = strchr((char*)sa818_rxbuf, '=');
-        if (eq) {
-            sa818_settings.rssi = (uint8_t)atoi(eq + 1);
-            menu_update_display_async(); // make sure home window is updated
+static void sa818_receive_lines(void)
+{
+    sa818_status_t status;
+
+    while (sa818_uart_read_line(sa818_line, sizeof(sa818_line)) > 0) {
+        PROFILE_BEGIN(PROFILE_SA818_LINE);
+        // Lines arriving before our command is fully sent belong to an
+        // earlier (aborted or timed out) command, they are only parsed
+        if (sa818_process_line(sa818_line, &status) &&
+            sa818_state == SA818_CMD_RX_WAIT) {
+            sa818_finish_cmd(status, sa818_line);
         }
+        PROFILE_END(PROFILE_SA818_LINE);
+    }
+}
+
+// Parses all known fields of one reply line. Returns true if the line
+// answers the active command, status tells if the module accepted it.
+static bool sa818_process_line(const char *line, sa818_status_t *status)
+{
+    // --- Parse RSSI, a scan read is for another channel ---
+    if (strncmp(line, "RSSI=", 5) == 0 && sa818_active.on_done != sa818_on_scan_rssi_done) {
+        sa818_settings.rssi = (uint8_t)atoi(line + 5);
     }
 
     // --- Parse S= (scan result) ---
-    if (strstr((char*)sa818_rxbuf, "S=")) {
-        char *eq = strchr((char*)sa818_rxbuf, '=');
-        if (eq) {
-            uint8_t s = (uint8_t)atoi(eq + 1);
-            sa818_settings.signal_present = (s == 0); // S=0 means signal
-        }
+    if (strncmp(line, "S=", 2) == 0) {
+        uint8_t s = (uint8_t)atoi(line + 2);
+        sa818_settings.signal_present = (s == 0); // S=0 means signal
     }
 
     // --- Parse version ---
-    if (strstr((char*)sa818_rxbuf, "+VERSION:")) {
-        char *ver = strstr((char*)sa818_rxbuf, "+VERSION:");
-        if (ver) {
-            strncpy(sa818_settings.version, ver + 9, sizeof(sa818_settings.version) - 1);
-            sa818_settings.version[sizeof(sa818_settings.version) - 1] = '\0';
-        }
+    if (strncmp(line, "+VERSION:", 9) == 0) {
+        strncpy(sa818_settings.version, line + 9, sizeof(sa818_settings.version) - 1);
+        sa818_settings.version[sizeof(sa818_settings.version) - 1] = '\0';
+    }
+
+    const char *expect = sa818_active.expect;
+    size_t expect_len = strlen(expect);
+
+    if (strncmp(line, expect, expect_len) == 0) {
+        *status = SA818_OK;
+        return true;
+    }
+
+    // Same reply with another result code, e.g. "+DMOSETGROUP:1"
+    const char *colon = strchr(expect, ':');
+    if (colon && strncmp(line, expect, (size_t)(colon - expect) + 1) == 0) {
+        *status = SA818_ERROR;
+        return true;
     }
+
+    return false;
 }
 
 static bool sa818_is_command_active(void) {
-    return (sa818_state != SA818_CMD_IDLE || sa818_pending.active);
+    if (sa818_state != SA818_CMD_IDLE)
+        return true;
+
+    for (int prio = 0; prio < SA818_PRIO_COUNT; prio++) {
+        if (sa818_queue[prio].count > 0)
+            return true;
+    }
+    return false;
+}
+
+static void sa818_on_rssi_done(sa818_status_t status, const char *resp)
+{
+    (void)resp;
+    uint32_t now = HAL_GetTick();
+    last_rssi_poll = now;
+
+    if (status == SA818_TIMEOUT) {
+        // Module not answering, don't keep the link busy with polls
+        sa818_rssi_interval = SA818_RSSI_POLL_MAX_INTERVAL_MS;
+        return;
+    }
+
+    if (status != SA818_OK) {
+        return;  // aborted for a config write, poll again right after it
+    }
+
+    // Round trip average with a 1/4 weight for the new sample
+    uint32_t rtt_q4 = (now - sa818_cmd_started) << 4;
+    if (sa818_rssi_rtt_q4 == 0)
+        sa818_rssi_rtt_q4 = rtt_q4;
+    else
+        sa818_rssi_rtt_q4 = (uint32_t)((int32_t)sa818_rssi_rtt_q4 + ((int32_t)rtt_q4 - (int32_t)sa818_rssi_rtt_q4) / 4);
+
+    sa818_rssi_samples++;
+    sa818_rssi_count++;
+
+    int diff = (int)sa818_settings.rssi - (int)sa818_rssi_ref;
+
+    if (diff >= SA818_RSSI_CHANGE_THRESHOLD || diff <= -SA818_RSSI_CHANGE_THRESHOLD) {
+        sa818_rssi_ref = sa818_settings.rssi;
+        sa818_rssi_interval = 0;  // tracking a signal, poll as fast as the link allows
+    } else if (sa818_rssi_interval == 0) {
+        sa818_rssi_interval = (sa818_rssi_rtt_q4 >> 4) ? (sa818_rssi_rtt_q4 >> 4) : 1;
+    } else if (sa818_rssi_interval < SA818_RSSI_POLL_MAX_INTERVAL_MS) {
+        sa818_rssi_interval *= 2;
+        if (sa818_rssi_interval > SA818_RSSI_POLL_MAX_INTERVAL_MS)
+            sa818_rssi_interval = SA818_RSSI_POLL_MAX_INTERVAL_MS;
+    }
+
+    menu_update_display_async(); // make sure home window is updated
+}
+
+static void sa818_on_scan_done(sa818_status_t status, const char *resp)
+{
+    (void)resp;
+    sa818_scan_status = status;
+    sa818_scan_signal = (status == SA818_OK) && sa818_settings.signal_present;
+}
+
+static void sa818_on_scan_rssi_done(sa818_status_t status, const char *resp)
+{
+    if (sa818_scan_count == 0)
+        return;  // scan ended while this was on the wire
+
+    uint32_t freq = sa818_scan_freq[sa818_scan_head];
+    sa818_scan_head = (sa818_scan_head + 1) % SA818_SCAN_DEPTH;
+    sa818_scan_count--;
+
+    // Without the S+ the reading belongs to whatever channel came before
+    if (sa818_scan_status != SA818_OK)
+        status = sa818_scan_status;
+
+    uint8_t rssi = (status == SA818_OK) ? (uint8_t)atoi(resp + 5) : 0;
+
+    if (sa818_scan_cb)
+        sa818_scan_cb(freq, status, rssi, sa818_scan_signal);
+}
+
+// ---------------------------------------------------------------------------
+// Desired vs. applied settings sync
+// ---------------------------------------------------------------------------
+
+// Sends the latest desired state of every changed group, but never more than
+// one command per group at a time. Changes made while a group is on the wire
+// are collected and sent as one command once it completes.
+static void sa818_sync_settings(void)
+{
+    uint8_t ready = sa818_dirty & (uint8_t)~sa818_busy;
+
+    for (uint8_t group = SA818_SYNC_GROUP; group & SA818_SYNC_ALL; group <<= 1) {
+        if (!(ready & group))
+            continue;
+
+        sa818_dirty &= (uint8_t)~group;
+
+        // Changed back to what the module already has, nothing to send
+        if (!sa818_sync_differs(&sa818_settings, &sa818_applied, group))
+            continue;
+
+        sa818_sync_copy(&sa818_inflight, &sa818_settings, group);
+
+        sa818_status_t status = SA818_ERROR;
+        switch (group) {
+        case SA818_SYNC_GROUP:
+            status = sa818_set_group_dma(&sa818_inflight);
+            break;
+        case SA818_SYNC_VOLUME:
+            status = sa818_set_volume_dma(sa818_inflight.volume);
+            break;
+        case SA818_SYNC_FILTER:
+            status = sa818_set_filter_dma(sa818_inflight.pre_de_emph,
+                                          sa818_inflight.highpass,
+                                          sa818_inflight.lowpass);
+            break;
+        case SA818_SYNC_TAIL:
+            status = sa818_set_tail_dma(sa818_inflight.tail_tone);
+            break;
+        }
+
+        if (status == SA818_OK)
+            sa818_busy |= group;
+        else
+            sa818_dirty |= group;   // queue full, try again next pass
+    }
+}
+
+static bool sa818_sync_differs(const sa818_settings_t *a, const sa818_settings_t *b, sa818_sync_t group)
+{
+    switch (group) {
+    case SA818_SYNC_GROUP:
+        return a->bandwidth != b->bandwidth ||
+               a->tx_frequency != b->tx_frequency ||
+               a->rx_frequency != b->rx_frequency ||
+               a->squelch != b->squelch ||
+               strcmp(a->tx_subaudio, b->tx_subaudio) != 0 ||
+               strcmp(a->rx_subaudio, b->rx_subaudio) != 0;
+    case SA818_SYNC_VOLUME:
+        return a->volume != b->volume;
+    case SA818_SYNC_FILTER:
+        return a->pre_de_emph != b->pre_de_emph ||
+               a->highpass != b->highpass ||
+               a->lowpass != b->lowpass;
+    case SA818_SYNC_TAIL:
+        return a->tail_tone != b->tail_tone;
+    default:
+        return false;
+    }
+}
+
+static void sa818_sync_copy(sa818_settings_t *dst, const sa818_settings_t *src, sa818_sync_t group)
+{
+    switch (group) {
+    case SA818_SYNC_GROUP:
+        dst->bandwidth    = src->bandwidth;
+        dst->tx_frequency = src->tx_frequency;
+        dst->rx_frequency = src->rx_frequency;
+        dst->squelch      = src->squelch;
+        memcpy(dst->tx_subaudio, src->tx_subaudio, sizeof(dst->tx_subaudio));
+        memcpy(dst->rx_subaudio, src->rx_subaudio, sizeof(dst->rx_subaudio));
+        break;
+    case SA818_SYNC_VOLUME:
+        dst->volume = src->volume;
+        break;
+    case SA818_SYNC_FILTER:
+        dst->pre_de_emph = src->pre_de_emph;
+        dst->highpass    = src->highpass;
+        dst->lowpass     = src->lowpass;
+        break;
+    case SA818_SYNC_TAIL:
+        dst->tail_tone = src->tail_tone;
+        break;
+    default:
+        break;
+    }
+}
+
+static void sa818_sync_done(sa818_sync_t group, sa818_status_t status)
+{
+    uint8_t idx = 0;
+    while (!((1u << idx) & group))
+        idx++;
+
+    sa818_busy &= (uint8_t)~group;
+
+    if (status == SA818_OK) {
+        sa818_sync_copy(&sa818_applied, &sa818_inflight, group);
+        sa818_retries[idx] = 0;
+    } else if (++sa818_retries[idx] <= SA818_SYNC_MAX_RETRIES) {
+        sa818_dirty |= group;       // resend the latest desired state
+    } else {
+        sa818_retries[idx] = 0;     // give up until the next change
+    }
+}
+
+static void sa818_on_group_done(sa818_status_t status, const char *resp)
+{
+    (void)resp;
+    sa818_sync_done(SA818_SYNC_GROUP, status);
+}
+
+static void sa818_on_volume_done(sa818_status_t status, const char *resp)
+{
+    (void)resp;
+    sa818_sync_done(SA818_SYNC_VOLUME, status);
+}
+
+static void sa818_on_filter_done(sa818_status_t status, const char *resp)
+{
+    (void)resp;
+    sa818_sync_done(SA818_SYNC_FILTER, status);
+}
+
+static void sa818_on_tail_done(sa818_status_t status, const char *resp)
+{
+    (void)resp;
+    sa818_sync_done(SA818_SYNC_TAIL, status);
 }
 
 // ---------------------------------------------------------------------------
@@ -492,15 +946,8 @@ static sa818_status_t sa818_handshake_blocking(void) {
 
 // AT+DMOSETGROUP=BW,TX_F,RX_F,TxSub,SQ,RxSub
 static sa818_status_t sa818_set_group_blocking(const sa818_settings_t *cfg) {
-  char cmd[96];
-  snprintf(cmd, sizeof(cmd),
-           "AT+DMOSETGROUP=%d,%.4f,%.4f,%s,%d,%s\r\n",
-           cfg->bandwidth,
-           cfg->tx_frequency,
-           cfg->rx_frequency,
-           cfg->tx_subaudio,
-           cfg->squelch,
-           cfg->rx_subaudio);
+  char cmd[SA818_CMD_MAX_LEN];
+  sa818_build_group_cmd(cmd, sizeof(cmd), cfg);
 
   return sa818_send_cmd_blocking(cmd, "+DMOSETGROUP:0", NULL, 0, 300);
 }
@@ -508,28 +955,29 @@ static sa818_status_t sa818_set_group_blocking(const sa818_settings_t *cfg) {
 // AT+DMOSETVOLUME=X
 static sa818_status_t sa818_set_volume_blocking(uint8_t level) {
   char cmd[32];
-  snprintf(cmd, sizeof(cmd), "AT+DMOSETVOLUME=%d\r\n", level);
+  sa818_build_value_cmd(cmd, sizeof(cmd), "AT+DMOSETVOLUME=", &level, 1);
   return sa818_send_cmd_blocking(cmd, "+DMOSETVOLUME:0", NULL, 0, 300);
 }
 
 // AT+SETFILTER=PRE/DE-EMPH,HIGHPASS,LOWPASS
 static sa818_status_t sa818_set_filter_blocking(uint8_t pre_de_emph, uint8_t highpass, uint8_t lowpass) {
-  char cmd[48];
-  snprintf(cmd, sizeof(cmd), "AT+SETFILTER=%d,%d,%d\r\n", pre_de_emph, highpass, lowpass);
+  char cmd[32];
+  const uint8_t values[] = { pre_de_emph, highpass, lowpass };
+  sa818_build_value_cmd(cmd, sizeof(cmd), "AT+SETFILTER=", values, 3);
   return sa818_send_cmd_blocking(cmd, "+DMOSETFILTER:0", NULL, 0, 300);
 }
 
 // AT+SETTAIL=TAIL
 static sa818_status_t sa818_set_tail_blocking(uint8_t tail_on) {
   char cmd[32];
-  snprintf(cmd, sizeof(cmd), "AT+SETTAIL=%d\r\n", tail_on);
+  sa818_build_value_cmd(cmd, sizeof(cmd), "AT+SETTAIL=", &tail_on, 1);
   return sa818_send_cmd_blocking(cmd, "+DMOSETTAIL:0", NULL, 0, 300);
 }
 
 // S+Rx_F  --> S=0 or S=1
-static sa818_status_t sa818_scan_frequency_blocking(float rx_freq, bool *signal_found) {
+static sa818_status_t sa818_scan_frequency_blocking(uint32_t rx_freq, bool *signal_found) {
   char cmd[32], resp[32];
-  snprintf(cmd, sizeof(cmd), "S+%.4f\r\n", rx_freq);
+  sa818_build_scan_cmd(cmd, sizeof(cmd), rx_freq);
 
   if (sa818_send_cmd_blocking(cmd, "S=", resp, sizeof(resp), 300) != SA818_OK)
     return SA818_ERROR;
@@ -572,25 +1020,76 @@ static sa818_status_t sa818_get_version_blocking(char *version_str, int max_len)
 }
 
 static sa818_status_t sa818_send_cmd_blocking(const char *cmd, const char *expect, char *resp, int resp_len, int timeout_ms) {
-  char buffer[64] = {0};
-  sa818_uart_transmit(cmd);
-  int len = sa818_uart_receive(buffer, sizeof(buffer), timeout_ms);
+  char line[64];
+  uint32_t start = HAL_GetTick();
 
-  if (len <= 0) {
-    return SA818_ERROR;
-  }
+  sa818_uart_flush();  // drop anything left over, only the reply counts
+  sa818_uart_transmit(cmd);
 
-  if (resp && resp_len > 0) {
-    strncpy(resp, buffer, resp_len - 1);
-  }
+  // Skip unrelated lines until the expected one or the timeout
+  while (HAL_GetTick() - start < (uint32_t)timeout_ms) {
+    uint32_t left = (uint32_t)timeout_ms - (HAL_GetTick() - start);
+    if (sa818_uart_receive_line(line, sizeof(line), left) == 0) {
+      break;
+    }
 
-  if (expect && strstr(buffer, expect)) {
-    return SA818_OK;
+    if (expect && strstr(line, expect)) {
+      if (resp && resp_len > 0) {
+        strncpy(resp, line, resp_len - 1);
+        resp[resp_len - 1] = '\0';
+      }
+      return SA818_OK;
+    }
   }
 
   return SA818_ERROR;
 }
 
+// ---------------------------------------------------------------------------
+// AT command builders
+// ---------------------------------------------------------------------------
+
+// AT+DMOSETGROUP=BW,TX_F,RX_F,TxSub,SQ,RxSub
+static size_t sa818_build_group_cmd(char *cmd, size_t size, const sa818_settings_t *cfg)
+{
+    size_t n = fmt_str(cmd, size, "AT+DMOSETGROUP=");
+    n += fmt_uint(cmd + n, size - n, cfg->bandwidth);
+    n += fmt_str(cmd + n, size - n, ",");
+    n += fmt_mhz(cmd + n, size - n, cfg->tx_frequency);
+    n += fmt_str(cmd + n, size - n, ",");
+    n += fmt_mhz(cmd + n, size - n, cfg->rx_frequency);
+    n += fmt_str(cmd + n, size - n, ",");
+    n += fmt_str(cmd + n, size - n, cfg->tx_subaudio);
+    n += fmt_str(cmd + n, size - n, ",");
+    n += fmt_uint(cmd + n, size - n, cfg->squelch);
+    n += fmt_str(cmd + n, size - n, ",");
+    n += fmt_str(cmd + n, size - n, cfg->rx_subaudio);
+    n += fmt_str(cmd + n, size - n, CRLF);
+    return n;
+}
+
+// <prefix>V1,V2,...  e.g. AT+SETFILTER=0,0,0
+static size_t sa818_build_value_cmd(char *cmd, size_t size, const char *prefix, const uint8_t *values, uint8_t count)
+{
+    size_t n = fmt_str(cmd, size, prefix);
+    for (uint8_t i = 0; i < count; i++) {
+        if (i > 0)
+            n += fmt_str(cmd + n, size - n, ",");
+        n += fmt_uint(cmd + n, size - n, values[i]);
+    }
+    n += fmt_str(cmd + n, size - n, CRLF);
+    return n;
+}
+
+// S+Rx_F
+static size_t sa818_build_scan_cmd(char *cmd, size_t size, uint32_t rx_freq)
+{
+    size_t n = fmt_str(cmd, size, "S+");
+    n += fmt_mhz(cmd + n, size - n, rx_freq);
+    n += fmt_str(cmd + n, size - n, CRLF);
+    return n;
+}
+
 // ---------------------------------------------------------------------------
 // GPIO helpers
 // ---------------------------------------------------------------------------
@@ -0,0 +1,205 @@
+/**
+ ******************************************************************************
+ * @file      scanner.c
+ * @brief     Background band scan with the SA818, per channel RSSI statistics
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include <string.h>
+
+#include "stm32h7xx_hal.h"
+#include "sa818.h"
+#include "menu.h"
+#include "scanner.h"
+
+// ---------------------------------------------------------------------------
+// Internal state
+// ---------------------------------------------------------------------------
+
+static uint32_t channel_freq[SCANNER_MAX_CHANNELS];
+static scanner_channel_t channels[SCANNER_MAX_CHANNELS];
+static uint16_t channel_count = 0;
+
+static bool running = false;
+static uint16_t next_channel = 0;       // next one to queue
+static uint16_t result_channel = 0;     // where the next result is expected
+static uint32_t sweeps = 0;
+static uint32_t updates = 0;
+
+static uint16_t rate_reads = 0;
+static uint32_t rate_window_start = 0;
+static uint16_t rate = 0;
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+
+static void scanner_clear(void)
+{
+    memset(channels, 0, sizeof(channels));
+    next_channel = 0;
+    result_channel = 0;
+    sweeps = 0;
+}
+
+static int32_t scanner_find(uint32_t freq_hz)
+{
+    // Results come back in order, so the expected one nearly always matches
+    if (result_channel < channel_count && channel_freq[result_channel] == freq_hz)
+        return result_channel;
+
+    for (uint16_t i = 0; i < channel_count; i++) {
+        if (channel_freq[i] == freq_hz)
+            return i;
+    }
+    return -1;
+}
+
+static void scanner_on_result(uint32_t freq_hz, sa818_status_t status, uint8_t rssi, bool signal)
+{
+    int32_t index = scanner_find(freq_hz);
+    if (index < 0)
+        return;  // the channel list changed meanwhile
+
+    result_channel = (uint16_t)(index + 1);
+    if (result_channel >= channel_count) {
+        result_channel = 0;
+        sweeps++;
+    }
+
+    if (status != SA818_OK)
+        return;
+
+    scanner_channel_t *ch = &channels[index];
+    ch->last = rssi;
+    ch->signal = signal;
+    if (rssi > ch->max)
+        ch->max = rssi;
+
+    // 1/8 weight for a new read, the first one starts the average
+    if (ch->reads == 0)
+        ch->avg_q4 = (uint16_t)(rssi << 4);
+    else
+        ch->avg_q4 = (uint16_t)(ch->avg_q4 + (((int32_t)rssi << 4) - (int32_t)ch->avg_q4) / 8);
+    if (ch->reads < UINT16_MAX)
+        ch->reads++;
+
+    rate_reads++;
+    updates++;
+    menu_update_display_async();
+}
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+
+void scanner_init(void)
+{
+    scanner_set_range(144000000, 146000000, SA818_RASTER_NARROW_HZ);
+}
+
+void scanner_set_range(uint32_t start_hz, uint32_t stop_hz, uint32_t step_hz)
+{
+    uint16_t count = 0;
+
+    if (step_hz == 0)
+        step_hz = SA818_RASTER_NARROW_HZ;
+
+    for (uint32_t f = start_hz; f <= stop_hz && count < SCANNER_MAX_CHANNELS; f += step_hz)
+        channel_freq[count++] = f;
+
+    channel_count = count;
+    scanner_clear();
+}
+
+void scanner_set_list(const uint32_t *freqs_hz, uint16_t count)
+{
+    if (count > SCANNER_MAX_CHANNELS)
+        count = SCANNER_MAX_CHANNELS;
+
+    memcpy(channel_freq, freqs_hz, count * sizeof(uint32_t));
+    channel_count = count;
+    scanner_clear();
+}
+
+void scanner_start(void)
+{
+    if (running || channel_count == 0)
+        return;
+
+    running = true;
+    next_channel = result_channel;
+    rate_reads = 0;
+    rate_window_start = HAL_GetTick();
+}
+
+void scanner_stop(void)
+{
+    if (!running)
+        return;
+
+    running = false;
+    sa818_scan_end();
+}
+
+bool scanner_is_running(void)
+{
+    return running;
+}
+
+void scanner_task(void)
+{
+    if (!running)
+        return;
+
+    uint32_t now = HAL_GetTick();
+
+    if (now - rate_window_start >= SCANNER_RATE_WINDOW_MS) {
+        rate = (uint16_t)((rate_reads * 1000u) / (now - rate_window_start));
+        rate_reads = 0;
+        rate_window_start = now;
+    }
+
+    if (sa818_get_settings()->mode != SA818_MODE_RX)
+        return;
+
+    // Keep a few channels queued, the next S+ goes out as soon as the
+    // last RSSI reply is in
+    while (sa818_scan_pending() < SCANNER_AHEAD &&
+           sa818_scan_channel(channel_freq[next_channel], scanner_on_result) == SA818_OK) {
+        if (++next_channel >= channel_count)
+            next_channel = 0;
+    }
+}
+
+uint16_t scanner_get_channel_count(void)
+{
+    return channel_count;
+}
+
+uint32_t scanner_get_frequency(uint16_t index)
+{
+    return (index < channel_count) ? channel_freq[index] : 0;
+}
+
+const scanner_channel_t *scanner_get_channel(uint16_t index)
+{
+    return (index < channel_count) ? &channels[index] : NULL;
+}
+
+uint16_t scanner_get_rate(void)
+{
+    return rate;
+}
+
+uint32_t scanner_get_sweeps(void)
+{
+    return sweeps;
+}
+
+uint32_t scanner_get_update_count(void)
+{
+    return updates;
+}
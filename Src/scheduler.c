@@ -0,0 +1,228 @@
+/**
+ ******************************************************************************
+ * @file      scheduler.c
+ * @brief     Run-to-completion task scheduler, sleeps until a task is ready
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "profile.h"
+#include "scheduler.h"
+
+// ---------------------------------------------------------------------------
+// Configuration
+// ---------------------------------------------------------------------------
+
+#ifdef SCHEDULER_HOST
+#define SCHEDULER_CYCLES_PER_US     1u
+
+static inline uint32_t scheduler_now_ms(void)     { return scheduler_host_get_ms(); }
+static inline uint32_t scheduler_now_cycles(void) { return scheduler_host_get_us(); }
+#else
+#include "stm32h7xx_hal.h"
+#include "system_load.h"
+
+#define SCHEDULER_CYCLES_PER_US     (SystemCoreClock / 1000000u)
+
+static inline uint32_t scheduler_now_ms(void)     { return HAL_GetTick(); }
+static inline uint32_t scheduler_now_cycles(void) { return DWT->CYCCNT; }
+#endif
+
+// ---------------------------------------------------------------------------
+// Internal state
+// ---------------------------------------------------------------------------
+
+typedef struct {
+    scheduler_task_fn_t fn;
+    uint32_t period_ms;
+    uint32_t next_due;      // tick the next periodic run is due
+    uint32_t events;        // SCHEDULER_EVENT_MASK() of the waking events
+    bool ready;
+    uint32_t ready_since;   // cycle count it became ready
+    scheduler_task_stats_t stats;
+} scheduler_task_t;
+
+static scheduler_task_t tasks[SCHEDULER_MAX_TASKS];
+static uint8_t task_count = 0;
+
+// Posted from interrupts. A byte per event makes a post a single store,
+// so it needs no locking against the pass that clears it.
+static volatile uint8_t event_pending[SCHEDULER_EVENT_COUNT];
+static volatile uint32_t event_time[SCHEDULER_EVENT_COUNT];
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+
+static void scheduler_make_ready(scheduler_task_t *task, uint32_t since)
+{
+    // Latency counts from the first reason, a second one adds nothing
+    if (!task->ready) {
+        task->ready = true;
+        task->ready_since = since;
+    }
+}
+
+// True if a pass would find something to do right now
+static bool scheduler_has_work(void)
+{
+    uint32_t now_ms = scheduler_now_ms();
+
+    for (uint8_t e = 0; e < SCHEDULER_EVENT_COUNT; e++) {
+        if (event_pending[e])
+            return true;
+    }
+    for (uint8_t i = 0; i < task_count; i++) {
+        if (tasks[i].period_ms && (int32_t)(now_ms - tasks[i].next_due) >= 0)
+            return true;
+    }
+    return false;
+}
+
+static void scheduler_idle(void)
+{
+#ifdef SCHEDULER_HOST
+    if (!scheduler_has_work())
+        scheduler_host_idle();
+#else
+    // With interrupts masked an interrupt between the check and the WFI
+    // stays pending and ends the WFI, it runs once they are unmasked.
+    // SysTick wakes the core every tick for the periodic tasks.
+    __disable_irq();
+    if (!scheduler_has_work())
+        system_load_sleep();
+    __enable_irq();
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+
+void scheduler_init(void)
+{
+    memset(tasks, 0, sizeof(tasks));
+    task_count = 0;
+    for (uint8_t e = 0; e < SCHEDULER_EVENT_COUNT; e++)
+        event_pending[e] = 0;
+}
+
+int8_t scheduler_add(const char *name, scheduler_task_fn_t fn,
+                     uint32_t period_ms, uint32_t events)
+{
+    if (fn == NULL || task_count >= SCHEDULER_MAX_TASKS)
+        return -1;
+
+    scheduler_task_t *task = &tasks[task_count];
+
+    task->fn = fn;
+    task->period_ms = period_ms;
+    task->next_due = scheduler_now_ms() + period_ms;
+    task->events = events;
+    task->ready = false;
+    task->stats.name = name;
+    task->stats.runs = 0;
+    task->stats.max_latency_us = 0;
+    PROFILE_NAME(PROFILE_TASK_FIRST + task_count, name);
+
+    return (int8_t)task_count++;
+}
+
+void scheduler_post(scheduler_event_t event)
+{
+    if (event >= SCHEDULER_EVENT_COUNT)
+        return;
+
+    // Keep the time of the first post until the pass picks it up
+    if (!event_pending[event]) {
+        event_time[event] = scheduler_now_cycles();
+        event_pending[event] = 1;
+    }
+}
+
+bool scheduler_run_once(void)
+{
+    uint32_t now_ms = scheduler_now_ms();
+    bool ran = false;
+
+    for (uint8_t e = 0; e < SCHEDULER_EVENT_COUNT; e++) {
+        if (!event_pending[e])
+            continue;
+
+        // Clear before reading the time, a post in between is then kept
+        // for the next pass rather than lost
+        event_pending[e] = 0;
+        uint32_t since = event_time[e];
+
+        for (uint8_t i = 0; i < task_count; i++) {
+            if (tasks[i].events & SCHEDULER_EVENT_MASK(e))
+                scheduler_make_ready(&tasks[i], since);
+        }
+    }
+
+    for (uint8_t i = 0; i < task_count; i++) {
+        scheduler_task_t *task = &tasks[i];
+
+        if (task->period_ms == 0 || (int32_t)(now_ms - task->next_due) < 0)
+            continue;
+
+        // Stay on the period grid, but skip the runs missed after a
+        // long stall instead of catching up in a burst
+        task->next_due += task->period_ms;
+        if ((int32_t)(now_ms - task->next_due) >= 0)
+            task->next_due = now_ms + task->period_ms;
+
+        scheduler_make_ready(task, scheduler_now_cycles());
+    }
+
+    for (uint8_t i = 0; i < task_count; i++) {
+        scheduler_task_t *task = &tasks[i];
+
+        if (!task->ready)
+            continue;
+
+        uint32_t latency_us = (scheduler_now_cycles() - task->ready_since) / SCHEDULER_CYCLES_PER_US;
+
+        task->ready = false;
+        task->stats.runs++;
+        if (latency_us > task->stats.max_latency_us)
+            task->stats.max_latency_us = latency_us;
+
+        PROFILE_BEGIN(PROFILE_TASK_FIRST + i);
+        task->fn();
+        PROFILE_END(PROFILE_TASK_FIRST + i);
+        ran = true;
+    }
+
+    return ran;
+}
+
+void scheduler_run(void)
+{
+    for (;;) {
+        scheduler_run_once();
+        scheduler_idle();
+    }
+}
+
+uint8_t scheduler_get_task_count(void)
+{
+    return task_count;
+}
+
+const scheduler_task_stats_t *scheduler_get_stats(uint8_t task)
+{
+    return (task < task_count) ? &tasks[task].stats : NULL;
+}
+
+void scheduler_reset_stats(void)
+{
+    for (uint8_t i = 0; i < task_count; i++) {
+        tasks[i].stats.runs = 0;
+        tasks[i].stats.max_latency_us = 0;
+    }
+}
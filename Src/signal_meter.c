@@ -0,0 +1,180 @@
+/**
+ ******************************************************************************
+ * @file      signal_meter.c
+ * @brief     Signal strength from the received audio, fused with the SA818 RSSI
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include "main.h"
+#include "audio.h"
+#include "attenuator.h"
+#include "sa818.h"
+#include "menu.h"
+#include "signal_meter.h"
+
+// ---------------------------------------------------------------------------
+// Internal state
+// ---------------------------------------------------------------------------
+
+static signal_meter_t meter;
+static uint32_t meter_updates = 0;
+static int16_t meter_last_sample = 0;
+static int16_t meter_offset_db10 = 0;   // bench calibration
+
+// Partial segment carried over between audio blocks
+static uint64_t meter_sum_sq = 0;
+static uint64_t meter_sum_diff_sq = 0;
+static uint16_t meter_peak = 0;
+static uint16_t meter_count = 0;
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+
+static uint32_t signal_meter_isqrt(uint32_t x)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1u << 30;
+
+    while (bit > x)
+        bit >>= 2;
+
+    while (bit) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+// 10 * log10(x) in tenths of dB, 0 for x <= 1
+static int32_t signal_meter_db10(uint32_t x)
+{
+    if (x <= 1)
+        return 0;
+
+    // Integer part of log2, then 8 fraction bits by repeated squaring
+    uint32_t msb = 31 - __builtin_clz(x);
+    uint32_t y = (msb >= 15) ? (x >> (msb - 15)) : (x << (15 - msb));  // 1.15
+    int32_t log2_q8 = (int32_t)msb << 8;
+
+    for (int32_t bit = 128; bit > 0; bit >>= 1) {
+        y = (y * y) >> 15;
+        if (y >= (2u << 15)) {
+            y >>= 1;
+            log2_q8 += bit;
+        }
+    }
+
+    // 10 * log10(2) = 3.0103, in tenths and with the Q8 removed
+    return (log2_q8 * 7707) >> 16;
+}
+
+static void signal_meter_update(void)
+{
+    uint32_t power = (uint32_t)(meter_sum_sq / SIGNAL_METER_SEGMENT);
+    uint32_t noise = (uint32_t)(meter_sum_diff_sq / SIGNAL_METER_SEGMENT);
+
+    meter.rms = (uint16_t)signal_meter_isqrt(power);
+
+    if (meter_peak > meter.peak)
+        meter.peak = meter_peak;
+    else
+        meter.peak -= (meter.peak - meter_peak) >> 3;
+
+    // The reference follows the loudest noise right away and forgets it
+    // over about a minute, so it settles on the no-carrier noise level
+    meter.noise_power = noise;
+    if (noise > meter.noise_ref)
+        meter.noise_ref = noise;
+    else
+        meter.noise_ref -= meter.noise_ref >> 13;
+
+    int32_t quieting = signal_meter_db10(meter.noise_ref) - signal_meter_db10(noise);
+    meter.quieting_db10 = (int16_t)(quieting > 0 ? quieting : 0);
+
+    // The RSSI has the range, the quieting has the resolution near the
+    // floor. Each reads low where it runs out, so take the larger. Both
+    // are measured behind the attenuator, add it back in.
+    int32_t rssi_db10 = (int32_t)(attenuator_get_effective_rssi() * 10.0f) + SIGNAL_METER_RSSI_OFFSET_DBM * 10;
+    int32_t audio_db10 = SIGNAL_METER_FLOOR_DBM * 10 + meter.quieting_db10 +
+                         (int32_t)(attenuator_get() * 10.0f);
+    int32_t level = ((rssi_db10 > audio_db10) ? rssi_db10 : audio_db10) + meter_offset_db10;
+    int16_t previous = meter.level_db10;
+
+    if (meter_updates == 0)
+        meter.level_db10 = (int16_t)level;
+    else
+        meter.level_db10 += (int16_t)((level - meter.level_db10) / 4);
+
+    meter_updates++;
+
+    if (meter.level_db10 != previous)
+        menu_update_display_async();
+}
+
+ITCM_TEXT static void signal_meter_on_block(const int16_t *samples, uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++) {
+        int32_t s = samples[i];
+        int32_t d = s - meter_last_sample;
+        uint16_t a = (uint16_t)(s < 0 ? -s : s);
+
+        meter_last_sample = (int16_t)s;
+        meter_sum_sq += (uint32_t)(s * s);
+        meter_sum_diff_sq += (uint64_t)((int64_t)d * d);
+        if (a > meter_peak)
+            meter_peak = a;
+
+        if (++meter_count == SIGNAL_METER_SEGMENT) {
+            signal_meter_update();
+            meter_sum_sq = 0;
+            meter_sum_diff_sq = 0;
+            meter_peak = 0;
+            meter_count = 0;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+
+void signal_meter_init(void)
+{
+    meter.level_db10 = SIGNAL_METER_FLOOR_DBM * 10;
+    audio_subscribe(signal_meter_on_block);
+}
+
+const signal_meter_t *signal_meter_get(void)
+{
+    return &meter;
+}
+
+int16_t signal_meter_get_level_db10(void)
+{
+    return meter.level_db10;
+}
+
+void signal_meter_set_offset_db10(int16_t offset_db10)
+{
+    if (offset_db10 > SIGNAL_METER_OFFSET_MAX_DB10) offset_db10 = SIGNAL_METER_OFFSET_MAX_DB10;
+    if (offset_db10 < -SIGNAL_METER_OFFSET_MAX_DB10) offset_db10 = -SIGNAL_METER_OFFSET_MAX_DB10;
+    meter_offset_db10 = offset_db10;
+}
+
+int16_t signal_meter_get_offset_db10(void)
+{
+    return meter_offset_db10;
+}
+
+uint32_t signal_meter_get_updates(void)
+{
+    return meter_updates;
+}
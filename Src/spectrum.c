@@ -0,0 +1,221 @@
+/**
+ ******************************************************************************
+ * @file      spectrum.c
+ * @brief     Fixed point FFT of the received audio, one display row per frame
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "stm32h7xx_hal.h"
+#include "main.h"
+#include "audio.h"
+#include "menu.h"
+#include "spectrum.h"
+
+// ---------------------------------------------------------------------------
+// Configuration
+// ---------------------------------------------------------------------------
+
+#define SPECTRUM_HALF       (SPECTRUM_FFT_LEN / 2)   // complex points and bins
+#define SPECTRUM_RANGE_Q4   ((SPECTRUM_RANGE_DB * 16 * 10 + 15) / 30)  // log2 of power, Q4
+
+// ---------------------------------------------------------------------------
+// Internal state
+// ---------------------------------------------------------------------------
+
+// The FFT works on these every hop, DTCM keeps them off the cache
+DTCM_BSS static int16_t window[SPECTRUM_FFT_LEN];       // Hann, Q15
+DTCM_BSS static int16_t twiddle[SPECTRUM_HALF][2];      // cos, sin of 2 * pi * k / N, Q15
+
+DTCM_BSS static int16_t history[SPECTRUM_FFT_LEN];      // last N samples, ring
+static uint16_t history_pos = 0;
+static uint16_t hop_count = 0;
+
+DTCM_BSS static int16_t fft_buf[2 * SPECTRUM_HALF];     // interleaved re, im
+DTCM_BSS static int16_t bin_level[SPECTRUM_HALF];       // log2 of the power, Q4
+static int16_t floor_q4 = 0;
+
+static uint8_t row[SPECTRUM_WIDTH];
+static uint32_t row_count = 0;
+static uint32_t row_cycles = 0;
+static bool enabled = false;
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+
+static int16_t spectrum_log2_q4(uint64_t x)
+{
+    if (x < 2)
+        return 0;
+
+    int16_t msb = 63 - __builtin_clzll(x);
+    uint32_t frac = (msb >= 4) ? (uint32_t)(x >> (msb - 4)) : (uint32_t)(x << (4 - msb));
+    return (int16_t)((msb << 4) | (frac & 0x0F));
+}
+
+// In place radix-2 FFT of SPECTRUM_HALF complex points. Every stage halves
+// the values, like arm_cfft_q15, so nothing can overflow.
+ITCM_TEXT static void spectrum_cfft(int16_t *buf)
+{
+    for (uint32_t i = 1, j = 0; i < SPECTRUM_HALF; i++) {
+        uint32_t bit = SPECTRUM_HALF >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+
+        if (i < j) {
+            int16_t re = buf[2 * i], im = buf[2 * i + 1];
+            buf[2 * i] = buf[2 * j];
+            buf[2 * i + 1] = buf[2 * j + 1];
+            buf[2 * j] = re;
+            buf[2 * j + 1] = im;
+        }
+    }
+
+    for (uint32_t len = 2; len <= SPECTRUM_HALF; len <<= 1) {
+        uint32_t half = len / 2;
+        uint32_t step = SPECTRUM_FFT_LEN / len;
+
+        for (uint32_t k = 0; k < half; k++) {
+            int32_t wr = twiddle[k * step][0];
+            int32_t wi = -twiddle[k * step][1];
+
+            for (uint32_t i = k; i < SPECTRUM_HALF; i += len) {
+                int16_t *a = &buf[2 * i];
+                int16_t *b = &buf[2 * (i + half)];
+                int32_t tr = (b[0] * wr - b[1] * wi) >> 15;
+                int32_t ti = (b[0] * wi + b[1] * wr) >> 15;
+                int32_t ar = a[0], ai = a[1];
+
+                a[0] = (int16_t)((ar + tr) >> 1);
+                a[1] = (int16_t)((ai + ti) >> 1);
+                b[0] = (int16_t)((ar - tr) >> 1);
+                b[1] = (int16_t)((ai - ti) >> 1);
+            }
+        }
+    }
+}
+
+// Even samples went in as the real part and odd ones as the imaginary
+// part, this untangles the two into the bins of the real input
+ITCM_TEXT static void spectrum_split(void)
+{
+    for (uint32_t k = 0; k < SPECTRUM_HALF; k++) {
+        uint32_t m = (SPECTRUM_HALF - k) & (SPECTRUM_HALF - 1);
+        int32_t ar = fft_buf[2 * k], ai = fft_buf[2 * k + 1];
+        int32_t br = fft_buf[2 * m], bi = -fft_buf[2 * m + 1];
+
+        int32_t er = (ar + br) >> 1, ei = (ai + bi) >> 1;
+        int32_t or_ = (ar - br) >> 1, oi = (ai - bi) >> 1;
+        int32_t wr = twiddle[k][0], wi = -twiddle[k][1];
+        int32_t pr = (wr * or_ - wi * oi) >> 15;
+        int32_t pi = (wr * oi + wi * or_) >> 15;
+
+        // X = E - j * W * O
+        int32_t xr = er + pi;
+        int32_t xi = ei - pr;
+        bin_level[k] = spectrum_log2_q4((uint64_t)((int64_t)xr * xr + (int64_t)xi * xi));
+    }
+}
+
+ITCM_TEXT static void spectrum_make_row(void)
+{
+    uint32_t start = DWT->CYCCNT;
+
+    // Window the last N samples, pairs go into one complex point
+    for (uint32_t n = 0; n < SPECTRUM_FFT_LEN; n++) {
+        int16_t x = history[(history_pos + n) & (SPECTRUM_FFT_LEN - 1)];
+        fft_buf[n] = (int16_t)((x * window[n]) >> 15);
+    }
+
+    spectrum_cfft(fft_buf);
+    spectrum_split();
+
+    // Strongest bin per column, the floor follows the quietest column
+    int16_t lowest = INT16_MAX;
+    int16_t levels[SPECTRUM_WIDTH];
+
+    for (uint32_t x = 0; x < SPECTRUM_WIDTH; x++) {
+        uint32_t first = x * SPECTRUM_HALF / SPECTRUM_WIDTH;
+        uint32_t last = (x + 1) * SPECTRUM_HALF / SPECTRUM_WIDTH;
+        int16_t level = bin_level[first];
+
+        for (uint32_t k = first + 1; k < last; k++) {
+            if (bin_level[k] > level)
+                level = bin_level[k];
+        }
+        levels[x] = level;
+        if (level < lowest)
+            lowest = level;
+    }
+
+    floor_q4 += (lowest + 8 - floor_q4) / 8;  // a bit above the quietest, noise shows dark
+
+    for (uint32_t x = 0; x < SPECTRUM_WIDTH; x++) {
+        int32_t v = (levels[x] - floor_q4) * 255 / SPECTRUM_RANGE_Q4;
+        row[x] = (uint8_t)(v < 0 ? 0 : (v > 255 ? 255 : v));
+    }
+
+    row_cycles = DWT->CYCCNT - start;
+    row_count++;
+    menu_update_display_async();
+}
+
+ITCM_TEXT static void spectrum_on_block(const int16_t *samples, uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++) {
+        history[history_pos] = samples[i];
+        history_pos = (history_pos + 1) & (SPECTRUM_FFT_LEN - 1);
+    }
+
+    hop_count += count;
+    if (hop_count < SPECTRUM_HOP)
+        return;
+    hop_count = 0;
+
+    if (enabled)
+        spectrum_make_row();
+}
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+
+void spectrum_init(void)
+{
+    for (uint32_t n = 0; n < SPECTRUM_FFT_LEN; n++)
+        window[n] = (int16_t)lrintf(16383.5f * (1.0f - cosf(2.0f * (float)M_PI * n / SPECTRUM_FFT_LEN)));
+
+    for (uint32_t k = 0; k < SPECTRUM_HALF; k++) {
+        float phase = 2.0f * (float)M_PI * k / SPECTRUM_FFT_LEN;
+        twiddle[k][0] = (int16_t)lrintf(32767.0f * cosf(phase));
+        twiddle[k][1] = (int16_t)lrintf(32767.0f * sinf(phase));
+    }
+
+    audio_subscribe(spectrum_on_block);
+}
+
+void spectrum_enable(bool enable)
+{
+    enabled = enable;
+}
+
+const uint8_t *spectrum_get_row(void)
+{
+    return row;
+}
+
+uint32_t spectrum_get_row_count(void)
+{
+    return row_count;
+}
+
+uint32_t spectrum_get_cycles(void)
+{
+    return row_cycles;
+}
@@ -19,6 +19,9 @@
 #include "stm32h7xx_hal.h"
 #include "stm32h7xx_it.h"
 /* Private includes ----------------------------------------------------------*/
+#include "main.h"
+#include "profile.h"
+#include "system_load.h"
 
 /* Private typedef -----------------------------------------------------------*/
 
@@ -33,11 +36,14 @@
 /* Private user code ---------------------------------------------------------*/
 
 /* External variables --------------------------------------------------------*/
-//extern DMA_HandleTypeDef hdma_adc1;
-//extern DMA_HandleTypeDef hdma_dac1_ch2;
+extern DMA_HandleTypeDef hdma_adc1;
+extern DMA_HandleTypeDef hdma_dac1_ch2;
 extern DMA_HandleTypeDef hdma_usart3_rx;
 extern DMA_HandleTypeDef hdma_usart3_tx;
 extern UART_HandleTypeDef sa818_uart_handle;
+extern DMA_HandleTypeDef hdma_spi4_tx;
+extern SPI_HandleTypeDef display_spi_handle;
+extern TIM_HandleTypeDef htim17;
 
 
 /******************************************************************************/
@@ -124,9 +130,10 @@ void PendSV_Handler(void)
 /**
   * @brief This function handles System tick timer.
   */
-void SysTick_Handler(void)
+ITCM_TEXT void SysTick_Handler(void)
 {
   HAL_IncTick();
+  system_load_tick();
 }
 
 /******************************************************************************/
@@ -139,23 +146,25 @@ void SysTick_Handler(void)
 /**
   * @brief This function handles DMA1 stream0 global interrupt.
   */
-//void DMA1_Stream0_IRQHandler(void)
-//{
-//  HAL_DMA_IRQHandler(&hdma_adc1);
-//}
+ITCM_TEXT void DMA1_Stream0_IRQHandler(void)
+{
+  PROFILE_BEGIN(PROFILE_AUDIO_IRQ);
+  HAL_DMA_IRQHandler(&hdma_adc1);
+  PROFILE_END(PROFILE_AUDIO_IRQ);
+}
 
 /**
   * @brief This function handles DMA1 stream1 global interrupt.
   */
-//void DMA1_Stream1_IRQHandler(void)
-//{
-//  HAL_DMA_IRQHandler(&hdma_dac1_ch2);
-//}
+ITCM_TEXT void DMA1_Stream1_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_dac1_ch2);
+}
 
 /**
   * @brief This function handles DMA1 stream2 global interrupt.
   */
-void DMA1_Stream2_IRQHandler(void)
+ITCM_TEXT void DMA1_Stream2_IRQHandler(void)
 {
   HAL_DMA_IRQHandler(&hdma_usart3_rx);
 }
@@ -163,7 +172,7 @@ void DMA1_Stream2_IRQHandler(void)
 /**
   * @brief This function handles DMA1 stream3 global interrupt.
   */
-void DMA1_Stream3_IRQHandler(void)
+ITCM_TEXT void DMA1_Stream3_IRQHandler(void)
 {
   HAL_DMA_IRQHandler(&hdma_usart3_tx);
 }
@@ -171,7 +180,31 @@ void DMA1_Stream3_IRQHandler(void)
 /**
   * @brief This function handles USART3 global interrupt.
   */
-void USART3_IRQHandler(void)
+ITCM_TEXT void USART3_IRQHandler(void)
 {
   HAL_UART_IRQHandler(&sa818_uart_handle);
 }
+
+/**
+  * @brief This function handles DMA1 stream4 global interrupt.
+  */
+ITCM_TEXT void DMA1_Stream4_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&hdma_spi4_tx);
+}
+
+/**
+  * @brief This function handles SPI4 global interrupt.
+  */
+ITCM_TEXT void SPI4_IRQHandler(void)
+{
+  HAL_SPI_IRQHandler(&display_spi_handle);
+}
+
+/**
+  * @brief This function handles TIM17 global interrupt.
+  */
+ITCM_TEXT void TIM17_IRQHandler(void)
+{
+  HAL_TIM_IRQHandler(&htim17);
+}
@@ -0,0 +1,89 @@
+/**
+ ******************************************************************************
+ * @file      system_load.c
+ * @brief     CPU load from the time the core spends asleep in WFI
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include <stdbool.h>
+
+#include "stm32h7xx_hal.h"
+#include "main.h"
+#include "menu.h"
+#include "system_load.h"
+
+// ---------------------------------------------------------------------------
+// Internal state
+// ---------------------------------------------------------------------------
+
+// Core clock cycles asleep in the current window. Only touched with
+// interrupts masked or from SysTick, so no further locking.
+static volatile uint32_t idle_cycles = 0;
+static uint32_t window_ticks = 0;
+
+static uint32_t load_avg_q8 = 0;      // percent, 8 fraction bits
+static uint8_t load_percent = 0;
+static uint8_t load_last_percent = 0;
+static bool load_valid = false;
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+
+void system_load_sleep(void)
+{
+    // The cycle counter stops with the core clock, SysTick keeps going.
+    // It counts down and its interrupt ends the WFI, so it wraps at most
+    // once while asleep.
+    uint32_t start = SysTick->VAL;
+    __WFI();
+    uint32_t end = SysTick->VAL;
+
+    if (end <= start)
+        idle_cycles += start - end;
+    else
+        idle_cycles += start + (SysTick->LOAD + 1) - end;
+}
+
+ITCM_TEXT void system_load_tick(void)
+{
+    if (++window_ticks < SYSTEM_LOAD_WINDOW_MS)
+        return;
+    window_ticks = 0;
+
+    uint32_t total = SYSTEM_LOAD_WINDOW_MS * (SysTick->LOAD + 1);
+    uint32_t idle = idle_cycles;
+    idle_cycles = 0;
+    if (idle > total)
+        idle = total;
+
+    uint32_t load_q8 = (uint32_t)(((uint64_t)(total - idle) * (100u << 8)) / total);
+
+    if (!load_valid) {
+        load_avg_q8 = load_q8;
+        load_valid = true;
+    } else {
+        load_avg_q8 = (uint32_t)((int32_t)load_avg_q8 +
+                                 (((int32_t)load_q8 - (int32_t)load_avg_q8) >> SYSTEM_LOAD_AVG_SHIFT));
+    }
+
+    uint8_t percent = (uint8_t)((load_avg_q8 + 128) >> 8);
+
+    load_last_percent = (uint8_t)((load_q8 + 128) >> 8);
+    if (percent != load_percent) {
+        load_percent = percent;
+        menu_update_display_async();
+    }
+}
+
+uint8_t system_cpu_load_percent(void)
+{
+    return load_percent;
+}
+
+uint8_t system_cpu_load_last_percent(void)
+{
+    return load_last_percent;
+}
@@ -1,51 +1,63 @@
 #include <math.h>
 
 #include "stm32h7xx_hal.h"
+#include "main.h"
 #include "test_tone.h"
-#include "gpio.h"  // for GPIO definitions if you have one
+#include "dac.h"
 
+#define TESTTONE_TABLE_LEN  64   // samples per sine period
 
 // ---------------------------------------------------------------------------
 // Internal state
 // ---------------------------------------------------------------------------
 static bool tone_enabled = false;
-static uint32_t last_toggle_tick = 0;
-static bool pin_state = false;
+static uint32_t tone_frequency_hz = TESTTONE_FREQUENCY_HZ;
+static uint8_t tone_amplitude = TESTTONE_AMPLITUDE_PERCENT;
+static volatile bool tone_keyed = true;
 
-// Half-period in milliseconds for 500 Hz tone
-// Full period = 1 / f = 1 / 500 = 0.002 s = 2 ms
-// Half-period = 1 ms
-static uint32_t tone_half_period_ms = (uint32_t)(1000.0f / (TESTTONE_FREQUENCY_HZ * 2.0f));
+// One sine period, the DMA plays it to DAC1 channel 2 (PA5) at
+// TESTTONE_TABLE_LEN times the tone frequency. Keyed up it holds mid
+// scale instead, tone_sine keeps the samples.
+DMA_BUFFER static uint16_t tone_table[TESTTONE_TABLE_LEN];
+static uint16_t tone_sine[TESTTONE_TABLE_LEN];
 
 // ---------------------------------------------------------------------------
-// Public API
+// Private helpers
 // ---------------------------------------------------------------------------
-void testtone_init(void)
+static void testtone_fill_table(void)
 {
-    __HAL_RCC_GPIOA_CLK_ENABLE();
+    float peak = (DAC_WAVE_MID - 1) * tone_amplitude / 100.0f;
+
+    for (uint32_t i = 0; i < TESTTONE_TABLE_LEN; i++)
+        tone_sine[i] = (uint16_t)(DAC_WAVE_MID + lrintf(peak * sinf(2.0f * (float)M_PI * i / TESTTONE_TABLE_LEN)));
 
-    GPIO_InitTypeDef GPIO_InitStruct = {0};
-    GPIO_InitStruct.Pin = SA818_AUDIO_IN_Pin;
-    GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
-    GPIO_InitStruct.Pull = GPIO_NOPULL;
-    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
-    HAL_GPIO_Init(SA818_AUDIO_IN_GPIO_Port, &GPIO_InitStruct);
+    // The beacon keys from its interrupt, keep it from copying halfway
+    __disable_irq();
+    testtone_key(tone_keyed);
+    __enable_irq();
+}
 
-    HAL_GPIO_WritePin(SA818_AUDIO_IN_GPIO_Port, SA818_AUDIO_IN_Pin, GPIO_PIN_RESET);
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+void testtone_init(void)
+{
+    dac_wave_init();  // output parked at mid scale
+    testtone_fill_table();
     tone_enabled = false;
-    pin_state = false;
-    last_toggle_tick = HAL_GetTick();
 }
 
 void testtone_enable(bool enable)
 {
+    if (enable == tone_enabled)
+        return;
+
     tone_enabled = enable;
 
-    if (!enable) {
-        // Ensure pin is low when tone disabled
-        HAL_GPIO_WritePin(SA818_AUDIO_IN_GPIO_Port, SA818_AUDIO_IN_Pin, GPIO_PIN_RESET);
-        pin_state = false;
-    }
+    if (enable)
+        dac_wave_start(tone_table, TESTTONE_TABLE_LEN, tone_frequency_hz * TESTTONE_TABLE_LEN);
+    else
+        dac_wave_stop();
 }
 
 bool testtone_is_enabled(void)
@@ -53,17 +65,34 @@ bool testtone_is_enabled(void)
     return tone_enabled;
 }
 
-void testtone_task(void)
+void testtone_key(bool on)
 {
-    if (!tone_enabled)
-        return;
+    tone_keyed = on;
+
+    // The table is not cached, the DMA picks the change up within a period
+    for (uint32_t i = 0; i < TESTTONE_TABLE_LEN; i++)
+        tone_table[i] = on ? tone_sine[i] : DAC_WAVE_MID;
+}
 
-    uint32_t now = HAL_GetTick();
+void testtone_set_frequency(uint32_t frequency_hz)
+{
+    tone_frequency_hz = frequency_hz;
+
+    // Takes effect on the next sample, no restart
+    if (tone_enabled)
+        dac_wave_set_sample_rate(frequency_hz * TESTTONE_TABLE_LEN);
+}
+
+uint32_t testtone_get_frequency(void)
+{
+    return tone_frequency_hz;
+}
+
+void testtone_set_amplitude(uint8_t percent)
+{
+    if (percent > 100) percent = 100;
+    tone_amplitude = percent;
 
-    if ((now - last_toggle_tick) >= tone_half_period_ms)
-    {
-        last_toggle_tick = now;
-        pin_state = !pin_state;
-        HAL_GPIO_WritePin(SA818_AUDIO_IN_GPIO_Port, SA818_AUDIO_IN_Pin, pin_state ? GPIO_PIN_SET : GPIO_PIN_RESET);
-    }
+    // Rewritten in place, at most one period mixes old and new samples
+    testtone_fill_table();
 }
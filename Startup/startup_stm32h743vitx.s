@@ -43,6 +43,17 @@ defined in linker script */
 .word  _sbss
 /* end address for the .bss section. defined in linker script */
 .word  _ebss
+/* load, start and end address of the .itcm_text section. defined in linker script */
+.word  _siitcm
+.word  _sitcm
+.word  _eitcm
+/* load, start and end address of the .dtcm_data section. defined in linker script */
+.word  _sidtcm
+.word  _sdtcm
+.word  _edtcm
+/* start and end address of the .dtcm_bss section. defined in linker script */
+.word  _sdtcmbss
+.word  _edtcmbss
 /* stack used for SystemInit_ExtMemCtl; always internal RAM used */
 
 /**
@@ -95,6 +106,55 @@ LoopFillZerobss:
   cmp r2, r4
   bcc FillZerobss
 
+/* Copy the hot code from flash to ITCM */
+  ldr r0, =_sitcm
+  ldr r1, =_eitcm
+  ldr r2, =_siitcm
+  movs r3, #0
+  b LoopCopyItcmInit
+
+CopyItcmInit:
+  ldr r4, [r2, r3]
+  str r4, [r0, r3]
+  adds r3, r3, #4
+
+LoopCopyItcmInit:
+  adds r4, r0, r3
+  cmp r4, r1
+  bcc CopyItcmInit
+/* Copy the hot data initializers from flash to DTCM */
+  ldr r0, =_sdtcm
+  ldr r1, =_edtcm
+  ldr r2, =_sidtcm
+  movs r3, #0
+  b LoopCopyDtcmInit
+
+CopyDtcmInit:
+  ldr r4, [r2, r3]
+  str r4, [r0, r3]
+  adds r3, r3, #4
+
+LoopCopyDtcmInit:
+  adds r4, r0, r3
+  cmp r4, r1
+  bcc CopyDtcmInit
+/* Zero fill the DTCM bss segment. */
+  ldr r2, =_sdtcmbss
+  ldr r4, =_edtcmbss
+  movs r3, #0
+  b LoopFillZeroDtcmbss
+
+FillZeroDtcmbss:
+  str  r3, [r2]
+  adds r2, r2, #4
+
+LoopFillZeroDtcmbss:
+  cmp r2, r4
+  bcc FillZeroDtcmbss
+/* Make sure the copied code is seen by the instruction fetch */
+  dsb
+  isb
+
 /* Call static constructors */
     bl __libc_init_array
 /* Call the application's entry point.*/
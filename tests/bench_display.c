@@ -0,0 +1,132 @@
+/**
+ ******************************************************************************
+ * @file      bench_display.c
+ * @brief     Bus traffic and host time of the display drawing paths
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details Built twice by "make bench": against the lcd.c and st7735.c of
+ *          this tree and, with BENCH_BASELINE, against the ones of the
+ *          BASELINE revision, so both sides run the same calls on the same
+ *          fake bus. Bus time is at the 15 MHz of SPI4; the baseline sends
+ *          blocking, so the CPU waits all of it. The cpu column is host
+ *          time of the drawing code alone, the bus is only counted then.
+ ******************************************************************************
+ */
+
+#include <stdio.h>
+
+#include "fake_display.h"
+#include "host.h"
+#include "lcd.h"
+#include "st7735.h"
+
+#define BENCH_ROUNDS  200
+
+// Layout of draw_menu_screen() in menu.c
+#define MENU_VISIBLE_LINES   4
+#define LCD_FONT_SIZE        16
+#define LCD_LINE_SPACING     18
+
+extern uint16_t POINT_COLOR;
+extern uint16_t BACK_COLOR;
+
+#ifdef BENCH_BASELINE
+#define BENCH_NAME    "bench_display (baseline)"
+#define FLUSH()       ((void)0)   // drew straight to the panel
+#else
+#define BENCH_NAME    "bench_display"
+#define FLUSH()       lcd_flush_async()
+#endif
+
+// ---------------------------------------------------------------------------
+// Workloads
+// ---------------------------------------------------------------------------
+static void clear_screen(void)
+{
+    lcd_clear();
+    FLUSH();
+}
+
+// The full screen fill of the boot logo fade out, straight to the driver
+static void driver_fill_rect(void)
+{
+    ST7735_FillRect(&st7735_pObj, 0, 0, 160, 80, BLACK);
+}
+
+static void driver_vline(void)
+{
+    ST7735_DrawVLine(&st7735_pObj, 158, 0, 80, GRAY);
+}
+
+// The drawing calls of draw_menu_screen() with the scrollbar, on the first
+// page of the settings menu
+static void menu_redraw(void)
+{
+    static const char *const names[MENU_VISIBLE_LINES] = { "Atten", "Bandwidth", "TX Freq", "RX Freq" };
+    static const char *const values[MENU_VISIBLE_LINES] = { "Auto 12.5 dB", "Wide", "144.4500", "144.4500" };
+
+    lcd_draw_filled_rect(lcd_get_width() - 4, 0, 4, lcd_get_height(), BLACK);
+
+    for (uint8_t i = 0; i < MENU_VISIBLE_LINES; i++) {
+        uint16_t y = 4 + i * LCD_LINE_SPACING;
+        uint16_t bg_color = (i == 1) ? BLUE : BLACK;
+
+        lcd_draw_filled_rect(0, y - 2, lcd_get_width(), LCD_LINE_SPACING, bg_color);
+        POINT_COLOR = WHITE;
+        BACK_COLOR = bg_color;
+        lcd_show_string(4, y, 96, 16, LCD_FONT_SIZE, (uint8_t *)names[i]);
+        lcd_show_string(100, y, lcd_get_width() - 100, 16, LCD_FONT_SIZE, (uint8_t *)values[i]);
+    }
+
+    lcd_draw_filled_rect(lcd_get_width() - 4, 2, 2, lcd_get_height() - 4, GRAY);
+    lcd_draw_filled_rect(lcd_get_width() - 4, 2, 2, 20, WHITE);
+    FLUSH();
+}
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+static void measure(const char *name, void (*work)(void))
+{
+    // Bus cost of one call
+    work();
+    fake_display_reset_stats();
+    work();
+    fake_display_stats_t one = fake_display;
+    uint32_t bus_us = fake_display_bus_us();
+
+    uint64_t best = UINT64_MAX;
+    fake_display_model = false;
+    for (int run = 0; run < 5; run++) {
+        uint64_t start = host_time_ns();
+        for (int i = 0; i < BENCH_ROUNDS; i++)
+            work();
+        uint64_t ns = host_time_ns() - start;
+        if (ns < best)
+            best = ns;
+    }
+    fake_display_model = true;
+
+    printf("  %-18s %6u transfers %7u bytes %6u us bus %8.1f us cpu\n",
+           name, one.transfers, one.bytes, bus_us, (double)best / BENCH_ROUNDS / 1000.0);
+}
+
+int main(void)
+{
+    fake_display_reset();
+    host_tick_free_running = true;      // the driver init spins on the tick
+    lcd_init();
+    host_tick_free_running = false;
+
+    measure("lcd_clear", clear_screen);
+    measure("FillRect 160x80", driver_fill_rect);
+    CHECK(fake_display_pixel(0, 0) == BLACK && fake_display_pixel(159, 79) == BLACK);
+    measure("DrawVLine 80", driver_vline);
+    CHECK(fake_display_pixel(158, 0) == GRAY && fake_display_pixel(158, 79) == GRAY);
+    CHECK(fake_display_pixel(157, 40) == BLACK);
+    measure("menu redraw", menu_redraw);
+    CHECK(fake_display_pixel(0, 24) == BLUE && fake_display_pixel(157, 70) == GRAY);
+
+    return host_report(BENCH_NAME);
+}
@@ -0,0 +1,169 @@
+/**
+ ******************************************************************************
+ * @file      bench_dsp.c
+ * @brief     Host time per audio block of the decoders
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details Each decoder's block callback is taken from audio_subscribe() and
+ *          called directly on the same noisy block, without audio.c. Host
+ *          numbers: they compare the decoders with each other and against
+ *          the 16 ms a block lasts, the cycles on the STM32 are in the
+ *          profile table of a Debug build.
+ ******************************************************************************
+ */
+
+#include <stdio.h>
+
+#include "audio.h"
+#include "beacon.h"
+#include "ctcss.h"
+#include "dtmf.h"
+#include "host.h"
+#include "morse.h"
+#include "sa818.h"
+#include "scheduler.h"
+#include "signal_meter.h"
+
+#define BENCH_BLOCKS  20000
+
+// ---------------------------------------------------------------------------
+// Stand-ins for audio.c and the modules the decoders call
+// ---------------------------------------------------------------------------
+static audio_block_cb_t subscribed = NULL;
+
+bool audio_subscribe(audio_block_cb_t callback)
+{
+    subscribed = callback;
+    return true;
+}
+
+float attenuator_get(void)
+{
+    return 0.0f;
+}
+
+float attenuator_get_effective_rssi(void)
+{
+    return 0.0f;
+}
+
+void menu_update_display_async(void)
+{
+}
+
+// The DTMF commands, never reached on a noise block
+const sa818_settings_t* sa818_get_settings(void)
+{
+    static sa818_settings_t settings;
+    return &settings;
+}
+
+void sa818_set_power_level(sa818_power_t power)
+{
+}
+
+void sa818_set_volume_level(uint8_t vol)
+{
+}
+
+void sa818_set_squelch(uint8_t sq)
+{
+}
+
+bool beacon_is_running(void)
+{
+    return false;
+}
+
+uint32_t beacon_get_cycles(void)
+{
+    return 0;
+}
+
+void beacon_start(void)
+{
+}
+
+void beacon_stop(void)
+{
+}
+
+bool beacon_send_text(const char *text)
+{
+    return true;
+}
+
+void scheduler_post(scheduler_event_t event)
+{
+}
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+static int16_t block[AUDIO_BLOCK_SIZE];
+
+static void make_block(void)
+{
+    uint32_t seed = 1;
+
+    for (uint32_t i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        block[i] = (int16_t)((int32_t)seed >> 20);
+    }
+}
+
+static void measure(const char *name, void (*init)(void))
+{
+    subscribed = NULL;
+    init();
+    if (!CHECK(subscribed != NULL))
+        return;
+
+    audio_block_cb_t on_block = subscribed;
+    uint64_t best = UINT64_MAX;
+
+    for (int run = 0; run < 5; run++) {
+        uint64_t start = host_time_ns();
+        for (int i = 0; i < BENCH_BLOCKS; i++)
+            on_block(block, AUDIO_BLOCK_SIZE);
+        uint64_t ns = host_time_ns() - start;
+        if (ns < best)
+            best = ns;
+    }
+
+    // Decoders that evaluate once per window have a slow block now and
+    // then. The slowest block of a run, the fastest of those runs leaves
+    // out the host's own hiccups.
+    uint64_t slowest = UINT64_MAX;
+    for (int run = 0; run < 9; run++) {
+        uint64_t run_slowest = 0;
+        for (int i = 0; i < BENCH_BLOCKS / 20; i++) {
+            uint64_t start = host_time_ns();
+            on_block(block, AUDIO_BLOCK_SIZE);
+            uint64_t ns = host_time_ns() - start;
+            if (ns > run_slowest)
+                run_slowest = ns;
+        }
+        if (run_slowest < slowest)
+            slowest = run_slowest;
+    }
+
+    double block_ns = (double)best / BENCH_BLOCKS;
+    double period_ns = 1e9 * AUDIO_BLOCK_SIZE / AUDIO_SAMPLE_RATE_HZ;
+    printf("  %-14s %8.0f ns/block %6.2f ns/sample %7.3f %% of the block period, slowest block %6u ns\n",
+           name, block_ns, block_ns / AUDIO_BLOCK_SIZE, 100.0 * block_ns / period_ns,
+           (unsigned)slowest);
+}
+
+int main(void)
+{
+    make_block();
+
+    measure("signal_meter", signal_meter_init);
+    measure("ctcss", ctcss_init);
+    measure("morse", morse_init);
+    measure("dtmf", dtmf_init);
+
+    return host_report("bench_dsp");
+}
@@ -0,0 +1,116 @@
+/**
+ ******************************************************************************
+ * @file      bench_fmt.c
+ * @brief     Time of the firmware's text lines with fmt and with snprintf
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details Host numbers, glibc instead of newlib-nano. They show the ratio,
+ *          not the time on the STM32.
+ ******************************************************************************
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "fmt.h"
+#include "host.h"
+
+#define BENCH_ROUNDS  1000000
+
+#define LINE_LEN      64
+
+typedef char lines_t[3][LINE_LEN];
+
+// Keeps the compiler from dropping the formatting
+static volatile size_t bench_sink;
+
+// ---------------------------------------------------------------------------
+// The lines of the home screen and the DMOSETGROUP command
+// ---------------------------------------------------------------------------
+static size_t lines_fmt(lines_t lines, uint32_t i)
+{
+    uint32_t freq = 144000000u + (i % 64) * 12500u;
+    int32_t level = -1200 + (int32_t)(i % 700);
+    size_t size = LINE_LEN, total = 0, n;
+    char *line = lines[0];
+
+    n = fmt_str(line, size, "RX ");
+    n += fmt_mhz(line + n, size - n, freq);
+    total += n + fmt_str(line + n, size - n, " MHz");
+
+    line = lines[1];
+    n = fmt_str(line, size, "Sig: ");
+    n += fmt_fixed(line + n, size - n, level, 1);
+    total += n + fmt_str(line + n, size - n, " dBm");
+
+    line = lines[2];
+    n = fmt_str(line, size, "AT+DMOSETGROUP=");
+    n += fmt_uint(line + n, size - n, i & 1);
+    n += fmt_str(line + n, size - n, ",");
+    n += fmt_mhz(line + n, size - n, freq);
+    n += fmt_str(line + n, size - n, ",");
+    n += fmt_mhz(line + n, size - n, freq);
+    n += fmt_str(line + n, size - n, ",0000,");
+    n += fmt_uint(line + n, size - n, 4);
+    total += n + fmt_str(line + n, size - n, ",0000\r\n");
+
+    return total;
+}
+
+static size_t lines_snprintf(lines_t lines, uint32_t i)
+{
+    uint32_t freq = 144000000u + (i % 64) * 12500u;
+    int32_t level = -1200 + (int32_t)(i % 700);
+    uint32_t mag = level < 0 ? (uint32_t)-level : (uint32_t)level;
+    uint32_t f = (freq + 50) / 100;
+    size_t total = 0;
+
+    total += (size_t)snprintf(lines[0], LINE_LEN, "RX %" PRIu32 ".%04" PRIu32 " MHz", f / 10000, f % 10000);
+    total += (size_t)snprintf(lines[1], LINE_LEN, "Sig: %s%" PRIu32 ".%" PRIu32 " dBm",
+                              level < 0 ? "-" : "", mag / 10, mag % 10);
+    total += (size_t)snprintf(lines[2], LINE_LEN, "AT+DMOSETGROUP=%" PRIu32 ",%" PRIu32 ".%04" PRIu32
+                              ",%" PRIu32 ".%04" PRIu32 ",0000,%d,0000\r\n",
+                              i & 1, f / 10000, f % 10000, f / 10000, f % 10000, 4);
+    return total;
+}
+
+static uint64_t bench_ns(size_t (*make)(lines_t, uint32_t))
+{
+    lines_t lines;
+    uint64_t best = UINT64_MAX;
+
+    // Best of five against noise from the rest of the machine
+    for (int run = 0; run < 5; run++) {
+        uint64_t start = host_time_ns();
+        for (uint32_t i = 0; i < BENCH_ROUNDS; i++)
+            bench_sink += make(lines, i);
+        uint64_t ns = host_time_ns() - start;
+        if (ns < best)
+            best = ns;
+    }
+    return best;
+}
+
+int main(void)
+{
+    lines_t a = { "" }, b = { "" };
+
+    // Same text from both, or the timing compares different work
+    for (uint32_t i = 0; i < 5000; i++) {
+        if (!CHECK(lines_fmt(a, i) == lines_snprintf(b, i)) ||
+            !CHECK(memcmp(a, b, sizeof(a)) == 0))
+            break;
+    }
+
+    uint64_t fmt_ns = bench_ns(lines_fmt);
+    uint64_t snprintf_ns = bench_ns(lines_snprintf);
+
+    printf("  3 lines, %d rounds\n", BENCH_ROUNDS);
+    printf("  fmt       %6.1f ns/round\n", (double)fmt_ns / BENCH_ROUNDS);
+    printf("  snprintf  %6.1f ns/round (%.1fx)\n", (double)snprintf_ns / BENCH_ROUNDS,
+           (double)snprintf_ns / (double)fmt_ns);
+
+    return host_report("bench_fmt");
+}
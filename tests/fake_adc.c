@@ -0,0 +1,88 @@
+/**
+ ******************************************************************************
+ * @file      fake_adc.c
+ * @brief     ADC1 and its circular DMA as a sample feed, for the host tests
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include "stm32h7xx_hal.h"
+#include "adc.h"
+#include "fake_adc.h"
+
+// ---------------------------------------------------------------------------
+// Internal state
+// ---------------------------------------------------------------------------
+uint32_t fake_adc_rate = 0;
+bool fake_adc_running = false;
+
+static ADC_HandleTypeDef fake_adc_handle = { ADC1 };
+static uint16_t *fake_adc_buffer = NULL;
+static uint32_t fake_adc_length = 0;
+static uint32_t fake_adc_pos = 0;
+
+// The callbacks of audio.c
+extern void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc);
+extern void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc);
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+void fake_adc_feed_raw(const uint16_t *raw, uint32_t count, void (*on_block)(void))
+{
+    if (!fake_adc_running || fake_adc_buffer == NULL)
+        return;
+
+    for (uint32_t i = 0; i < count; i++) {
+        fake_adc_buffer[fake_adc_pos++] = raw[i];
+
+        if (fake_adc_pos == fake_adc_length / 2) {
+            HAL_ADC_ConvHalfCpltCallback(&fake_adc_handle);
+        } else if (fake_adc_pos == fake_adc_length) {
+            fake_adc_pos = 0;
+            HAL_ADC_ConvCpltCallback(&fake_adc_handle);
+        } else {
+            continue;
+        }
+
+        if (on_block)
+            on_block();
+    }
+}
+
+void fake_adc_feed(const int16_t *samples, uint32_t count, void (*on_block)(void))
+{
+    uint16_t raw[64];
+
+    while (count > 0) {
+        uint32_t n = count < 64 ? count : 64;
+        for (uint32_t i = 0; i < n; i++)
+            raw[i] = (uint16_t)(FAKE_ADC_MID + samples[i]);
+        fake_adc_feed_raw(raw, n, on_block);
+        samples += n;
+        count -= n;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// adc.h
+// ---------------------------------------------------------------------------
+void audio_adc_init(uint32_t sample_rate)
+{
+    fake_adc_rate = sample_rate;
+}
+
+uint32_t audio_adc_start(uint16_t *buffer, uint32_t length)
+{
+    fake_adc_buffer = buffer;
+    fake_adc_length = length;
+    fake_adc_pos = 0;
+    fake_adc_running = true;
+    return 0;
+}
+
+void audio_adc_stop(void)
+{
+    fake_adc_running = false;
+}
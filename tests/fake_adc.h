@@ -0,0 +1,46 @@
+/**
+ ******************************************************************************
+ * @file      fake_adc.h
+ * @brief     ADC1 and its circular DMA as a sample feed, for the host tests
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details Implements adc.h. Samples fed in are written to the buffer given
+ *          to audio_adc_start() and the HAL half and full transfer
+ *          callbacks run at the same points as with the DMA.
+ ******************************************************************************
+ */
+
+#ifndef __FAKE_ADC_H
+#define __FAKE_ADC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Mid scale of the 16 bit ADC, where the SA818 audio output idles
+#define FAKE_ADC_MID    32768
+
+extern uint32_t fake_adc_rate;      // from audio_adc_init()
+extern bool fake_adc_running;
+
+/**
+ * @brief Convert raw ADC samples as the DMA would
+ * @param on_block called after every half or full transfer callback, e.g.
+ *        to run the main loop once, may be NULL
+ */
+void fake_adc_feed_raw(const uint16_t *raw, uint32_t count, void (*on_block)(void));
+
+/**
+ * @brief Feed signed audio, offset by FAKE_ADC_MID like the SA818 output
+ */
+void fake_adc_feed(const int16_t *samples, uint32_t count, void (*on_block)(void));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FAKE_ADC_H */
@@ -0,0 +1,235 @@
+/**
+ ******************************************************************************
+ * @file      fake_display.c
+ * @brief     ST7735 panel behind a fake display SPI, for the host tests
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include <string.h>
+
+#include "stm32h7xx_hal.h"
+#include "fake_display.h"
+#include "gpio.h"
+#include "lcd_brightness_timer.h"
+#include "spi.h"
+
+// ---------------------------------------------------------------------------
+// Configuration
+// ---------------------------------------------------------------------------
+#define RAM_COLS        162     // column and row address range of the ST7735
+#define RAM_ROWS        162
+
+#define CMD_CASET       0x2A
+#define CMD_RASET       0x2B
+#define CMD_RAMWR       0x2C
+
+// ---------------------------------------------------------------------------
+// Internal state
+// ---------------------------------------------------------------------------
+fake_display_stats_t fake_display;
+bool fake_display_model = true;
+
+static uint16_t ram[RAM_ROWS][RAM_COLS];
+static uint16_t panel[FAKE_DISPLAY_HEIGHT][FAKE_DISPLAY_WIDTH];
+
+static uint8_t cmd;                 // last command byte
+static uint8_t args[4];
+static uint32_t arg_count;
+static uint16_t col_start, col_end, row_start, row_end;
+static uint16_t col, row;           // RAMWR write position
+static uint8_t pixel_high;          // first byte of a pixel
+static bool pixel_half;
+
+static uint32_t queued_inline;      // bytes of the last queued short data transfer
+
+static uint32_t brightness;
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+static void panel_command(uint8_t value)
+{
+    cmd = value;
+    arg_count = 0;
+    if (cmd == CMD_RAMWR) {
+        col = col_start;
+        row = row_start;
+        pixel_half = false;
+    }
+    fake_display.commands++;
+}
+
+static void panel_pixel(uint16_t color)
+{
+    if (row < RAM_ROWS && col < RAM_COLS)
+        ram[row][col] = color;
+    fake_display.pixels++;
+
+    // The window wraps to the next row and back to the top
+    if (++col > col_end) {
+        col = col_start;
+        if (++row > row_end)
+            row = row_start;
+    }
+}
+
+static void panel_data(const uint8_t *data, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i++) {
+        if (cmd == CMD_RAMWR) {
+            if (pixel_half)
+                panel_pixel((uint16_t)((pixel_high << 8) | data[i]));
+            else
+                pixel_high = data[i];
+            pixel_half = !pixel_half;
+        } else if (arg_count < sizeof(args)) {
+            // Start and end take effect one at a time, ST7735_SetCursor()
+            // sends only the start
+            args[arg_count++] = data[i];
+            uint16_t value = (uint16_t)((args[(arg_count - 1) & ~1u] << 8) | data[i]);
+            if (cmd == CMD_CASET && arg_count == 2)
+                col_start = value;
+            else if (cmd == CMD_CASET && arg_count == 4)
+                col_end = value;
+            else if (cmd == CMD_RASET && arg_count == 2)
+                row_start = value;
+            else if (cmd == CMD_RASET && arg_count == 4)
+                row_end = value;
+        }
+    }
+}
+
+static void panel_transfer(bool command, const uint8_t *data, uint32_t len)
+{
+    fake_display.transfers++;
+    fake_display.bytes += len;
+
+    if (!fake_display_model)
+        return;
+
+    if (command && len > 0) {
+        panel_command(data[0]);
+        panel_data(data + 1, len - 1);
+    } else {
+        panel_data(data, len);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+void fake_display_reset(void)
+{
+    memset(ram, 0, sizeof(ram));
+    cmd = 0;
+    arg_count = 0;
+    col_start = row_start = 0;
+    col_end = RAM_COLS - 1;
+    row_end = RAM_ROWS - 1;
+    queued_inline = 0;
+    fake_display_reset_stats();
+}
+
+void fake_display_reset_stats(void)
+{
+    memset(&fake_display, 0, sizeof(fake_display));
+}
+
+uint32_t fake_display_bus_us(void)
+{
+    return (uint32_t)((uint64_t)fake_display.bytes * 8u * 1000000u / FAKE_DISPLAY_SPI_HZ);
+}
+
+uint16_t fake_display_pixel(uint32_t x, uint32_t y)
+{
+    return ram[y + FAKE_DISPLAY_Y_OFFSET][x + FAKE_DISPLAY_X_OFFSET];
+}
+
+const uint16_t *fake_display_panel(void)
+{
+    for (uint32_t y = 0; y < FAKE_DISPLAY_HEIGHT; y++) {
+        for (uint32_t x = 0; x < FAKE_DISPLAY_WIDTH; x++)
+            panel[y][x] = fake_display_pixel(x, y);
+    }
+    return &panel[0][0];
+}
+
+// ---------------------------------------------------------------------------
+// spi.h
+// ---------------------------------------------------------------------------
+void display_spi_init(void)
+{
+}
+
+// RS low on the pin is a command, the driver sends the register byte alone
+uint32_t display_spi_transmit(const uint8_t *data, uint16_t size, uint32_t timeout)
+{
+    bool command = !(LCD_WR_RS_GPIO_Port->ODR & LCD_WR_RS_Pin);
+    panel_transfer(command, data, size);
+    queued_inline = 0;
+    return 0;
+}
+
+uint32_t display_spi_receive(uint8_t *data, uint16_t size, uint32_t timeout)
+{
+    memset(data, 0, size);
+    return 0;
+}
+
+// Done at once, so the queue never fills and is never busy. Short data
+// joins the transfer before it as in the driver, it is one DMA transfer.
+bool display_spi_queue_transfer(bool command, const uint8_t *data, uint16_t len)
+{
+    if (data == NULL || len == 0)
+        return true;
+
+    if (!command && len <= DISPLAY_SPI_INLINE_LEN && queued_inline > 0 &&
+        queued_inline + len <= DISPLAY_SPI_INLINE_LEN) {
+        fake_display.bytes += len;
+        if (fake_display_model)
+            panel_data(data, len);
+        queued_inline += len;
+        return true;
+    }
+
+    panel_transfer(command, data, len);
+    queued_inline = (!command && len <= DISPLAY_SPI_INLINE_LEN) ? len : 0;
+    return true;
+}
+
+uint8_t display_spi_queue_free(void)
+{
+    return 255;
+}
+
+bool display_spi_busy(void)
+{
+    return false;
+}
+
+void display_spi_wait_idle(void)
+{
+}
+
+// ---------------------------------------------------------------------------
+// lcd_brightness_timer.h
+// ---------------------------------------------------------------------------
+void lcd_brightness_timer_init(void)
+{
+}
+
+void lcd_brightness_timer_start(void)
+{
+}
+
+void lcd_brightness_timer_set_brightness(int value)
+{
+    brightness = (uint32_t)value;
+}
+
+uint32_t lcd_brightness_timer_get_brightness(void)
+{
+    return brightness;
+}
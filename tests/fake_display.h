@@ -0,0 +1,64 @@
+/**
+ ******************************************************************************
+ * @file      fake_display.h
+ * @brief     ST7735 panel behind a fake display SPI, for the host tests
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details Implements spi.h and lcd_brightness_timer.h. Blocking and queued
+ *          transfers are counted and applied to a model of the controller
+ *          RAM (CASET, RASET and RAMWR), so a test can check what the panel
+ *          shows and what it cost on the bus.
+ ******************************************************************************
+ */
+
+#ifndef __FAKE_DISPLAY_H
+#define __FAKE_DISPLAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// SPI4 runs from the 120 MHz APB2 clock with prescaler 8
+#define FAKE_DISPLAY_SPI_HZ     15000000u
+
+// Visible area in controller RAM, landscape rotated HannStar 0.96" panel
+#define FAKE_DISPLAY_X_OFFSET   1
+#define FAKE_DISPLAY_Y_OFFSET   26
+#define FAKE_DISPLAY_WIDTH      160
+#define FAKE_DISPLAY_HEIGHT     80
+
+typedef struct {
+    uint32_t transfers;     // blocking calls plus queued transfers
+    uint32_t commands;      // register writes
+    uint32_t bytes;         // everything on the bus, commands included
+    uint32_t pixels;        // written through RAMWR
+} fake_display_stats_t;
+
+extern fake_display_stats_t fake_display;
+
+// Off, transfers are only counted. Benchmarks time the drawing code, not
+// the panel model.
+extern bool fake_display_model;
+
+// Clears the statistics and the panel
+void fake_display_reset(void);
+void fake_display_reset_stats(void);
+
+// Bus time of the counted bytes at FAKE_DISPLAY_SPI_HZ
+uint32_t fake_display_bus_us(void);
+
+// Visible pixel as the panel shows it, RGB565
+uint16_t fake_display_pixel(uint32_t x, uint32_t y);
+
+// Visible area, row-major RGB565, FAKE_DISPLAY_WIDTH pixels per row
+const uint16_t *fake_display_panel(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FAKE_DISPLAY_H */
@@ -0,0 +1,254 @@
+/**
+ ******************************************************************************
+ * @file      fake_sa818_uart.c
+ * @brief     SA818 module behind a fake sa818_uart, for the host tests
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fake_sa818_uart.h"
+#include "host.h"
+#include "sa818_uart.h"
+
+// ---------------------------------------------------------------------------
+// Configuration
+// ---------------------------------------------------------------------------
+#define FAKE_SA818_PENDING   8      // replies on their way
+#define FAKE_SA818_RX_LEN    512
+
+// ---------------------------------------------------------------------------
+// Internal state
+// ---------------------------------------------------------------------------
+typedef struct {
+    uint32_t due;
+    char line[40];
+} fake_reply_t;
+
+fake_sa818_t fake_sa818;
+
+static fake_sa818_cmd_t fake_log[FAKE_SA818_LOG_LEN];
+static unsigned fake_log_count = 0;
+
+static fake_reply_t fake_pending[FAKE_SA818_PENDING];
+static unsigned fake_pending_count = 0;
+
+static char fake_rx[FAKE_SA818_RX_LEN];     // lines received, not read yet
+static uint32_t fake_tx_end = 0;            // tick the command is on the wire
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+static bool fake_starts_with(const char *text, const char *prefix)
+{
+    return strncmp(text, prefix, strlen(prefix)) == 0;
+}
+
+static uint8_t fake_rssi_at(uint32_t freq_hz)
+{
+    return fake_sa818.band_rssi ? fake_sa818.band_rssi(freq_hz) : fake_sa818.rssi;
+}
+
+// What the module answers, empty for commands it ignores
+static void fake_make_reply(const char *cmd, char *reply, size_t size)
+{
+    reply[0] = '\0';
+
+    if (fake_starts_with(cmd, "AT+DMOCONNECT")) {
+        snprintf(reply, size, "+DMOCONNECT:0");
+    } else if (fake_starts_with(cmd, "AT+DMOSETGROUP=")) {
+        // BW,TX_F,RX_F,...
+        const char *rx = strchr(cmd, ',');
+        rx = rx ? strchr(rx + 1, ',') : NULL;
+        if (rx && fake_sa818.result == 0)
+            fake_sa818.tuned_hz = fake_sa818_parse_mhz(rx + 1);
+        snprintf(reply, size, "+DMOSETGROUP:%u", fake_sa818.result);
+    } else if (fake_starts_with(cmd, "AT+DMOSETVOLUME=")) {
+        snprintf(reply, size, "+DMOSETVOLUME:%u", fake_sa818.result);
+    } else if (fake_starts_with(cmd, "AT+SETFILTER=")) {
+        snprintf(reply, size, "+DMOSETFILTER:%u", fake_sa818.result);
+    } else if (fake_starts_with(cmd, "AT+SETTAIL=")) {
+        snprintf(reply, size, "+DMOSETTAIL:%u", fake_sa818.result);
+    } else if (fake_starts_with(cmd, "AT+VERSION")) {
+        snprintf(reply, size, "+VERSION:SA818_V5.0");
+    } else if (fake_starts_with(cmd, "S+")) {
+        fake_sa818.tuned_hz = fake_sa818_parse_mhz(cmd + 2);
+        // S=0 is a signal above the squelch
+        snprintf(reply, size, "S=%d", fake_rssi_at(fake_sa818.tuned_hz) > 0 ? 0 : 1);
+    } else if (fake_starts_with(cmd, "RSSI?")) {
+        snprintf(reply, size, "RSSI=%u", fake_rssi_at(fake_sa818.tuned_hz));
+    }
+}
+
+static void fake_receive_cmd(const char *data, size_t len, uint32_t on_wire)
+{
+    char cmd[FAKE_SA818_CMD_LEN];
+
+    if (len >= sizeof(cmd))
+        len = sizeof(cmd) - 1;
+    memcpy(cmd, data, len);
+    cmd[len] = '\0';
+    cmd[strcspn(cmd, "\r\n")] = '\0';
+
+    if (fake_log_count < FAKE_SA818_LOG_LEN) {
+        fake_log[fake_log_count].tick = on_wire;
+        strcpy(fake_log[fake_log_count].cmd, cmd);
+        fake_log_count++;
+    }
+
+    fake_reply_t reply;
+    fake_make_reply(cmd, reply.line, sizeof(reply.line));
+    if (fake_sa818.silent || reply.line[0] == '\0' || fake_pending_count >= FAKE_SA818_PENDING)
+        return;
+
+    reply.due = on_wire + fake_sa818.reply_ms;
+    fake_pending[fake_pending_count++] = reply;
+}
+
+// Moves the replies that are due into the receive buffer, in order
+static void fake_step(void)
+{
+    unsigned kept = 0;
+
+    for (unsigned i = 0; i < fake_pending_count; i++) {
+        if ((int32_t)(host_tick - fake_pending[i].due) >= 0) {
+            strncat(fake_rx, fake_pending[i].line, sizeof(fake_rx) - strlen(fake_rx) - 3);
+            strcat(fake_rx, "\r\n");
+        } else {
+            fake_pending[kept++] = fake_pending[i];
+        }
+    }
+    fake_pending_count = kept;
+}
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+void fake_sa818_reset(void)
+{
+    memset(&fake_sa818, 0, sizeof(fake_sa818));
+    fake_sa818.reply_ms = 10;
+    fake_sa818.rssi = 40;
+
+    fake_log_count = 0;
+    fake_pending_count = 0;
+    fake_rx[0] = '\0';
+    fake_tx_end = host_tick;
+    host_on_tick = fake_step;
+}
+
+unsigned fake_sa818_log_count(void)
+{
+    return fake_log_count;
+}
+
+const fake_sa818_cmd_t *fake_sa818_log(unsigned index)
+{
+    return index < fake_log_count ? &fake_log[index] : NULL;
+}
+
+unsigned fake_sa818_count(const char *prefix)
+{
+    unsigned n = 0;
+    for (unsigned i = 0; i < fake_log_count; i++) {
+        if (fake_starts_with(fake_log[i].cmd, prefix))
+            n++;
+    }
+    return n;
+}
+
+const fake_sa818_cmd_t *fake_sa818_last(const char *prefix)
+{
+    for (unsigned i = fake_log_count; i-- > 0;) {
+        if (fake_starts_with(fake_log[i].cmd, prefix))
+            return &fake_log[i];
+    }
+    return NULL;
+}
+
+uint32_t fake_sa818_parse_mhz(const char *text)
+{
+    char *end;
+    uint32_t mhz = (uint32_t)strtoul(text, &end, 10);
+    uint32_t hz = mhz * 1000000u;
+
+    if (*end == '.') {
+        uint32_t scale = 100000;
+        for (const char *p = end + 1; *p >= '0' && *p <= '9' && scale; p++) {
+            hz += (uint32_t)(*p - '0') * scale;
+            scale /= 10;
+        }
+    }
+    return hz;
+}
+
+// ---------------------------------------------------------------------------
+// sa818_uart.h
+// ---------------------------------------------------------------------------
+void sa818_uart_init(void)
+{
+}
+
+void sa818_uart_transmit(const char *cmd)
+{
+    // Blocking, the caller waits on the wire time
+    size_t len = strlen(cmd);
+    host_advance_ms((uint32_t)len);
+    fake_tx_end = host_tick;
+    fake_receive_cmd(cmd, len, host_tick);
+}
+
+void sa818_uart_flush(void)
+{
+    fake_rx[0] = '\0';
+}
+
+void sa818_uart_tx_dma(const char *data, uint16_t len)
+{
+    fake_tx_end = host_tick + len;
+    fake_receive_cmd(data, len, fake_tx_end);
+}
+
+bool sa818_uart_tx_done(void)
+{
+    return (int32_t)(host_tick - fake_tx_end) >= 0;
+}
+
+size_t sa818_uart_read_line(char *line, size_t size)
+{
+    fake_step();
+
+    char *end = strstr(fake_rx, "\r\n");
+    if (end == NULL || size == 0)
+        return 0;
+
+    size_t len = (size_t)(end - fake_rx);
+    size_t copy = len < size - 1 ? len : size - 1;
+    memcpy(line, fake_rx, copy);
+    line[copy] = '\0';
+    memmove(fake_rx, end + 2, strlen(end + 2) + 1);
+    return copy;
+}
+
+size_t sa818_uart_receive_line(char *line, size_t size, uint32_t timeout)
+{
+    uint32_t start = host_tick;
+
+    for (;;) {
+        size_t len = sa818_uart_read_line(line, size);
+        if (len > 0)
+            return len;
+        if (host_tick - start >= timeout)
+            return 0;
+        host_advance_ms(1);
+    }
+}
+
+uint32_t sa818_uart_rx_dropped(void)
+{
+    return 0;
+}
@@ -0,0 +1,66 @@
+/**
+ ******************************************************************************
+ * @file      fake_sa818_uart.h
+ * @brief     SA818 module behind a fake sa818_uart, for the host tests
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details Implements sa818_uart.h. Every command takes one simulated ms per
+ *          byte on the wire (9600 baud), the reply line follows
+ *          fake_sa818.reply_ms later. The module keeps the frequency of the
+ *          last DMOSETGROUP or S+ and answers S+ and RSSI? from the band.
+ ******************************************************************************
+ */
+
+#ifndef __FAKE_SA818_UART_H
+#define __FAKE_SA818_UART_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define FAKE_SA818_LOG_LEN   512
+#define FAKE_SA818_CMD_LEN   64
+
+typedef struct {
+    uint32_t reply_ms;          // from the end of the command to its reply
+    bool silent;                // drop every reply, for timeouts
+    uint8_t result;             // result code of the +DMO... replies
+    uint8_t rssi;               // RSSI? reply without a band model
+    uint32_t tuned_hz;          // frequency the receiver is on
+
+    // Band model, optional. Signal strength at a frequency, 0 for none.
+    uint8_t (*band_rssi)(uint32_t freq_hz);
+} fake_sa818_t;
+
+typedef struct {
+    uint32_t tick;              // when the command was complete on the wire
+    char cmd[FAKE_SA818_CMD_LEN];   // without CR/LF
+} fake_sa818_cmd_t;
+
+extern fake_sa818_t fake_sa818;
+
+// Back to the power up state with an empty log, hooks host_on_tick
+void fake_sa818_reset(void);
+
+// Commands received since the reset
+unsigned fake_sa818_log_count(void);
+const fake_sa818_cmd_t *fake_sa818_log(unsigned index);
+
+// Number of logged commands that start with prefix
+unsigned fake_sa818_count(const char *prefix);
+
+// Last logged command that starts with prefix, NULL if none
+const fake_sa818_cmd_t *fake_sa818_last(const char *prefix);
+
+// Parses "144.4500" style frequencies as the module does
+uint32_t fake_sa818_parse_mhz(const char *text);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __FAKE_SA818_UART_H */
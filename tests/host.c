@@ -0,0 +1,96 @@
+/**
+ ******************************************************************************
+ * @file      host.c
+ * @brief     Simulated clock, checks and timing shared by the host tests
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "stm32h7xx_hal.h"
+#include "host.h"
+
+// ---------------------------------------------------------------------------
+// Internal state
+// ---------------------------------------------------------------------------
+uint32_t host_tick = 0;
+bool host_tick_free_running = false;
+void (*host_on_tick)(void) = NULL;
+GPIO_TypeDef host_gpio[5];
+ADC_TypeDef host_adc[3];
+TIM_TypeDef host_tim17;
+
+static unsigned host_checks = 0;
+static unsigned host_failures = 0;
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+void host_advance_ms(uint32_t ms)
+{
+    while (ms--) {
+        host_tick++;
+        if (host_on_tick)
+            host_on_tick();
+    }
+}
+
+bool host_check(bool ok, const char *expr, const char *file, int line)
+{
+    host_checks++;
+    if (!ok) {
+        host_failures++;
+        printf("%s:%d: check failed: %s\n", file, line, expr);
+    }
+    return ok;
+}
+
+int host_report(const char *name)
+{
+    printf("%s: %u checks, %u failed\n", name, host_checks, host_failures);
+    return host_failures ? 1 : 0;
+}
+
+uint64_t host_time_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+// ---------------------------------------------------------------------------
+// HAL stand-ins
+// ---------------------------------------------------------------------------
+uint32_t HAL_GetTick(void)
+{
+    if (host_tick_free_running)
+        host_advance_ms(1);
+    return host_tick;
+}
+
+void HAL_Delay(uint32_t delay)
+{
+    host_advance_ms(delay);
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init)
+{
+    (void)port;
+    (void)init;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state)
+{
+    if (state == GPIO_PIN_SET)
+        port->ODR |= pin;
+    else
+        port->ODR &= ~(uint32_t)pin;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin)
+{
+    return (port->IDR & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
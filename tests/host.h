@@ -0,0 +1,51 @@
+/**
+ ******************************************************************************
+ * @file      host.h
+ * @brief     Simulated clock, checks and timing shared by the host tests
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#ifndef __HOST_H
+#define __HOST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// HAL_GetTick(), only moves when the test moves it
+extern uint32_t host_tick;
+
+// When set, every HAL_GetTick() call is a ms later, for driver code that
+// waits by spinning on the tick
+extern bool host_tick_free_running;
+
+// Called once per ms of simulated time, so a fake peripheral can progress
+// while code blocks in HAL_Delay() or a fake
+extern void (*host_on_tick)(void);
+
+void host_advance_ms(uint32_t ms);
+
+// Counts a failure and prints where, returns ok
+bool host_check(bool ok, const char *expr, const char *file, int line);
+
+#define CHECK(cond)  host_check((cond), #cond, __FILE__, __LINE__)
+
+/**
+ * @brief Prints the result line of the test program
+ * @return Exit code for main(), non-zero after a failed check
+ */
+int host_report(const char *name);
+
+// Monotonic wall clock for the benchmarks
+uint64_t host_time_ns(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HOST_H */
@@ -0,0 +1,150 @@
+/**
+ ******************************************************************************
+ * @file      png.c
+ * @brief     Minimal PNG writer for screen dumps of the host tests
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details The image data is a zlib stream of stored (uncompressed) deflate
+ *          blocks, which every viewer reads and which needs no library.
+ ******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "png.h"
+
+// ---------------------------------------------------------------------------
+// Configuration
+// ---------------------------------------------------------------------------
+#define PNG_STORED_BLOCK_MAX   65535u
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+static uint32_t png_crc32(uint32_t crc, const uint8_t *data, size_t len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc ^= *data++;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+    }
+    return ~crc;
+}
+
+static void png_put_be32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+// Length, type, data and the CRC over type and data
+static bool png_write_chunk(FILE *f, const char *type, const uint8_t *data, uint32_t len)
+{
+    uint8_t head[8], tail[4];
+
+    png_put_be32(head, len);
+    memcpy(head + 4, type, 4);
+    png_put_be32(tail, png_crc32(png_crc32(0, head + 4, 4), data, len));
+
+    return fwrite(head, 1, 8, f) == 8 &&
+           (len == 0 || fwrite(data, 1, len, f) == len) &&
+           fwrite(tail, 1, 4, f) == 4;
+}
+
+static void png_rgb565_to_rgb(uint16_t c, uint8_t *rgb)
+{
+    uint8_t r = (uint8_t)(c >> 11), g = (uint8_t)((c >> 5) & 0x3F), b = (uint8_t)(c & 0x1F);
+    rgb[0] = (uint8_t)((r << 3) | (r >> 2));
+    rgb[1] = (uint8_t)((g << 2) | (g >> 4));
+    rgb[2] = (uint8_t)((b << 3) | (b >> 2));
+}
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+bool png_write_rgb565(const char *path, const uint16_t *pixels, uint32_t width, uint32_t height,
+                      uint32_t stride, bool swapped, uint32_t scale)
+{
+    if (scale == 0)
+        scale = 1;
+
+    uint32_t out_w = width * scale, out_h = height * scale;
+    uint32_t row_len = 1 + out_w * 3;                   // filter byte + RGB
+    size_t raw_len = (size_t)row_len * out_h;
+    size_t blocks = (raw_len + PNG_STORED_BLOCK_MAX - 1) / PNG_STORED_BLOCK_MAX;
+    size_t zlen = 2 + raw_len + blocks * 5 + 4;
+
+    uint8_t *raw = malloc(raw_len);
+    uint8_t *z = malloc(zlen);
+    if (raw == NULL || z == NULL) {
+        free(raw);
+        free(z);
+        return false;
+    }
+
+    // Filter type 0 (none) on every row
+    for (uint32_t y = 0; y < out_h; y++) {
+        uint8_t *row = raw + (size_t)y * row_len;
+        row[0] = 0;
+        for (uint32_t x = 0; x < out_w; x++) {
+            uint16_t c = pixels[(y / scale) * stride + x / scale];
+            if (swapped)
+                c = (uint16_t)((c << 8) | (c >> 8));
+            png_rgb565_to_rgb(c, row + 1 + x * 3);
+        }
+    }
+
+    // zlib header, stored blocks, Adler-32 of the raw data
+    size_t n = 0;
+    z[n++] = 0x78;
+    z[n++] = 0x01;
+    for (size_t done = 0; done < raw_len;) {
+        uint32_t len = (uint32_t)(raw_len - done > PNG_STORED_BLOCK_MAX ? PNG_STORED_BLOCK_MAX : raw_len - done);
+        z[n++] = (done + len == raw_len) ? 1 : 0;       // BFINAL, BTYPE 00
+        z[n++] = (uint8_t)len;
+        z[n++] = (uint8_t)(len >> 8);
+        z[n++] = (uint8_t)~len;
+        z[n++] = (uint8_t)(~len >> 8);
+        memcpy(z + n, raw + done, len);
+        n += len;
+        done += len;
+    }
+
+    uint32_t a = 1, b = 0;
+    for (size_t i = 0; i < raw_len; i++) {
+        a = (a + raw[i]) % 65521u;
+        b = (b + a) % 65521u;
+    }
+    png_put_be32(z + n, (b << 16) | a);
+    n += 4;
+
+    uint8_t ihdr[13];
+    png_put_be32(ihdr, out_w);
+    png_put_be32(ihdr + 4, out_h);
+    ihdr[8] = 8;        // bits per channel
+    ihdr[9] = 2;        // RGB
+    ihdr[10] = 0;       // deflate
+    ihdr[11] = 0;       // adaptive filtering
+    ihdr[12] = 0;       // no interlace
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    bool ok = false;
+    FILE *f = fopen(path, "wb");
+    if (f) {
+        ok = fwrite(signature, 1, sizeof(signature), f) == sizeof(signature) &&
+             png_write_chunk(f, "IHDR", ihdr, sizeof(ihdr)) &&
+             png_write_chunk(f, "IDAT", z, (uint32_t)n) &&
+             png_write_chunk(f, "IEND", NULL, 0);
+        ok = (fclose(f) == 0) && ok;
+    }
+
+    free(raw);
+    free(z);
+    return ok;
+}
@@ -0,0 +1,35 @@
+/**
+ ******************************************************************************
+ * @file      png.h
+ * @brief     Minimal PNG writer for screen dumps of the host tests
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#ifndef __PNG_H
+#define __PNG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Write RGB565 pixels as an 8 bit RGB PNG, uncompressed
+ * @param pixels row-major, stride pixels from one row to the next
+ * @param swapped true for panel byte order (high byte first), the order
+ *        of the framebuffer
+ * @param scale  each pixel becomes scale x scale, to look at a small panel
+ * @return false when the file could not be written
+ */
+bool png_write_rgb565(const char *path, const uint16_t *pixels, uint32_t width, uint32_t height,
+                      uint32_t stride, bool swapped, uint32_t scale);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PNG_H */
@@ -0,0 +1,133 @@
+/**
+ ******************************************************************************
+ * @file      stm32h7xx_hal.h
+ * @brief     Host stand-in for the HAL, only what the tested modules use
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details Found ahead of the CubeMX headers on the include path of the
+ *          host build. Pins and registers are plain memory the tests can
+ *          read back, time is the simulated tick of host.c.
+ ******************************************************************************
+ */
+
+#ifndef __STM32H7XX_HAL_H
+#define __STM32H7XX_HAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Types ----------------------------------------------------------------------*/
+
+typedef enum {
+  HAL_OK = 0,
+  HAL_ERROR,
+  HAL_BUSY,
+  HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+typedef enum {
+  GPIO_PIN_RESET = 0,
+  GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct {
+  volatile uint32_t IDR;
+  volatile uint32_t ODR;
+  volatile uint32_t BSRR;
+} GPIO_TypeDef;
+
+typedef struct {
+  volatile uint32_t ISR;
+} ADC_TypeDef;
+
+typedef struct {
+  ADC_TypeDef *Instance;
+} ADC_HandleTypeDef;
+
+typedef struct {
+  volatile uint32_t CNT;
+} TIM_TypeDef;
+
+typedef struct {
+  TIM_TypeDef *Instance;
+} TIM_HandleTypeDef;
+
+typedef struct {
+  uint32_t Pin;
+  uint32_t Mode;
+  uint32_t Pull;
+  uint32_t Speed;
+  uint32_t Alternate;
+} GPIO_InitTypeDef;
+
+/* Defines --------------------------------------------------------------------*/
+
+extern GPIO_TypeDef host_gpio[5];
+
+#define GPIOA (&host_gpio[0])
+#define GPIOB (&host_gpio[1])
+#define GPIOC (&host_gpio[2])
+#define GPIOD (&host_gpio[3])
+#define GPIOE (&host_gpio[4])
+
+extern ADC_TypeDef host_adc[3];
+
+#define ADC1  (&host_adc[0])
+#define ADC2  (&host_adc[1])
+#define ADC3  (&host_adc[2])
+
+extern TIM_TypeDef host_tim17;
+
+#define TIM17 (&host_tim17)
+
+#define GPIO_PIN_0   0x0001u
+#define GPIO_PIN_1   0x0002u
+#define GPIO_PIN_2   0x0004u
+#define GPIO_PIN_3   0x0008u
+#define GPIO_PIN_4   0x0010u
+#define GPIO_PIN_5   0x0020u
+#define GPIO_PIN_6   0x0040u
+#define GPIO_PIN_7   0x0080u
+#define GPIO_PIN_8   0x0100u
+#define GPIO_PIN_9   0x0200u
+#define GPIO_PIN_10  0x0400u
+#define GPIO_PIN_11  0x0800u
+#define GPIO_PIN_12  0x1000u
+#define GPIO_PIN_13  0x2000u
+#define GPIO_PIN_14  0x4000u
+#define GPIO_PIN_15  0x8000u
+
+#define GPIO_MODE_INPUT       0u
+#define GPIO_MODE_OUTPUT_PP   1u
+#define GPIO_NOPULL           0u
+#define GPIO_PULLUP           1u
+#define GPIO_SPEED_FREQ_LOW   0u
+#define GPIO_SPEED_FREQ_HIGH  2u
+
+#define __disable_irq()  ((void)0)
+#define __enable_irq()   ((void)0)
+
+// No data cache on the host
+#define SCB_CleanDCache_by_Addr(addr, size)       ((void)(addr), (void)(size))
+#define SCB_InvalidateDCache_by_Addr(addr, size)  ((void)(addr), (void)(size))
+
+/* Functions ------------------------------------------------------------------*/
+
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t delay);
+
+void HAL_GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init);
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32H7XX_HAL_H */
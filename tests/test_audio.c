@@ -0,0 +1,202 @@
+/**
+ ******************************************************************************
+ * @file      test_audio.c
+ * @brief     Feeds WAV audio through the ADC DMA and the audio block API
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details Without arguments a synthesized tone is written to
+ *          build/audio_tone.wav, read back and fed through audio.c, and
+ *          the blocks the subscribers get are checked. With a WAV file as
+ *          the argument, that file is fed instead and the blocks are
+ *          summarized. 16 bit PCM at 8 kHz, other channels than the first
+ *          are ignored.
+ ******************************************************************************
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio.h"
+#include "fake_adc.h"
+#include "host.h"
+#include "scheduler.h"
+#include "wav.h"
+
+#define TONE_HZ         1000
+#define TONE_AMPLITUDE  8000
+#define TONE_BIAS       1200    // SA818 output sits a bit off mid scale
+#define TONE_SECONDS    2
+
+// ---------------------------------------------------------------------------
+// Stand-ins for the modules audio.c calls
+// ---------------------------------------------------------------------------
+static unsigned posted_audio = 0;
+
+void scheduler_post(scheduler_event_t event)
+{
+    if (event == SCHEDULER_EVENT_AUDIO)
+        posted_audio++;
+}
+
+// ---------------------------------------------------------------------------
+// Subscriber
+// ---------------------------------------------------------------------------
+typedef struct {
+    uint32_t blocks;
+    int16_t first[AUDIO_BLOCK_SIZE];    // first block since the last reset
+    int64_t sum;                        // of the last block
+    int16_t last_peak;
+    int64_t sum_sq;                     // of all blocks
+    uint32_t samples;
+    int16_t peak;
+} block_stats_t;
+
+static block_stats_t stats;
+
+static void on_audio(const int16_t *samples, uint16_t count)
+{
+    if (stats.blocks == 0)
+        memcpy(stats.first, samples, count * sizeof(int16_t));
+    stats.blocks++;
+
+    stats.sum = 0;
+    stats.last_peak = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        int16_t s = samples[i];
+        stats.sum += s;
+        stats.sum_sq += (int64_t)s * s;
+        if (abs(s) > stats.last_peak)
+            stats.last_peak = (int16_t)abs(s);
+    }
+    if (stats.last_peak > stats.peak)
+        stats.peak = stats.last_peak;
+    stats.samples += count;
+}
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+static const char *out_dir = "build";
+
+// The main loop, one pass per filled half
+static void main_loop_pass(void)
+{
+    audio_task();
+}
+
+static double stats_rms(void)
+{
+    return stats.samples ? sqrt((double)stats.sum_sq / stats.samples) : 0.0;
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+static void test_wav_tone(void)
+{
+    uint32_t count = TONE_SECONDS * AUDIO_SAMPLE_RATE_HZ;
+    int16_t *tone = malloc(count * sizeof(int16_t));
+    char path[256];
+    wav_t wav;
+
+    for (uint32_t i = 0; i < count; i++)
+        tone[i] = (int16_t)lrint(TONE_BIAS + TONE_AMPLITUDE *
+                                 sin(2.0 * M_PI * TONE_HZ * i / AUDIO_SAMPLE_RATE_HZ));
+
+    snprintf(path, sizeof(path), "%s/audio_tone.wav", out_dir);
+    CHECK(wav_write(path, tone, count, AUDIO_SAMPLE_RATE_HZ));
+    CHECK(wav_read(path, &wav));
+    CHECK(wav.rate == AUDIO_SAMPLE_RATE_HZ && wav.count == count);
+    CHECK(wav.samples != NULL && memcmp(wav.samples, tone, count * sizeof(int16_t)) == 0);
+
+    memset(&stats, 0, sizeof(stats));
+    posted_audio = 0;
+    fake_adc_feed(wav.samples, wav.count, main_loop_pass);
+
+    CHECK(stats.blocks == count / AUDIO_BLOCK_SIZE);
+    CHECK(posted_audio == stats.blocks);
+    CHECK(audio_get_overruns() == 0);
+
+    // The bias is gone after a few time constants of the DC filter, the
+    // tone is left as it was
+    CHECK(llabs(stats.sum) < AUDIO_BLOCK_SIZE * 4);
+    CHECK(abs(stats.last_peak - TONE_AMPLITUDE) < 16);
+    printf("  %u blocks, rms %.0f, last block mean %.2f peak %d\n", stats.blocks,
+           stats_rms(), (double)stats.sum / AUDIO_BLOCK_SIZE, stats.last_peak);
+
+    wav_free(&wav);
+    free(tone);
+}
+
+// A late main loop: both halves wait, then the first is overwritten
+static void test_overrun(void)
+{
+    int16_t block[AUDIO_BLOCK_SIZE] = { 0 };
+    uint32_t overruns = audio_get_overruns();
+
+    memset(&stats, 0, sizeof(stats));
+    block[5] = 5000;
+    fake_adc_feed(block, AUDIO_BLOCK_SIZE, NULL);
+    block[5] = 0;
+    fake_adc_feed(block, AUDIO_BLOCK_SIZE, NULL);
+    CHECK(audio_get_overruns() == overruns);
+    CHECK(stats.blocks == 0);
+
+    // Oldest half first
+    audio_task();
+    CHECK(stats.blocks == 2);
+    CHECK(stats.first[5] - stats.first[4] > 4900);
+
+    fake_adc_feed(block, AUDIO_BLOCK_SIZE, NULL);
+    fake_adc_feed(block, AUDIO_BLOCK_SIZE, NULL);
+    fake_adc_feed(block, AUDIO_BLOCK_SIZE, NULL);
+    CHECK(audio_get_overruns() == overruns + 1);
+    audio_task();
+    CHECK(stats.blocks == 4);
+}
+
+// ---------------------------------------------------------------------------
+// A recording
+// ---------------------------------------------------------------------------
+static int feed_file(const char *path)
+{
+    wav_t wav;
+
+    if (!wav_read(path, &wav)) {
+        fprintf(stderr, "%s: not a 16 bit PCM WAV file\n", path);
+        return 1;
+    }
+    if (wav.rate != AUDIO_SAMPLE_RATE_HZ)
+        printf("  %s is %u Hz, fed as %u Hz\n", path, wav.rate, AUDIO_SAMPLE_RATE_HZ);
+
+    memset(&stats, 0, sizeof(stats));
+    fake_adc_feed(wav.samples, wav.count, main_loop_pass);
+
+    double rms = stats_rms();
+    printf("  %s: %u samples, %u blocks (%.2f s), overruns %u\n", path, wav.count,
+           stats.blocks, stats.blocks * (double)AUDIO_BLOCK_SIZE / AUDIO_SAMPLE_RATE_HZ,
+           audio_get_overruns());
+    printf("  rms %.0f (%.1f dBFS), peak %d\n", rms,
+           rms > 0 ? 20.0 * log10(rms / 32768.0) : -INFINITY, stats.peak);
+
+    wav_free(&wav);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    audio_init();
+    CHECK(fake_adc_rate == AUDIO_SAMPLE_RATE_HZ && fake_adc_running);
+    CHECK(audio_subscribe(on_audio));
+
+    if (argc > 1)
+        return feed_file(argv[1]);
+
+    test_wav_tone();
+    test_overrun();
+
+    return host_report("test_audio");
+}
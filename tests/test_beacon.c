@@ -0,0 +1,364 @@
+/**
+ ******************************************************************************
+ * @file      test_beacon.c
+ * @brief     Beacon schedule, PTT sequencing and MCW keying on a simulated clock
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details The TIM17 tick is beacon_tick() called once per simulated ms while
+ *          the fake timer runs. The main loop, beacon_task() on
+ *          SCHEDULER_EVENT_BEACON, runs separately and can be made late to
+ *          show that it does not move the keying. PTT and the keyed tone
+ *          are logged with the ms they changed.
+ ******************************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "audio.h"
+#include "beacon.h"
+#include "beacon_timer.h"
+#include "host.h"
+#include "morse.h"
+#include "sa818.h"
+#include "scheduler.h"
+#include "test_tone.h"
+
+#define LOG_MAX  256
+
+// ---------------------------------------------------------------------------
+// Stand-ins for the timer, the tone generator and the modules beacon.c calls
+// ---------------------------------------------------------------------------
+typedef enum { EV_PTT, EV_KEY } event_kind_t;
+
+typedef struct {
+    event_kind_t kind;
+    bool on;
+    uint32_t ms;
+} event_t;
+
+static uint32_t now_ms = 0;
+static event_t events[LOG_MAX];
+static uint32_t event_count = 0;
+
+static bool timer_running = false;
+static bool tone_enabled = false;
+static bool tone_keyed = true;      // the generator starts keyed down
+static uint32_t tone_hz = 0;
+static bool ptt = false;
+static bool beacon_posted = false;
+
+static void log_event(event_kind_t kind, bool on)
+{
+    if (event_count < LOG_MAX)
+        events[event_count++] = (event_t){ kind, on, now_ms };
+}
+
+void beacon_timer_init(uint32_t tick_hz)
+{
+    CHECK(tick_hz == 1000);
+}
+
+void beacon_timer_start(void)
+{
+    timer_running = true;
+}
+
+void beacon_timer_stop(void)
+{
+    timer_running = false;
+}
+
+// Logs what goes on the air: the tone keyed while the generator runs
+static void tone_changed(bool was_audible)
+{
+    bool audible = tone_enabled && tone_keyed;
+    if (audible != was_audible)
+        log_event(EV_KEY, audible);
+}
+
+void testtone_key(bool on)
+{
+    bool was_audible = tone_enabled && tone_keyed;
+    tone_keyed = on;
+    tone_changed(was_audible);
+}
+
+void testtone_enable(bool enable)
+{
+    bool was_audible = tone_enabled && tone_keyed;
+    tone_enabled = enable;
+    tone_changed(was_audible);
+}
+
+void testtone_set_frequency(uint32_t frequency_hz)
+{
+    tone_hz = frequency_hz;
+}
+
+void sa818_set_mode(sa818_mode_t mode)
+{
+    bool on = (mode == SA818_MODE_TX);
+    if (on != ptt)
+        log_event(EV_PTT, on);
+    ptt = on;
+}
+
+void scheduler_post(scheduler_event_t event)
+{
+    if (event == SCHEDULER_EVENT_BEACON)
+        beacon_posted = true;
+}
+
+void menu_update_display_async(void)
+{
+}
+
+bool audio_subscribe(audio_block_cb_t callback)
+{
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+
+// Main loop every loop_ms, the timer tick every ms
+static void run_ms(uint32_t ms, uint32_t loop_ms)
+{
+    while (ms--) {
+        now_ms++;
+        if (timer_running)
+            beacon_tick();
+        if (beacon_posted && now_ms % loop_ms == 0) {
+            beacon_posted = false;
+            beacon_task();
+        }
+    }
+}
+
+static void reset_log(void)
+{
+    event_count = 0;
+}
+
+static bool audible(void)
+{
+    return tone_enabled && tone_keyed;
+}
+
+// Checks the keying of text from start_ms on, element by element, returns
+// the ms the last element ended or 0 on a mismatch
+static uint32_t expect_mcw(uint32_t *index, const char *text, uint32_t start_ms, uint32_t wpm)
+{
+    uint32_t dit = 1200 / wpm;
+    uint32_t t = start_ms;
+    uint32_t i = *index;
+
+    for (const char *c = text; *c; c++) {
+        if (*c == ' ') {
+            t += 4 * dit;       // 3 after the last character already
+            continue;
+        }
+
+        uint8_t code = morse_encode(*c);
+        int8_t bit = 7;
+        while (!(code & (1u << bit)))
+            bit--;
+        while (--bit >= 0) {
+            uint32_t len = (code & (1u << bit)) ? 3 * dit : dit;
+            if (!CHECK(i + 1 < event_count && events[i].kind == EV_KEY && events[i].on &&
+                       events[i].ms == t && events[i + 1].ms == t + len && !events[i + 1].on)) {
+                printf("  '%c' element at %u ms, got %u..%u\n", *c, t, events[i].ms, events[i + 1].ms);
+                return 0;
+            }
+            i += 2;
+            t += len + dit;
+        }
+        t += 2 * dit;
+    }
+
+    *index = i;
+    return t - 3 * dit;     // back to the end of the last element
+}
+
+static void set_schedule(const char *callsign, uint16_t interval_s, uint16_t tone_s, uint8_t id_every)
+{
+    beacon_config_t c = *beacon_get_config();
+
+    strncpy(c.callsign, callsign, sizeof(c.callsign));
+    c.interval_s = interval_s;
+    c.tone_s = tone_s;
+    c.id_every = id_every;
+    beacon_set_config(&c);
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+
+// One transmission of the default schedule: lead, 10 s tone, gap, the
+// callsign, tail, every ms where it belongs
+static void test_transmission(void)
+{
+    const beacon_config_t *c = beacon_get_config();
+    uint32_t i = 0;
+
+    // As built
+    CHECK(strcmp(c->callsign, BEACON_CALLSIGN) == 0);
+    CHECK(c->interval_s == BEACON_INTERVAL_S && c->tone_s == BEACON_TONE_S &&
+          c->id_every == BEACON_ID_EVERY);
+
+    reset_log();
+    beacon_start();
+    uint32_t start = now_ms + 1;        // the first tick starts it
+    run_ms(20000, 1);
+
+    CHECK(event_count >= 2 && events[0].kind == EV_PTT && events[0].on && events[0].ms == start);
+    CHECK(events[1].kind == EV_KEY && events[1].on && events[1].ms == start + c->lead_ms);
+    CHECK(events[2].kind == EV_KEY && !events[2].on &&
+          events[2].ms == start + c->lead_ms + c->tone_s * 1000u);
+    CHECK(tone_hz == c->tone_hz);
+
+    i = 3;
+    uint32_t dit = 1200 / c->wpm;
+    uint32_t id_end = expect_mcw(&i, c->callsign, events[2].ms + 3 * dit, c->wpm);
+    CHECK(id_end != 0);
+    CHECK(i < event_count && events[i].kind == EV_PTT && !events[i].on &&
+          events[i].ms == id_end + c->tail_ms);
+    CHECK(!audible() && !ptt);
+    CHECK(beacon_get_state() == BEACON_STATE_WAIT && beacon_get_cycles() == 1);
+
+    printf("  PTT %u ms, tone at +%u ms for %u s, \"%s\" until +%u ms, released at +%u ms\n",
+           start, c->lead_ms, c->tone_s, c->callsign, id_end - start, events[i].ms - start);
+}
+
+// Start to start is the interval, however long a transmission is
+static void test_interval(void)
+{
+    uint32_t first = events[0].ms;
+
+    CHECK(beacon_get_seconds_to_next() == 60 - (now_ms - first) / 1000);
+    reset_log();
+    run_ms(first + 60000 - now_ms, 1);
+    CHECK(event_count == 1 && events[0].kind == EV_PTT && events[0].on &&
+          events[0].ms == first + 60000);
+    CHECK(beacon_get_seconds_to_next() == 0);
+    run_ms(59999, 1);
+    CHECK(beacon_get_cycles() == 2 && ptt == false);
+    run_ms(1, 1);
+    CHECK(ptt == true);
+    beacon_stop();
+}
+
+// A main loop that only comes round every 97 ms starts and stops the DAC
+// late, the keying itself stays on the tick
+static void test_main_loop_load(void)
+{
+    uint32_t i = 0;
+
+    set_schedule("PA3XYZ", 60, 0, 1);
+    reset_log();
+    beacon_start();
+    uint32_t start = now_ms + 1;
+    run_ms(10000, 97);
+
+    const beacon_config_t *c = beacon_get_config();
+    CHECK(events[0].kind == EV_PTT && events[0].on && events[0].ms == start);
+    i = 1;
+    uint32_t id_end = expect_mcw(&i, "PA3XYZ", start + c->lead_ms, c->wpm);
+    CHECK(id_end != 0);
+    CHECK(i < event_count && events[i].kind == EV_PTT && events[i].ms == id_end + c->tail_ms);
+    CHECK(!tone_enabled);
+    beacon_stop();
+}
+
+// ID on the first transmission and every third after it
+static void test_id_every(void)
+{
+    uint32_t ids = 0;
+    uint32_t transmissions = 0;
+
+    set_schedule("FOX", 20, 2, 3);
+    beacon_start();
+    for (int n = 0; n < 7; n++) {
+        reset_log();
+        run_ms(20000, 1);
+        transmissions++;
+        // Tone on and off, then anything more is the ID
+        if (event_count > 4)
+            ids++;
+    }
+    CHECK(transmissions == 7 && beacon_get_cycles() == 7);
+    CHECK(ids == 3);    // 0, 3 and 6
+    beacon_stop();
+}
+
+// A new schedule waits for the next transmission
+static void test_config_change(void)
+{
+    set_schedule("FOX", 30, 1, 0);
+    reset_log();
+    beacon_start();
+    run_ms(500, 1);
+    set_schedule("FOX", 30, 5, 0);
+    run_ms(29500, 1);
+
+    const beacon_config_t *c = beacon_get_config();
+    CHECK(events[2].ms - events[1].ms == 1000);     // still the old 1 s
+    reset_log();
+    run_ms(30000, 1);
+    CHECK(event_count >= 3 && events[2].ms - events[1].ms == 5000);
+    CHECK(c->tone_s == 5);
+    beacon_stop();
+}
+
+// Stop in the middle of the tone: PTT and audio off at once
+static void test_stop(void)
+{
+    set_schedule("FOX", 60, 10, 1);
+    beacon_start();
+    run_ms(5000, 1);
+    CHECK(ptt && audible());
+    beacon_stop();
+    CHECK(!ptt && !tone_enabled);
+    CHECK(beacon_get_state() == BEACON_STATE_OFF && !timer_running && !beacon_is_running());
+    run_ms(100000, 1);
+    CHECK(!ptt);
+}
+
+// A one-off text with the beacon off, then the timer stops again
+static void test_send_text(void)
+{
+    uint32_t i = 1;
+
+    reset_log();
+    CHECK(beacon_send_text("TEST"));
+    CHECK(!beacon_send_text("AGAIN"));      // already on the air
+    uint32_t start = now_ms;
+    run_ms(10000, 1);
+
+    const beacon_config_t *c = beacon_get_config();
+    CHECK(events[0].kind == EV_PTT && events[0].on && events[0].ms == start);
+    uint32_t end = expect_mcw(&i, "TEST", start + c->lead_ms, c->wpm);
+    CHECK(end != 0);
+    CHECK(i < event_count && events[i].kind == EV_PTT && !events[i].on && events[i].ms == end + c->tail_ms);
+    CHECK(beacon_get_state() == BEACON_STATE_OFF && !timer_running);
+    CHECK(!beacon_send_text("  "));
+}
+
+int main(void)
+{
+    beacon_init();
+
+    test_transmission();
+    test_interval();
+    test_main_loop_load();
+    test_id_every();
+    test_config_change();
+    test_stop();
+    test_send_text();
+
+    return host_report("test_beacon");
+}
@@ -0,0 +1,147 @@
+/**
+ ******************************************************************************
+ * @file      test_ctcss.c
+ * @brief     The CTCSS detector on every tone of the bank, with and without noise
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details The sub-tone is fed at the level it has with the SA818 highpass
+ *          bypassed, well below the voice, through fake_adc.c and audio.c.
+ ******************************************************************************
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "audio.h"
+#include "ctcss.h"
+#include "fake_adc.h"
+#include "host.h"
+#include "scheduler.h"
+
+#define TONE_AMPLITUDE  1500
+#define SETTLE_MS       1500    // three windows: one partial, two to confirm
+
+// ---------------------------------------------------------------------------
+// Stand-ins for the modules audio.c calls
+// ---------------------------------------------------------------------------
+void scheduler_post(scheduler_event_t event)
+{
+}
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+static uint32_t noise_seed = 1;
+
+// Uniform in [-amplitude, amplitude], repeatable
+static int32_t noise(int32_t amplitude)
+{
+    noise_seed = noise_seed * 1664525u + 1013904223u;
+    return (int32_t)(((int64_t)(int32_t)noise_seed * amplitude) >> 31);
+}
+
+// Sub-tone of dhz tenths of Hz with a 1 kHz "voice" tone and noise on top
+static void feed(uint16_t dhz, int32_t voice, int32_t noise_amplitude, uint32_t ms)
+{
+    static uint32_t phase = 0;
+    int16_t block[AUDIO_BLOCK_SIZE];
+    uint32_t blocks = ms * (AUDIO_SAMPLE_RATE_HZ / 1000) / AUDIO_BLOCK_SIZE;
+
+    while (blocks--) {
+        for (uint32_t i = 0; i < AUDIO_BLOCK_SIZE; i++, phase++) {
+            double t = (double)phase / AUDIO_SAMPLE_RATE_HZ;
+            double s = TONE_AMPLITUDE * sin(2.0 * M_PI * dhz / 10.0 * t) * (dhz != 0) +
+                       voice * sin(2.0 * M_PI * 1000.0 * t);
+            block[i] = (int16_t)(lrint(s) + noise(noise_amplitude));
+        }
+        fake_adc_feed(block, AUDIO_BLOCK_SIZE, audio_task);
+    }
+}
+
+// Every tone of the bank, returns how many were detected correctly
+static int8_t sweep(int32_t voice, int32_t noise_amplitude, uint8_t *min_confidence)
+{
+    int8_t hits = 0;
+
+    *min_confidence = 100;
+    for (int8_t tone = 0; tone < CTCSS_TONE_COUNT; tone++) {
+        feed(ctcss_get_tone_dhz(tone), voice, noise_amplitude, SETTLE_MS);
+        if (ctcss_get_tone() == tone)
+            hits++;
+        if (ctcss_get_confidence() < *min_confidence)
+            *min_confidence = ctcss_get_confidence();
+    }
+    return hits;
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+static void test_table(void)
+{
+    CHECK(ctcss_get_tone_dhz(0) == 670 && ctcss_get_tone_dhz(CTCSS_TONE_COUNT - 1) == 2541);
+    CHECK(ctcss_get_tone_dhz(-1) == 0 && ctcss_get_tone_dhz(CTCSS_TONE_COUNT) == 0);
+    CHECK(ctcss_get_sa818_code(0) == 1 && ctcss_get_sa818_code(-1) == 0);
+
+    // Rising, and the SA818 codes 1..38 in order over the tones it has
+    uint8_t code = 0;
+    for (int8_t tone = 1; tone < CTCSS_TONE_COUNT; tone++) {
+        CHECK(ctcss_get_tone_dhz(tone) > ctcss_get_tone_dhz(tone - 1));
+        if (ctcss_get_sa818_code(tone) != 0) {
+            CHECK(ctcss_get_sa818_code(tone) > code);
+            code = ctcss_get_sa818_code(tone);
+        }
+    }
+    CHECK(code == 38);
+}
+
+static void test_clean(void)
+{
+    uint8_t confidence;
+
+    CHECK(sweep(0, 0, &confidence) == CTCSS_TONE_COUNT);
+    CHECK(confidence > 90);
+    printf("  clean: %u of %u tones, confidence at least %u %%\n",
+           CTCSS_TONE_COUNT, CTCSS_TONE_COUNT, confidence);
+}
+
+// Voice 6 dB above the sub-tone and wideband noise at the tone level: the
+// 1 kHz averaging and the 2 Hz bins keep most of it out
+static void test_voice_and_noise(void)
+{
+    uint8_t confidence;
+    int8_t hits = sweep(3000, TONE_AMPLITUDE, &confidence);
+
+    CHECK(hits == CTCSS_TONE_COUNT);
+    printf("  voice and noise: %d of %u tones, confidence at least %u %%\n",
+           hits, CTCSS_TONE_COUNT, confidence);
+}
+
+static void test_no_tone(void)
+{
+    feed(0, 3000, TONE_AMPLITUDE, SETTLE_MS);
+    CHECK(ctcss_get_tone() == -1);
+    CHECK(ctcss_get_confidence() < CTCSS_MIN_CONFIDENCE);
+
+    // A tone needs two windows in a row
+    feed(1000, 0, 0, 600);
+    CHECK(ctcss_get_tone() == -1);
+    feed(1000, 0, 0, 500);
+    CHECK(ctcss_get_tone() == 12);
+}
+
+int main(void)
+{
+    audio_init();
+    ctcss_init();
+    CHECK(ctcss_get_tone() == -1);
+
+    test_table();
+    test_clean();
+    test_voice_and_noise();
+    test_no_tone();
+
+    return host_report("test_ctcss");
+}
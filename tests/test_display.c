@@ -0,0 +1,127 @@
+/**
+ ******************************************************************************
+ * @file      test_display.c
+ * @brief     Draws through lcd.c, flushes to the fake panel and dumps PNGs
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details Writes framebuffer.png (what was drawn) and panel.png (what the
+ *          panel got over SPI) into the directory given as the argument,
+ *          build/ by default, four times enlarged.
+ ******************************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "fake_display.h"
+#include "framebuffer.h"
+#include "host.h"
+#include "lcd.h"
+#include "png.h"
+#include "st7735.h"
+
+#define DUMP_SCALE  4
+
+extern uint16_t POINT_COLOR;
+extern uint16_t BACK_COLOR;
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+static const char *dump_dir = "build";
+
+static void dump(const char *name, const uint16_t *pixels, uint32_t stride, bool swapped)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", dump_dir, name);
+    if (CHECK(png_write_rgb565(path, pixels, FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT,
+                               stride, swapped, DUMP_SCALE)))
+        printf("  wrote %s\n", path);
+}
+
+// Pixels that differ between the framebuffer and the panel
+static uint32_t panel_mismatches(void)
+{
+    uint32_t count = 0;
+    for (uint32_t y = 0; y < FRAMEBUFFER_HEIGHT; y++) {
+        const uint16_t *row = framebuffer_get_pixels(0, (uint16_t)y);
+        for (uint32_t x = 0; x < FRAMEBUFFER_WIDTH; x++) {
+            uint16_t c = (uint16_t)((row[x] << 8) | (row[x] >> 8));
+            if (fake_display_pixel(x, y) != c)
+                count++;
+        }
+    }
+    return count;
+}
+
+static void show(uint16_t x, uint16_t y, uint8_t size, const char *text)
+{
+    lcd_show_string(x, y, (uint16_t)lcd_get_width(), size, size, (uint8_t *)text);
+}
+
+// Something like the home screen, every drawing primitive once
+static void draw_sample_screen(void)
+{
+    lcd_clear();
+    POINT_COLOR = WHITE;
+    BACK_COLOR = BLACK;
+    show(0, 0, 16, "RX 144.4500 MHz");
+    POINT_COLOR = YELLOW;
+    show(0, 20, 12, "Sig: -87.3 dBm");
+    show(0, 32, 12, "Atten: Auto 12.5 dB");
+    POINT_COLOR = WHITE;
+    lcd_draw_rect(0, 50, 160, 14, GREEN);
+    lcd_draw_filled_rect(2, 52, 97, 10, RED);
+    lcd_show_char(150, 66, 'A', 12, 0);
+    lcd_show_char(140, 66, 'B', 12, 1);
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+static void test_flush(void)
+{
+    draw_sample_screen();
+    lcd_flush();
+
+    CHECK(panel_mismatches() == 0);
+    dump("framebuffer.png", framebuffer_get_pixels(0, 0), FRAMEBUFFER_WIDTH, true);
+    dump("panel.png", fake_display_panel(), FAKE_DISPLAY_WIDTH, false);
+}
+
+// The DMA path sends whole rows, only the changed ones
+static void test_flush_async(void)
+{
+    fake_display_reset_stats();
+    POINT_COLOR = CYAN;
+    show(0, 20, 12, "Sig: -61.0 dBm");
+    lcd_flush_async();
+
+    CHECK(panel_mismatches() == 0);
+    CHECK(fake_display.pixels == 12 * FRAMEBUFFER_WIDTH);
+    printf("  one text line: %u bytes, %u transfers, %u us on the bus\n",
+           fake_display.bytes, fake_display.transfers, fake_display_bus_us());
+
+    // Nothing changed, nothing sent
+    fake_display_reset_stats();
+    lcd_flush_async();
+    CHECK(fake_display.bytes == 0);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+        dump_dir = argv[1];
+
+    fake_display_reset();
+    host_tick_free_running = true;      // the driver init spins on the tick
+    lcd_init();
+    host_tick_free_running = false;
+    framebuffer_init();
+
+    test_flush();
+    test_flush_async();
+
+    return host_report("test_display");
+}
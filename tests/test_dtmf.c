@@ -0,0 +1,399 @@
+/**
+ ******************************************************************************
+ * @file      test_dtmf.c
+ * @brief     The DTMF decoder and the remote control on synthesized keys
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details Keys are the sum of their row and column tone, with a given twist
+ *          and noise, fed through fake_adc.c and audio.c. The beacon and
+ *          SA818 calls of the command interpreter are recorded instead of
+ *          carried out.
+ ******************************************************************************
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "audio.h"
+#include "beacon.h"
+#include "dtmf.h"
+#include "fake_adc.h"
+#include "host.h"
+#include "sa818.h"
+#include "scheduler.h"
+
+#define TONE_AMPLITUDE  6000    // per tone
+#define KEY_MS          100
+#define PAUSE_MS        100
+#define ALL_KEYS        "123A456B789C*0#D"
+
+// ---------------------------------------------------------------------------
+// Stand-ins for the modules dtmf.c and audio.c call
+// ---------------------------------------------------------------------------
+static sa818_settings_t settings;
+static bool beacon_running = false;
+static uint32_t beacon_cycles = 0;
+static char sent[64];               // last beacon_send_text()
+static char calls[64];              // what the interpreter did, "start", "vol 5"
+
+static void record(const char *call)
+{
+    strncpy(calls, call, sizeof(calls) - 1);
+}
+
+const sa818_settings_t* sa818_get_settings(void)
+{
+    return &settings;
+}
+
+void sa818_set_power_level(sa818_power_t power)
+{
+    settings.power = power;
+    record(power == SA818_POWER_HIGH ? "power high" : "power low");
+}
+
+void sa818_set_volume_level(uint8_t vol)
+{
+    settings.volume = vol;
+    snprintf(calls, sizeof(calls), "vol %u", vol);
+}
+
+void sa818_set_squelch(uint8_t sq)
+{
+    settings.squelch = sq;
+    snprintf(calls, sizeof(calls), "sq %u", sq);
+}
+
+bool beacon_is_running(void)
+{
+    return beacon_running;
+}
+
+uint32_t beacon_get_cycles(void)
+{
+    return beacon_cycles;
+}
+
+void beacon_start(void)
+{
+    beacon_running = true;
+    record("start");
+}
+
+void beacon_stop(void)
+{
+    beacon_running = false;
+    record("stop");
+}
+
+bool beacon_send_text(const char *text)
+{
+    strncpy(sent, text, sizeof(sent) - 1);
+    return true;
+}
+
+void scheduler_post(scheduler_event_t event)
+{
+}
+
+// ---------------------------------------------------------------------------
+// Key generator
+// ---------------------------------------------------------------------------
+static const double row_hz[4] = { 697.0, 770.0, 852.0, 941.0 };
+static const double col_hz[4] = { 1209.0, 1336.0, 1477.0, 1633.0 };
+
+static int16_t block[AUDIO_BLOCK_SIZE];
+static uint32_t block_fill = 0;
+static uint32_t phase = 0;
+static uint32_t noise_seed = 1;
+
+// Uniform in [-amplitude, amplitude], repeatable
+static int32_t noise(int32_t amplitude)
+{
+    noise_seed = noise_seed * 1664525u + 1013904223u;
+    return (int32_t)(((int64_t)(int32_t)noise_seed * amplitude) >> 31);
+}
+
+static void put_sample(double s)
+{
+    if (s > INT16_MAX) s = INT16_MAX;
+    if (s < INT16_MIN) s = INT16_MIN;
+    block[block_fill++] = (int16_t)lrint(s);
+
+    if (block_fill == AUDIO_BLOCK_SIZE) {
+        fake_adc_feed(block, AUDIO_BLOCK_SIZE, audio_task);
+        block_fill = 0;
+    }
+}
+
+// Two tones for ms, row and column amplitude apart, 0 Hz leaves one out
+static void tones(double f1, int32_t a1, double f2, int32_t a2, int32_t noise_amplitude, uint32_t ms)
+{
+    uint32_t samples = ms * (AUDIO_SAMPLE_RATE_HZ / 1000);
+
+    for (uint32_t i = 0; i < samples; i++, phase++) {
+        double t = (double)phase / AUDIO_SAMPLE_RATE_HZ;
+        put_sample(a1 * sin(2.0 * M_PI * f1 * t) + a2 * sin(2.0 * M_PI * f2 * t) +
+                   noise(noise_amplitude));
+    }
+}
+
+static void silence(uint32_t ms)
+{
+    tones(0.0, 0, 0.0, 0, 0, ms);
+}
+
+// One key with the column twist_db above the row, then a pause
+static void key(char k, double twist_db, int32_t noise_amplitude, uint32_t on_ms, uint32_t off_ms)
+{
+    const char *at = strchr(ALL_KEYS, k);
+    if (!at)
+        return;
+
+    // ALL_KEYS is row by row
+    uint32_t index = (uint32_t)(at - ALL_KEYS);
+    int32_t col_amplitude = (int32_t)lrint(TONE_AMPLITUDE * pow(10.0, twist_db / 40.0));
+    int32_t row_amplitude = (int32_t)lrint(TONE_AMPLITUDE * pow(10.0, -twist_db / 40.0));
+
+    tones(row_hz[index / 4], row_amplitude, col_hz[index % 4], col_amplitude, noise_amplitude, on_ms);
+    tones(0.0, 0, 0.0, 0, noise_amplitude, off_ms);
+}
+
+// Keys a string, returns what was decoded from it
+static const char *dial(const char *keys, double twist_db, int32_t noise_amplitude,
+                        uint32_t on_ms, uint32_t off_ms)
+{
+    static char decoded[64];
+    uint32_t n = 0;
+
+    for (const char *k = keys; *k; k++) {
+        uint32_t count = dtmf_get_digit_count();
+        key(*k, twist_db, noise_amplitude, on_ms, off_ms);
+        // A key may still be confirmed a window into the pause, never later
+        for (uint32_t c = count; c < dtmf_get_digit_count() && n < sizeof(decoded) - 1; c++)
+            decoded[n++] = (c + 1 == dtmf_get_digit_count()) ? dtmf_get_last_digit() : '?';
+    }
+    decoded[n] = '\0';
+    return decoded;
+}
+
+static void command(const char *keys)
+{
+    sent[0] = '\0';
+    calls[0] = '\0';
+    dial(keys, 0.0, 0, KEY_MS, PAUSE_MS);
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+static void test_all_keys(void)
+{
+    uint32_t count = dtmf_get_digit_count();
+
+    CHECK(strcmp(dial(ALL_KEYS, 0.0, 0, KEY_MS, PAUSE_MS), ALL_KEYS) == 0);
+    CHECK(dtmf_get_digit_count() - count == 16);
+    CHECK(dtmf_get_last_digit() == 'D');
+
+    // A key held for seconds counts once, the same key again after a pause
+    // counts again
+    count = dtmf_get_digit_count();
+    key('5', 0.0, 0, 2000, PAUSE_MS);
+    key('5', 0.0, 0, KEY_MS, PAUSE_MS);
+    CHECK(dtmf_get_digit_count() - count == 2);
+}
+
+// Each window is 25.6 ms and a key needs two whole ones in a row, so it
+// takes three windows to be sure whatever the alignment. The standard
+// asks for 40 ms, which works when the tone happens to line up.
+static void test_key_length(void)
+{
+    static const uint32_t lengths[] = { 40, 50, 60, 70, 80 };
+
+    printf("  keys decoded out of 16 by tone length, 60 ms pauses:");
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        const char *decoded = dial(ALL_KEYS, 0.0, 0, lengths[i], 60);
+        size_t hits = 0;
+
+        for (size_t k = 0; k < strlen(ALL_KEYS) && k < strlen(decoded); k++)
+            hits += (decoded[k] == ALL_KEYS[k]);
+        if (lengths[i] >= 80)
+            CHECK(strcmp(decoded, ALL_KEYS) == 0);
+        // Never a wrong key, only a missed one
+        CHECK(strspn(decoded, ALL_KEYS) == strlen(decoded));
+        printf(" %u ms %zu", lengths[i], hits);
+    }
+    printf("\n");
+    silence(500);
+}
+
+// Up to ~8 dB with the column louder, ~5 dB with the row louder
+static void test_twist(void)
+{
+    CHECK(strcmp(dial(ALL_KEYS, 6.0, 0, KEY_MS, PAUSE_MS), ALL_KEYS) == 0);
+    CHECK(strcmp(dial(ALL_KEYS, -4.0, 0, KEY_MS, PAUSE_MS), ALL_KEYS) == 0);
+    CHECK(dial(ALL_KEYS, 10.0, 0, KEY_MS, PAUSE_MS)[0] == '\0');
+    CHECK(dial(ALL_KEYS, -7.0, 0, KEY_MS, PAUSE_MS)[0] == '\0');
+}
+
+static void test_noise(void)
+{
+    // Noise 10 dB under the key
+    CHECK(strcmp(dial(ALL_KEYS, 0.0, 3300, KEY_MS, PAUSE_MS), ALL_KEYS) == 0);
+
+    uint32_t count = dtmf_get_digit_count();
+
+    // Noise alone, loud
+    tones(0.0, 0, 0.0, 0, 20000, 5000);
+    // One tone of a pair, a dial tone, a 1 kHz whistle
+    tones(697.0, TONE_AMPLITUDE, 0.0, 0, 0, 500);
+    tones(1336.0, TONE_AMPLITUDE, 0.0, 0, 0, 500);
+    tones(350.0, TONE_AMPLITUDE, 440.0, TONE_AMPLITUDE, 0, 500);
+    tones(1000.0, TONE_AMPLITUDE * 2, 0.0, 0, 0, 500);
+    // A key drowned in noise at the same level
+    key('5', 0.0, 2 * TONE_AMPLITUDE, 500, PAUSE_MS);
+    // A key too quiet to count
+    tones(852.0, 100, 1477.0, 100, 0, 500);
+
+    CHECK(dtmf_get_digit_count() == count);
+    silence(500);
+}
+
+// No PIN, no remote control: the keys decode, the commands do nothing
+static void test_no_pin(void)
+{
+    uint32_t count = dtmf_get_digit_count();
+
+    command("*123411#");
+    command("*11#");
+    command("*000011#");
+    CHECK(calls[0] == '\0' && sent[0] == '\0');
+    CHECK(dtmf_get_digit_count() == count + 8 + 4 + 8);
+
+    // Only DTMF_PIN_LEN digits turn it on
+    CHECK(!dtmf_set_pin(NULL));
+    CHECK(!dtmf_set_pin(""));
+    CHECK(!dtmf_set_pin("123"));
+    CHECK(!dtmf_set_pin("12345"));
+    CHECK(!dtmf_set_pin("12A4"));
+    command("*123411#");
+    CHECK(calls[0] == '\0');
+
+    CHECK(dtmf_set_pin("1234"));
+    CHECK(!dtmf_set_pin("12*4"));   // and anything else turns it off again
+    command("*123411#");
+    CHECK(calls[0] == '\0');
+}
+
+static void test_commands(void)
+{
+    command("*12341#");             // no such command
+    CHECK(calls[0] == '\0' && sent[0] == '\0');
+
+    command("*123411#");
+    CHECK(strcmp(calls, "start") == 0 && strcmp(sent, "R") == 0);
+    command("*123410#");
+    CHECK(strcmp(calls, "stop") == 0 && strcmp(sent, "R") == 0);
+    command("*123421#");
+    CHECK(strcmp(calls, "power high") == 0 && settings.power == SA818_POWER_HIGH);
+    command("*123420#");
+    CHECK(strcmp(calls, "power low") == 0 && settings.power == SA818_POWER_LOW);
+    command("*123435#");
+    CHECK(strcmp(calls, "vol 5") == 0 && strcmp(sent, "R") == 0);
+    command("*123442#");
+    CHECK(strcmp(calls, "sq 2") == 0);
+
+    // Out of range
+    command("*123430#");
+    CHECK(calls[0] == '\0' && sent[0] == '\0');
+    command("*123439#");
+    CHECK(calls[0] == '\0');
+    command("*123412#");
+    CHECK(calls[0] == '\0');
+
+    // Status
+    beacon_running = true;
+    beacon_cycles = 12;
+    settings.power = SA818_POWER_HIGH;
+    command("*12340#");
+    CHECK(strcmp(sent, "B1 P1 12") == 0);
+    beacon_running = false;
+    beacon_cycles = 0;
+    settings.power = SA818_POWER_LOW;
+    command("*12340#");
+    CHECK(strcmp(sent, "B0 P0 0") == 0);
+    printf("  status reply \"%s\"\n", sent);
+
+    // Without '*', with a letter in it, '*' again starts over
+    command("123411#");
+    CHECK(calls[0] == '\0');
+    command("*1234A11#");
+    CHECK(calls[0] == '\0');
+    command("*99*123411#");
+    CHECK(strcmp(calls, "start") == 0);
+
+    dtmf_set_pin("7070");
+    command("*123410#");
+    CHECK(calls[0] == '\0');
+    command("*707010#");
+    CHECK(strcmp(calls, "stop") == 0);
+    dtmf_set_pin("1234");
+}
+
+// Five seconds without a key drops what was entered
+static void test_timeout(void)
+{
+    command("*1234");
+    silence(4000);
+    command("11#");
+    CHECK(strcmp(calls, "start") == 0);
+
+    command("*1234");
+    silence(5500);
+    command("10#");
+    CHECK(calls[0] == '\0');
+}
+
+// Three wrong PINs and the right one is ignored for a minute
+static void test_lockout(void)
+{
+    command("*111110#");
+    command("*222210#");
+    command("*123410#");
+    CHECK(strcmp(calls, "stop") == 0);     // two wrong ones are forgiven
+
+    command("*111110#");
+    command("*222210#");
+    command("*333310#");
+    command("*123411#");
+    CHECK(calls[0] == '\0');
+
+    silence(55000);
+    command("*123411#");
+    CHECK(calls[0] == '\0');
+
+    silence(5000);
+    command("*123411#");
+    CHECK(strcmp(calls, "start") == 0);
+}
+
+int main(void)
+{
+    audio_init();
+    dtmf_init();
+    CHECK(dtmf_get_last_digit() == '\0' && dtmf_get_digit_count() == 0);
+
+    test_all_keys();
+    test_key_length();
+    test_twist();
+    test_noise();
+    test_no_pin();
+    CHECK(dtmf_set_pin("1234"));
+    test_commands();
+    test_timeout();
+    test_lockout();
+
+    return host_report("test_dtmf");
+}
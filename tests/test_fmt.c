@@ -0,0 +1,135 @@
+/**
+ ******************************************************************************
+ * @file      test_fmt.c
+ * @brief     Compares the fmt formatters with snprintf over their ranges
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmt.h"
+#include "host.h"
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+
+// snprintf counterpart of fmt_fixed()
+static void ref_fixed(char *buf, size_t size, int32_t value, uint8_t decimals)
+{
+    uint32_t mag = (value < 0) ? (uint32_t)0 - (uint32_t)value : (uint32_t)value;
+    uint32_t scale = 1;
+    for (uint8_t i = 0; i < decimals; i++)
+        scale *= 10;
+
+    if (decimals)
+        snprintf(buf, size, "%s%" PRIu32 ".%0*" PRIu32, value < 0 ? "-" : "",
+                 mag / scale, decimals, mag % scale);
+    else
+        snprintf(buf, size, "%s%" PRIu32, value < 0 ? "-" : "", mag);
+}
+
+static bool same(const char *got, size_t len, const char *want)
+{
+    if (len == strlen(want) && strcmp(got, want) == 0)
+        return true;
+    printf("  got \"%s\" (%zu), want \"%s\"\n", got, len, want);
+    return false;
+}
+
+static uint32_t random_u32(void)
+{
+    return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+static void test_against_snprintf(void)
+{
+    static const int32_t edges[] = { 0, 1, -1, 9, 10, -10, 99, 100, INT32_MAX, INT32_MIN };
+    char got[32], want[32];
+    size_t n;
+
+    for (int i = 0; i < 100000 + (int)(sizeof(edges) / sizeof(edges[0])); i++) {
+        int32_t v = i < (int)(sizeof(edges) / sizeof(edges[0])) ? edges[i] : (int32_t)random_u32();
+        uint8_t decimals = (uint8_t)(i % 4);
+
+        n = fmt_uint(got, sizeof(got), (uint32_t)v);
+        snprintf(want, sizeof(want), "%" PRIu32, (uint32_t)v);
+        if (!CHECK(same(got, n, want)))
+            return;
+
+        n = fmt_int(got, sizeof(got), v);
+        snprintf(want, sizeof(want), "%" PRId32, v);
+        if (!CHECK(same(got, n, want)))
+            return;
+
+        n = fmt_fixed(got, sizeof(got), v, decimals);
+        ref_fixed(want, sizeof(want), v, decimals);
+        if (!CHECK(same(got, n, want)))
+            return;
+
+        n = fmt_uint_pad(got, sizeof(got), (uint32_t)v % 100000, 4, '0');
+        snprintf(want, sizeof(want), "%04" PRIu32, (uint32_t)v % 100000);
+        if (!CHECK(same(got, n, want)))
+            return;
+
+        uint32_t hz = 100000000u + (uint32_t)v % 400000000u;
+        n = fmt_mhz(got, sizeof(got), hz);
+        snprintf(want, sizeof(want), "%" PRIu32 ".%04" PRIu32, (hz + 50) / 1000000, (hz + 50) / 100 % 10000);
+        if (!CHECK(same(got, n, want)))
+            return;
+    }
+}
+
+// The strings the firmware builds, as it builds them
+static void test_firmware_strings(void)
+{
+    char line[32];
+    size_t n;
+
+    n = fmt_str(line, sizeof(line), "RX ");
+    n += fmt_mhz(line + n, sizeof(line) - n, 144450000);
+    n += fmt_str(line + n, sizeof(line) - n, " MHz");
+    CHECK(same(line, n, "RX 144.4500 MHz"));
+
+    n = fmt_str(line, sizeof(line), "Sig: ");
+    n += fmt_fixed(line + n, sizeof(line) - n, -873, 1);
+    n += fmt_str(line + n, sizeof(line) - n, " dBm");
+    CHECK(same(line, n, "Sig: -87.3 dBm"));
+
+    n = fmt_dbm(line, sizeof(line), -121);
+    CHECK(same(line, n, "-121 dBm"));
+
+    n = fmt_mhz(line, sizeof(line), 446006250);
+    CHECK(same(line, n, "446.0063"));
+}
+
+// Truncation keeps the leading characters and always terminates
+static void test_truncation(void)
+{
+    char buf[8];
+
+    memset(buf, 'x', sizeof(buf));
+    CHECK(same(buf, fmt_mhz(buf, 5, 144450000), "144."));
+    CHECK(same(buf, fmt_dbm(buf, 4, -87), "-87"));
+    CHECK(same(buf, fmt_str(buf, 1, "abc"), ""));
+    CHECK(fmt_uint(buf, 0, 5) == 0);
+    CHECK(fmt_uint(NULL, 8, 5) == 0);
+}
+
+int main(void)
+{
+    srand(1);
+    test_against_snprintf();
+    test_firmware_strings();
+    test_truncation();
+
+    return host_report("test_fmt");
+}
@@ -0,0 +1,247 @@
+/**
+ ******************************************************************************
+ * @file      test_morse.c
+ * @brief     The Morse decoder on generated keying, over speed and noise
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details Text is keyed with morse_encode() on an 800 Hz tone with 4 ms
+ *          ramps, noise is added at a given SNR over the whole 4 kHz audio
+ *          band, and the result goes through fake_adc.c and audio.c. Every
+ *          run starts with VVV so the decoder can lock on to the speed.
+ ******************************************************************************
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "audio.h"
+#include "fake_adc.h"
+#include "host.h"
+#include "morse.h"
+#include "scheduler.h"
+
+#define TONE_HZ         800
+#define TONE_AMPLITUDE  8000
+#define RAMP_MS         4
+#define MESSAGE         "CQ DE PA3XYZ K"
+#define NO_NOISE        99      // SNR in dB that means none at all
+
+// ---------------------------------------------------------------------------
+// Stand-ins for the modules morse.c and audio.c call
+// ---------------------------------------------------------------------------
+void menu_update_display_async(void)
+{
+}
+
+void scheduler_post(scheduler_event_t event)
+{
+}
+
+// ---------------------------------------------------------------------------
+// Keyer
+// ---------------------------------------------------------------------------
+static int16_t block[AUDIO_BLOCK_SIZE];
+static uint32_t block_fill = 0;
+static uint32_t phase = 0;
+static double noise_rms = 0.0;
+static uint32_t noise_seed = 1;
+
+// Roughly Gaussian, the sum of four uniform numbers, unit RMS
+static double noise(void)
+{
+    double sum = 0.0;
+
+    for (int i = 0; i < 4; i++) {
+        noise_seed = noise_seed * 1664525u + 1013904223u;
+        sum += (double)(int32_t)noise_seed / 2147483648.0;
+    }
+    return sum * sqrt(3.0) / 2.0;
+}
+
+static void put_sample(double s)
+{
+    s += noise_rms * noise();
+    if (s > INT16_MAX) s = INT16_MAX;
+    if (s < INT16_MIN) s = INT16_MIN;
+    block[block_fill++] = (int16_t)lrint(s);
+
+    if (block_fill == AUDIO_BLOCK_SIZE) {
+        fake_adc_feed(block, AUDIO_BLOCK_SIZE, audio_task);
+        block_fill = 0;
+    }
+}
+
+static void key(bool on, uint32_t ms)
+{
+    uint32_t samples = ms * (AUDIO_SAMPLE_RATE_HZ / 1000);
+    uint32_t ramp = RAMP_MS * (AUDIO_SAMPLE_RATE_HZ / 1000);
+
+    for (uint32_t i = 0; i < samples; i++, phase++) {
+        double gain = 0.0;
+        if (on) {
+            gain = 1.0;
+            if (i < ramp)
+                gain = 0.5 - 0.5 * cos(M_PI * i / ramp);
+            else if (samples - i < ramp)
+                gain = 0.5 - 0.5 * cos(M_PI * (samples - i) / ramp);
+        }
+        put_sample(gain * TONE_AMPLITUDE * sin(2.0 * M_PI * TONE_HZ * phase / AUDIO_SAMPLE_RATE_HZ));
+    }
+}
+
+// Elements 1 and 3 dits, gaps 1 dit inside a character, 3 between
+// characters and 7 between words
+static void send(const char *message, uint32_t wpm)
+{
+    uint32_t dit_ms = 1200 / wpm;
+
+    for (const char *c = message; *c; c++) {
+        if (*c == ' ') {
+            key(false, 4 * dit_ms);     // 3 already after the last character
+            continue;
+        }
+
+        uint8_t code = morse_encode(*c);
+        int8_t msb = 7;
+        while (msb > 0 && !(code & (1u << msb)))
+            msb--;
+        for (int8_t bit = msb - 1; bit >= 0; bit--) {
+            key(true, (code & (1u << bit)) ? 3 * dit_ms : dit_ms);
+            key(false, dit_ms);
+        }
+        key(false, 2 * dit_ms);
+    }
+}
+
+// Decodes "VVV " MESSAGE after a pause, returns what came out of it
+static const char *run(uint32_t wpm, int snr_db)
+{
+    static char decoded[MORSE_TEXT_LEN + 1];
+
+    noise_rms = (snr_db == NO_NOISE) ? 0.0 : TONE_AMPLITUDE / sqrt(2.0) / pow(10.0, snr_db / 20.0);
+
+    key(false, 2000);
+    uint32_t count = morse_get_text_count();
+    send("VVV " MESSAGE, wpm);
+    key(false, 10 * 1200 / wpm);
+
+    // The characters added by this run, the text keeps the last 24
+    uint32_t added = morse_get_text_count() - count;
+    const char *text = morse_get_text();
+    size_t len = strlen(text);
+    if (added > len)
+        added = (uint32_t)len;
+    strcpy(decoded, text + len - added);
+
+    // Trailing word gap
+    len = strlen(decoded);
+    while (len > 0 && decoded[len - 1] == ' ')
+        decoded[--len] = '\0';
+    return decoded;
+}
+
+// Characters of the message that did not come out right, an edit distance
+static uint32_t errors(const char *decoded)
+{
+    const char *expected = MESSAGE;
+    size_t n = strlen(expected);
+    size_t m = strlen(decoded);
+    uint32_t best = UINT32_MAX;
+
+    // The message is at the end, behind whatever the VVV became
+    size_t from = (m > n + 4) ? m - n - 4 : 0;
+    for (size_t start = from; start <= m; start++) {
+        uint32_t row[32];
+        size_t len = m - start;
+
+        if (len >= 32)
+            continue;
+        for (size_t j = 0; j <= len; j++)
+            row[j] = (uint32_t)j;
+        for (size_t i = 1; i <= n; i++) {
+            uint32_t diag = row[0];
+            row[0] = (uint32_t)i;
+            for (size_t j = 1; j <= len; j++) {
+                uint32_t up = row[j];
+                uint32_t cost = diag + (expected[i - 1] != decoded[start + j - 1]);
+                uint32_t v = up + 1 < row[j - 1] + 1 ? up + 1 : row[j - 1] + 1;
+                row[j] = cost < v ? cost : v;
+                diag = up;
+            }
+        }
+        if (row[len] < best)
+            best = row[len];
+    }
+    return best;
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+static void test_encode(void)
+{
+    CHECK(morse_encode('E') == 0x02);       // .
+    CHECK(morse_encode('T') == 0x03);       // -
+    CHECK(morse_encode('a') == 0x05);       // .-
+    CHECK(morse_encode('0') == 0x3F);       // -----
+    CHECK(morse_encode('?') == 0x4C);       // ..--..
+    CHECK(morse_encode('*') == 0 && morse_encode('#') == 0);
+}
+
+static void test_speeds_and_noise(void)
+{
+    static const uint32_t speeds[] = { 10, 15, 20, 25, 30 };
+    static const int snrs[] = { NO_NOISE, 20, 10, 6, 3, 0 };
+
+    printf("  character errors in \"%s\", SNR over 4 kHz\n", MESSAGE);
+    printf("  WPM   clean  20 dB  10 dB   6 dB   3 dB   0 dB\n");
+
+    for (size_t s = 0; s < sizeof(speeds) / sizeof(speeds[0]); s++) {
+        uint8_t wpm = 0;
+
+        printf("  %3u ", speeds[s]);
+        for (size_t n = 0; n < sizeof(snrs) / sizeof(snrs[0]); n++) {
+            const char *decoded = run(speeds[s], snrs[n]);
+            uint32_t e = errors(decoded);
+
+            // 64 sample Goertzel bins are 125 Hz wide, 15 dB narrower than
+            // the band, so down to 6 dB the keying stands out clearly
+            if (snrs[n] >= 6) {
+                CHECK(e == 0);
+                wpm = morse_get_wpm();
+            }
+            printf(" %6u", e);
+        }
+        printf("   locked on %u WPM\n", wpm);
+        CHECK(abs((int)wpm - (int)speeds[s]) <= (int)speeds[s] / 10 + 1);
+    }
+}
+
+// Noise alone, after the squelch opened on it, keys nothing
+static void test_noise_only(void)
+{
+    noise_rms = 0.0;
+    key(false, 1000);
+
+    uint32_t count = morse_get_text_count();
+    noise_rms = 3000.0;
+    key(false, 10000);
+    uint32_t added = morse_get_text_count() - count;
+    CHECK(added <= 1);      // the word gap after the last run
+    printf("  10 s of noise alone: %u characters\n", added);
+}
+
+int main(void)
+{
+    audio_init();
+    morse_init();
+
+    test_encode();
+    test_speeds_and_noise();
+    test_noise_only();
+
+    return host_report("test_morse");
+}
@@ -0,0 +1,229 @@
+/**
+ ******************************************************************************
+ * @file      test_sa818.c
+ * @brief     Drives the sa818_task() command queue against the fake module
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "fake_sa818_uart.h"
+#include "host.h"
+#include "sa818.h"
+#include "scheduler.h"
+
+// ---------------------------------------------------------------------------
+// Stand-ins for the modules sa818.c calls
+// ---------------------------------------------------------------------------
+static unsigned posted_sa818 = 0;
+
+void scheduler_post(scheduler_event_t event)
+{
+    if (event == SCHEDULER_EVENT_SA818)
+        posted_sa818++;
+}
+
+void menu_update_display_async(void)
+{
+}
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+
+// The main loop: the task once per simulated ms
+static void run_ms(uint32_t ms)
+{
+    while (ms--) {
+        sa818_task();
+        host_advance_ms(1);
+    }
+}
+
+static bool run_until_synced(uint32_t max_ms)
+{
+    while (max_ms--) {
+        sa818_task();
+        if (sa818_settings_synced())
+            return true;
+        host_advance_ms(1);
+    }
+    return false;
+}
+
+static void start_module(void)
+{
+    fake_sa818_reset();
+    CHECK(sa818_init() == SA818_OK);
+}
+
+// Waits until an RSSI? is on its way to the module
+static const fake_sa818_cmd_t *run_until_poll(uint32_t max_ms)
+{
+    unsigned before = fake_sa818_count("RSSI?");
+    while (max_ms--) {
+        sa818_task();
+        if (fake_sa818_count("RSSI?") > before)
+            return fake_sa818_last("RSSI?");
+        host_advance_ms(1);
+    }
+    return NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+static void test_init(void)
+{
+    start_module();
+
+    CHECK(fake_sa818_count("AT+DMOCONNECT") == 1);
+    CHECK(fake_sa818_count("AT+DMOSETGROUP=") == 1);
+    CHECK(fake_sa818_count("AT+VERSION") == 1);
+    CHECK(strcmp(sa818_get_settings()->version, "SA818_V5.0") == 0);
+    CHECK(fake_sa818.tuned_hz == 144450000);
+    CHECK(sa818_settings_synced());
+}
+
+static void test_rssi_poll(void)
+{
+    start_module();
+    fake_sa818.rssi = 77;
+
+    unsigned posts = posted_sa818;
+    run_ms(200);
+
+    CHECK(sa818_get_settings()->rssi == 77);
+    CHECK(sa818_get_rssi_count() > 0);
+    CHECK(posted_sa818 > posts);    // queued polls wake the task
+    CHECK(sa818_get_rssi_rtt_ms() >= fake_sa818.reply_ms);
+}
+
+// Encoder turns faster than the module answers: every step is a setter
+// call, the module must end up on the last one and never fall behind
+static void test_fast_retune(void)
+{
+    start_module();
+    run_ms(50);
+
+    uint32_t freq = 144000000;
+    for (int i = 0; i < 40; i++) {
+        freq += SA818_RASTER_NARROW_HZ;
+        sa818_set_tx_frequency(freq);
+        sa818_set_rx_frequency(freq);
+        run_ms(3);
+    }
+
+    CHECK(run_until_synced(1000));
+    CHECK(fake_sa818.tuned_hz == freq);
+    CHECK(sa818_get_settings()->rx_frequency == freq);
+
+    // Coalesced: far fewer writes than steps, and only one on the wire at
+    // a time
+    unsigned groups = fake_sa818_count("AT+DMOSETGROUP=") - 1;
+    CHECK(groups > 0 && groups < 40);
+    printf("  40 steps sent as %u DMOSETGROUP\n", groups);
+}
+
+// A retune while an RSSI? waits for its reply goes out right after the
+// poll has left the wire, not after its reply or timeout
+static void test_retune_ahead_of_poll(void)
+{
+    start_module();
+    fake_sa818.reply_ms = 100;
+
+    const fake_sa818_cmd_t *poll = run_until_poll(500);
+    CHECK(poll != NULL);
+    uint32_t poll_done = poll ? poll->tick : host_tick;
+
+    sa818_set_rx_frequency(145000000);
+    uint32_t set_at = host_tick;
+    CHECK(run_until_synced(1000));
+
+    const fake_sa818_cmd_t *group = fake_sa818_last("AT+DMOSETGROUP=");
+    CHECK(group != NULL);
+    if (group) {
+        uint32_t wire_ms = (uint32_t)strlen(group->cmd) + 2;
+        uint32_t start = set_at > poll_done ? set_at : poll_done;
+        printf("  retune on the wire %u ms after the change\n", group->tick - set_at);
+        CHECK(group->tick - start <= wire_ms + 1);
+    }
+    CHECK(fake_sa818.tuned_hz == 145000000);
+}
+
+// Changes to different groups are each sent once, in queue order
+static void test_all_groups(void)
+{
+    start_module();
+
+    unsigned groups = fake_sa818_count("AT+DMOSETGROUP=");
+    sa818_set_volume_level(7);
+    sa818_set_highpass(1);
+    sa818_set_tail_tone(1);
+    sa818_set_squelch(2);
+    CHECK(run_until_synced(1000));
+
+    CHECK(fake_sa818_count("AT+DMOSETGROUP=") == groups + 1);
+    CHECK(strcmp(fake_sa818_last("AT+DMOSETVOLUME=")->cmd, "AT+DMOSETVOLUME=7") == 0);
+    CHECK(strcmp(fake_sa818_last("AT+SETFILTER=")->cmd, "AT+SETFILTER=0,1,0") == 0);
+    CHECK(strcmp(fake_sa818_last("AT+SETTAIL=")->cmd, "AT+SETTAIL=1") == 0);
+
+    // Setting a value back before it is sent costs nothing
+    unsigned volumes = fake_sa818_count("AT+DMOSETVOLUME=");
+    sa818_set_volume_level(6);
+    sa818_set_volume_level(7);
+    run_ms(100);
+    CHECK(fake_sa818_count("AT+DMOSETVOLUME=") == volumes);
+}
+
+// A refused write is retried a limited number of times
+static void test_refused_write(void)
+{
+    start_module();
+
+    unsigned groups = fake_sa818_count("AT+DMOSETGROUP=");
+    fake_sa818.result = 1;
+    sa818_set_rx_frequency(146000000);
+    run_ms(2000);
+
+    // First attempt plus three retries
+    CHECK(fake_sa818_count("AT+DMOSETGROUP=") == groups + 4);
+
+    // The next change is sent again
+    fake_sa818.result = 0;
+    sa818_set_rx_frequency(146025000);
+    CHECK(run_until_synced(1000));
+    CHECK(fake_sa818.tuned_hz == 146025000);
+}
+
+// No replies: polls time out and back off instead of filling the link
+static void test_silent_module(void)
+{
+    start_module();
+    fake_sa818.silent = true;
+
+    unsigned polls = fake_sa818_count("RSSI?");
+    run_ms(3000);
+    polls = fake_sa818_count("RSSI?") - polls;
+
+    // 300 ms timeout plus 250 ms back-off per poll
+    printf("  %u polls in 3 s without replies\n", polls);
+    CHECK(polls >= 4 && polls <= 6);
+    CHECK(sa818_get_rssi_rate() == 0);
+}
+
+int main(void)
+{
+    test_init();
+    test_rssi_poll();
+    test_fast_retune();
+    test_retune_ahead_of_poll();
+    test_all_groups();
+    test_refused_write();
+    test_silent_module();
+
+    return host_report("test_sa818");
+}
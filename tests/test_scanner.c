@@ -0,0 +1,302 @@
+/**
+ ******************************************************************************
+ * @file      test_scanner.c
+ * @brief     The band scanner through sa818.c against the fake module
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details The fake answers S+ and RSSI? from a band with a few carriers on
+ *          it. sa818_task() and scanner_task() run once per simulated ms as
+ *          in the main loop, commands take their time on the wire at 9600
+ *          baud and the module answers fake_sa818.reply_ms later.
+ ******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fake_sa818_uart.h"
+#include "host.h"
+#include "sa818.h"
+#include "scanner.h"
+#include "scheduler.h"
+
+#define RANGE_START_HZ  144000000
+#define RANGE_STOP_HZ   146000000
+#define RANGE_CHANNELS  161         // 2 MHz in 12.5 kHz steps, both ends
+
+// ---------------------------------------------------------------------------
+// Stand-ins for the modules sa818.c and scanner.c call
+// ---------------------------------------------------------------------------
+static unsigned redraws = 0;
+
+void scheduler_post(scheduler_event_t event)
+{
+}
+
+void menu_update_display_async(void)
+{
+    redraws++;
+}
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+
+// Carriers on the band, nothing anywhere else
+static uint8_t carrier_rssi = 100;
+
+static uint8_t band(uint32_t freq_hz)
+{
+    switch (freq_hz) {
+    case 144800000: return carrier_rssi;    // APRS
+    case 145500000: return 80;
+    case 145600000: return 60;
+    default:        return 0;
+    }
+}
+
+static bool is_carrier(uint32_t freq_hz)
+{
+    return freq_hz == 144800000 || freq_hz == 145500000 || freq_hz == 145600000;
+}
+
+static uint8_t max_pending = 0;
+
+// The main loop: both tasks once per simulated ms
+static void run_ms(uint32_t ms)
+{
+    while (ms--) {
+        sa818_task();
+        scanner_task();
+        if (sa818_scan_pending() > max_pending)
+            max_pending = sa818_scan_pending();
+        host_advance_ms(1);
+    }
+}
+
+static bool run_until_sweeps(uint32_t sweeps, uint32_t max_ms)
+{
+    while (max_ms--) {
+        run_ms(1);
+        if (scanner_get_sweeps() >= sweeps)
+            return true;
+    }
+    return false;
+}
+
+// Until the channel has been read n more times
+static bool run_until_reads(const scanner_channel_t *ch, uint16_t n, uint32_t max_ms)
+{
+    uint16_t reads = ch->reads + n;
+
+    while (max_ms--) {
+        run_ms(1);
+        if (ch->reads >= reads)
+            return true;
+    }
+    return false;
+}
+
+static void start_module(void)
+{
+    fake_sa818_reset();
+    fake_sa818.band_rssi = band;
+    CHECK(sa818_init() == SA818_OK);
+    run_ms(100);
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+static void test_range(void)
+{
+    scanner_init();
+    CHECK(scanner_get_channel_count() == RANGE_CHANNELS);
+    CHECK(scanner_get_frequency(0) == RANGE_START_HZ);
+    CHECK(scanner_get_frequency(1) == RANGE_START_HZ + SA818_RASTER_NARROW_HZ);
+    CHECK(scanner_get_frequency(RANGE_CHANNELS - 1) == RANGE_STOP_HZ);
+    CHECK(scanner_get_frequency(RANGE_CHANNELS) == 0 && scanner_get_channel(RANGE_CHANNELS) == NULL);
+
+    // Cut off at the table size
+    scanner_set_range(430000000, 440000000, SA818_RASTER_NARROW_HZ);
+    CHECK(scanner_get_channel_count() == SCANNER_MAX_CHANNELS);
+    scanner_init();
+}
+
+// Two full sweeps: every channel read in order, the carriers found and
+// nothing else
+static void test_sweep(void)
+{
+    start_module();
+    scanner_init();
+    unsigned first_cmd = fake_sa818_log_count();
+
+    max_pending = 0;
+    scanner_start();
+    CHECK(scanner_is_running());
+    CHECK(run_until_sweeps(2, 20000));
+
+    uint32_t stray = 0;
+    for (uint16_t i = 0; i < scanner_get_channel_count(); i++) {
+        const scanner_channel_t *ch = scanner_get_channel(i);
+        uint32_t f = scanner_get_frequency(i);
+
+        CHECK(ch->reads >= 2);
+        if (ch->max != band(f) || ch->last != band(f) || ch->signal != is_carrier(f) ||
+            ch->avg_q4 != band(f) * 16)
+            stray++;
+    }
+    CHECK(stray == 0);
+
+    // The S+ commands walk the channels in order, wrapping at the end
+    uint32_t expected = RANGE_START_HZ;
+    uint32_t out_of_order = 0;
+    for (unsigned i = first_cmd; i < fake_sa818_log_count(); i++) {
+        const char *cmd = fake_sa818_log(i)->cmd;
+        if (strncmp(cmd, "S+", 2) != 0)
+            continue;
+        if (fake_sa818_parse_mhz(cmd + 2) != expected)
+            out_of_order++;
+        expected += SA818_RASTER_NARROW_HZ;
+        if (expected > RANGE_STOP_HZ)
+            expected = RANGE_START_HZ;
+    }
+    CHECK(out_of_order == 0);
+    CHECK(max_pending <= SCANNER_AHEAD);
+
+    // Every read redraws, the menu throttles it
+    CHECK(redraws >= 2 * RANGE_CHANNELS);
+}
+
+// Reads per second, against the time a channel takes on the wire
+static void test_rate(void)
+{
+    uint32_t updates = scanner_get_update_count();
+    run_ms(3000);
+    uint16_t per_s = (uint16_t)((scanner_get_update_count() - updates) / 3);
+
+    CHECK(scanner_get_rate() > 0);
+    CHECK(per_s > 0 && abs((int)scanner_get_rate() - (int)per_s) <= 2);
+
+    // "S+144.0125\r\n" and "RSSI?\r\n" at 1 ms a byte, each with its reply
+    uint32_t channel_ms = 12 + 7 + 2 * fake_sa818.reply_ms;
+    printf("  %u channels/s, %u ms per channel, %u ms on the wire and waiting for replies\n",
+           scanner_get_rate(), 1000 / scanner_get_rate(), channel_ms);
+    CHECK(1000 / scanner_get_rate() <= channel_ms + 2);
+}
+
+// A carrier that goes away: the maximum stays, the average follows by
+// an eighth per read
+static void test_average(void)
+{
+    const scanner_channel_t *ch = scanner_get_channel((144800000 - RANGE_START_HZ) / SA818_RASTER_NARROW_HZ);
+
+    // Not while the channel is on its way
+    CHECK(run_until_reads(ch, 1, 20000));
+    carrier_rssi = 20;
+    CHECK(run_until_reads(ch, 1, 20000));
+    CHECK(ch->last == 20 && ch->max == 100);
+    CHECK(ch->avg_q4 == 1600 - 1280 / 8);
+    CHECK(run_until_reads(ch, 1, 20000));
+    CHECK(ch->avg_q4 == 1440 - 1120 / 8);
+    carrier_rssi = 100;
+}
+
+// Transmitting pauses the scan, what is queued still comes back
+static void test_transmit_pauses(void)
+{
+    // A fresh command log, the sweeps filled it
+    scanner_stop();
+    start_module();
+    scanner_start();
+    run_ms(500);
+
+    sa818_set_mode(SA818_MODE_TX);
+    run_ms(500);
+    CHECK(sa818_scan_pending() == 0);
+
+    unsigned scans = fake_sa818_count("S+");
+    uint32_t updates = scanner_get_update_count();
+    run_ms(2000);
+    CHECK(fake_sa818_count("S+") == scans);
+    CHECK(scanner_get_update_count() == updates);
+
+    sa818_set_mode(SA818_MODE_RX);
+    run_ms(500);
+    CHECK(fake_sa818_count("S+") > scans);
+}
+
+// Stopping drops the queue and puts the receiver back on its frequency
+static void test_stop(void)
+{
+    scanner_stop();
+    CHECK(!scanner_is_running());
+
+    unsigned scans = fake_sa818_count("S+");
+    run_ms(1000);
+    CHECK(fake_sa818_count("S+") <= scans + 1);     // one may have been on the wire
+    CHECK(sa818_settings_synced());
+    CHECK(fake_sa818.tuned_hz == sa818_get_settings()->rx_frequency);
+    CHECK(sa818_scan_pending() == 0);
+}
+
+// A list instead of a range, and a list changed while scanning
+static void test_list(void)
+{
+    static const uint32_t list[] = { 145500000, 144800000, 433000000 };
+    static const uint32_t other[] = { 145600000, 145650000 };
+
+    scanner_set_list(list, 3);
+    scanner_start();
+    CHECK(run_until_sweeps(3, 5000));
+    CHECK(scanner_get_channel(0)->last == 80 && scanner_get_channel(1)->last == 100);
+    CHECK(scanner_get_channel(2)->reads >= 3 && !scanner_get_channel(2)->signal);
+
+    // Results for the old list still on their way are dropped
+    scanner_set_list(other, 2);
+    CHECK(run_until_sweeps(2, 5000));
+    CHECK(scanner_get_channel(0)->max == 60 && scanner_get_channel(1)->max == 0);
+    CHECK(scanner_get_channel(0)->reads == scanner_get_channel(1)->reads ||
+          scanner_get_channel(0)->reads == scanner_get_channel(1)->reads + 1);
+    scanner_stop();
+    run_ms(1000);
+}
+
+// A module that stops answering: the scan keeps going round on timeouts
+// and reads nothing, then picks up again
+static void test_silent_module(void)
+{
+    scanner_init();
+    scanner_start();
+    run_ms(1000);
+
+    fake_sa818.silent = true;
+    run_ms(100);
+    uint32_t updates = scanner_get_update_count();
+    uint32_t sweeps = scanner_get_sweeps();
+    run_ms(30000);
+    CHECK(scanner_get_update_count() == updates);
+    CHECK(scanner_get_sweeps() >= sweeps);
+    CHECK(sa818_scan_pending() <= SCANNER_AHEAD);
+
+    fake_sa818.silent = false;
+    run_ms(3000);
+    CHECK(scanner_get_update_count() > updates);
+    scanner_stop();
+}
+
+int main(void)
+{
+    test_range();
+    test_sweep();
+    test_rate();
+    test_average();
+    test_transmit_pauses();
+    test_stop();
+    test_list();
+    test_silent_module();
+
+    return host_report("test_scanner");
+}
@@ -0,0 +1,265 @@
+/**
+ ******************************************************************************
+ * @file      test_scheduler.c
+ * @brief     The scheduler on a simulated clock, built with SCHEDULER_HOST
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details The hooks below are the SCHEDULER_HOST clock and WFI. Idle sleeps
+ *          to the next SysTick, or to an interrupt set up by the test that
+ *          posts an event, and leaves scheduler_run() when the run is over.
+ *          Tasks cost simulated time by moving the clock themselves.
+ ******************************************************************************
+ */
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "host.h"
+#include "scheduler.h"
+
+#define NO_IRQ  UINT32_MAX
+
+// ---------------------------------------------------------------------------
+// SCHEDULER_HOST hooks
+// ---------------------------------------------------------------------------
+static uint32_t now_us = 0;
+static uint32_t end_us = 0;
+static jmp_buf run_done;
+static uint32_t idles = 0;
+
+// One simulated interrupt, posts its event when the clock gets there
+static uint32_t irq_at_us = NO_IRQ;
+static scheduler_event_t irq_event;
+
+uint32_t scheduler_host_get_ms(void)
+{
+    return now_us / 1000;
+}
+
+uint32_t scheduler_host_get_us(void)
+{
+    return now_us;
+}
+
+void scheduler_host_idle(void)
+{
+    uint32_t tick = (now_us / 1000 + 1) * 1000;
+
+    idles++;
+    if (irq_at_us < tick) {
+        if (irq_at_us > now_us)
+            now_us = irq_at_us;
+        irq_at_us = NO_IRQ;
+        scheduler_post(irq_event);
+    } else {
+        now_us = tick;
+    }
+
+    if ((int32_t)(now_us - end_us) >= 0)
+        longjmp(run_done, 1);
+}
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+
+// scheduler_run() for ms of simulated time
+static void run_ms(uint32_t ms)
+{
+    end_us = now_us + ms * 1000;
+    if (!setjmp(run_done))
+        scheduler_run();
+}
+
+static void irq_at(uint32_t us, scheduler_event_t event)
+{
+    irq_at_us = us;
+    irq_event = event;
+}
+
+// Tasks, each appends its letter to the trace of the pass
+static char trace[64];
+static uint32_t trace_len = 0;
+static uint32_t runs_periodic = 0;
+static uint32_t runs_audio = 0;
+static uint32_t runs_display = 0;
+static bool post_from_audio = false;
+
+static void traced(char c)
+{
+    if (trace_len < sizeof(trace) - 1) {
+        trace[trace_len++] = c;
+        trace[trace_len] = '\0';
+    }
+}
+
+static void clear_trace(void)
+{
+    trace_len = 0;
+    trace[0] = '\0';
+}
+
+// 10 ms period, costs 300 us
+static void task_periodic(void)
+{
+    runs_periodic++;
+    now_us += 300;
+    traced('p');
+}
+
+static void task_audio(void)
+{
+    runs_audio++;
+    traced('a');
+    if (post_from_audio) {
+        post_from_audio = false;
+        scheduler_post(SCHEDULER_EVENT_DISPLAY);
+    }
+}
+
+static void task_display(void)
+{
+    runs_display++;
+    traced('d');
+}
+
+static void start(void)
+{
+    scheduler_init();
+    CHECK(scheduler_add("periodic", task_periodic, 10, 0) == 0);
+    CHECK(scheduler_add("audio", task_audio, 0, SCHEDULER_EVENT_MASK(SCHEDULER_EVENT_AUDIO)) == 1);
+    CHECK(scheduler_add("display", task_display, 0,
+                        SCHEDULER_EVENT_MASK(SCHEDULER_EVENT_DISPLAY) |
+                        SCHEDULER_EVENT_MASK(SCHEDULER_EVENT_AUDIO)) == 2);
+    runs_periodic = runs_audio = runs_display = 0;
+    idles = 0;
+    clear_trace();
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+static void test_add(void)
+{
+    scheduler_init();
+    CHECK(scheduler_get_task_count() == 0);
+    CHECK(scheduler_add("null", NULL, 10, 0) == -1);
+    for (int i = 0; i < SCHEDULER_MAX_TASKS; i++)
+        CHECK(scheduler_add("t", task_display, 0, 0) == i);
+    CHECK(scheduler_add("full", task_display, 0, 0) == -1);
+    CHECK(scheduler_get_task_count() == SCHEDULER_MAX_TASKS);
+    CHECK(scheduler_get_stats(SCHEDULER_MAX_TASKS) == NULL);
+}
+
+// Nothing but a 10 ms period: the core sleeps once per tick and the
+// event tasks never run. The run ends on the tick of the 100th period.
+static void test_idle(void)
+{
+    start();
+    run_ms(1000);
+
+    CHECK(runs_periodic == 99 && runs_audio == 0 && runs_display == 0);
+    CHECK(idles == 1000);
+    CHECK(scheduler_get_stats(0)->runs == 99);
+    CHECK(scheduler_get_stats(0)->max_latency_us == 0);
+    printf("  1 s: periodic task %u runs, %u sleeps, nothing else ran\n", runs_periodic, idles);
+}
+
+// An interrupt wakes the core, the pass runs every task waiting for the
+// event, in the order they were added
+static void test_event(void)
+{
+    start();
+    irq_at(now_us + 2500, SCHEDULER_EVENT_AUDIO);
+    run_ms(5);
+
+    CHECK(runs_audio == 1 && runs_display == 1);
+    CHECK(scheduler_get_stats(1)->max_latency_us == 0);
+    CHECK(idles == 6);      // one to the interrupt, then on to each tick
+    CHECK(strcmp(trace, "ad") == 0);
+}
+
+// Latency counts from the post to the start of the task
+static void test_latency(void)
+{
+    start();
+    uint32_t added_ms = scheduler_host_get_ms();
+    scheduler_post(SCHEDULER_EVENT_AUDIO);
+    now_us += 250;
+    CHECK(scheduler_run_once());
+
+    CHECK(scheduler_get_stats(1)->max_latency_us == 250);
+    CHECK(scheduler_get_stats(2)->max_latency_us == 250);
+
+    // Behind the 300 us periodic task in the same pass
+    now_us = (added_ms + 10) * 1000;
+    scheduler_post(SCHEDULER_EVENT_AUDIO);
+    clear_trace();
+    CHECK(scheduler_run_once());
+    CHECK(strcmp(trace, "pad") == 0);
+    CHECK(scheduler_get_stats(1)->max_latency_us == 300);
+    CHECK(scheduler_get_stats(2)->max_latency_us == 300);
+    CHECK(scheduler_get_stats(0)->runs == 1 && scheduler_get_stats(1)->runs == 2);
+    printf("  worst latency periodic %u us, audio %u us, display %u us\n",
+           scheduler_get_stats(0)->max_latency_us, scheduler_get_stats(1)->max_latency_us,
+           scheduler_get_stats(2)->max_latency_us);
+
+    scheduler_reset_stats();
+    CHECK(scheduler_get_stats(1)->runs == 0 && scheduler_get_stats(1)->max_latency_us == 0);
+    CHECK(!scheduler_run_once());
+}
+
+// A post from a task is kept for the next pass, two posts before a pass
+// run the task once
+static void test_posts(void)
+{
+    start();
+    post_from_audio = true;
+    scheduler_post(SCHEDULER_EVENT_AUDIO);
+    CHECK(scheduler_run_once());
+    CHECK(runs_audio == 1 && runs_display == 1);
+    CHECK(scheduler_run_once());
+    CHECK(runs_display == 2);
+    CHECK(!scheduler_run_once());
+
+    scheduler_post(SCHEDULER_EVENT_AUDIO);
+    scheduler_post(SCHEDULER_EVENT_AUDIO);
+    CHECK(scheduler_run_once());
+    CHECK(!scheduler_run_once());
+    CHECK(runs_audio == 2);
+
+    // Out of range is ignored
+    scheduler_post(SCHEDULER_EVENT_COUNT);
+    CHECK(!scheduler_run_once());
+}
+
+// After a 95 ms stall the periodic task runs once, not nine times, and
+// then keeps its period again
+static void test_stall(void)
+{
+    start();
+    run_ms(20);
+    uint32_t runs = runs_periodic;
+
+    now_us += 95000;
+    CHECK(scheduler_run_once());
+    CHECK(runs_periodic == runs + 1);
+    CHECK(scheduler_get_stats(0)->max_latency_us == 0);     // ready when the pass saw it
+
+    run_ms(100);
+    CHECK(runs_periodic == runs + 1 + 10);
+}
+
+int main(void)
+{
+    test_add();
+    test_idle();
+    test_event();
+    test_latency();
+    test_posts();
+    test_stall();
+
+    return host_report("test_scheduler");
+}
@@ -0,0 +1,215 @@
+/**
+ ******************************************************************************
+ * @file      test_signal_meter.c
+ * @brief     Accuracy of the signal meter on synthesized receiver audio
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details Tones and noise go through fake_adc.c and audio.c as on the
+ *          board. The integer RMS and dB of the meter are held against the
+ *          same numbers in floating point.
+ ******************************************************************************
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "audio.h"
+#include "fake_adc.h"
+#include "host.h"
+#include "scheduler.h"
+#include "signal_meter.h"
+
+// ---------------------------------------------------------------------------
+// Stand-ins for the modules signal_meter.c and audio.c call
+// ---------------------------------------------------------------------------
+static float atten_db = 0.0f;
+static float rssi = 0.0f;           // as the SA818 reports it, before the attenuator
+static unsigned redraws = 0;
+
+float attenuator_get(void)
+{
+    return atten_db;
+}
+
+float attenuator_get_effective_rssi(void)
+{
+    return rssi + atten_db;
+}
+
+void menu_update_display_async(void)
+{
+    redraws++;
+}
+
+void scheduler_post(scheduler_event_t event)
+{
+}
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+static uint32_t noise_seed = 1;
+
+// Uniform in [-amplitude, amplitude], repeatable
+static int16_t noise(int32_t amplitude)
+{
+    noise_seed = noise_seed * 1664525u + 1013904223u;
+    return (int16_t)(((int64_t)(int32_t)noise_seed * amplitude) >> 31);
+}
+
+static void feed_tone(uint32_t hz, int32_t amplitude, uint32_t ms)
+{
+    static uint32_t phase = 0;
+    int16_t block[AUDIO_BLOCK_SIZE];
+    uint32_t blocks = ms * (AUDIO_SAMPLE_RATE_HZ / 1000) / AUDIO_BLOCK_SIZE;
+
+    while (blocks--) {
+        for (uint32_t i = 0; i < AUDIO_BLOCK_SIZE; i++, phase++)
+            block[i] = (int16_t)lrint(amplitude * sin(2.0 * M_PI * hz * phase / AUDIO_SAMPLE_RATE_HZ));
+        fake_adc_feed(block, AUDIO_BLOCK_SIZE, audio_task);
+    }
+}
+
+static void feed_noise(int32_t amplitude, uint32_t ms)
+{
+    int16_t block[AUDIO_BLOCK_SIZE];
+    uint32_t blocks = ms * (AUDIO_SAMPLE_RATE_HZ / 1000) / AUDIO_BLOCK_SIZE;
+
+    while (blocks--) {
+        for (uint32_t i = 0; i < AUDIO_BLOCK_SIZE; i++)
+            block[i] = noise(amplitude);
+        fake_adc_feed(block, AUDIO_BLOCK_SIZE, audio_task);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Tests
+// ---------------------------------------------------------------------------
+static void test_update_rate(void)
+{
+    uint32_t updates = signal_meter_get_updates();
+
+    // 62 whole blocks in a second
+    feed_noise(1000, 1000);
+    CHECK(signal_meter_get_updates() - updates == 62 * AUDIO_BLOCK_SIZE / SIGNAL_METER_SEGMENT);
+}
+
+static void test_rms_and_peak(void)
+{
+    static const int32_t amplitudes[] = { 100, 1000, 10000, 30000 };
+    double worst = 0.0;
+
+    for (size_t i = 0; i < sizeof(amplitudes) / sizeof(amplitudes[0]); i++) {
+        int32_t a = amplitudes[i];
+
+        // The peak releases by an eighth per update, give it time
+        feed_tone(1000, a, 500);
+        const signal_meter_t *m = signal_meter_get();
+        double expected = a / sqrt(2.0);
+        double error = fabs(m->rms - expected) / expected;
+
+        CHECK(fabs(m->rms - expected) < expected * 0.01 + 1.0);
+        CHECK(abs((int32_t)m->peak - a) <= a / 50 + 8);
+        if (error > worst)
+            worst = error;
+    }
+    printf("  rms off by %.2f %% from amplitude / sqrt(2) from 100 to 30000 counts\n", worst * 100.0);
+}
+
+// The integer log of the quieting against log10() of the same powers
+static void test_quieting(void)
+{
+    double worst = 0.0;
+
+    // No carrier: full noise sets the reference
+    feed_noise(16000, 1000);
+
+    for (int32_t amplitude = 16000; amplitude >= 160; amplitude = amplitude * 7 / 8) {
+        feed_noise(amplitude, 200);
+
+        const signal_meter_t *m = signal_meter_get();
+        double expected = 100.0 * log10((double)m->noise_ref / m->noise_power);
+        double error = fabs(m->quieting_db10 - expected);
+
+        CHECK(error <= 1.0);
+        if (error > worst)
+            worst = error;
+    }
+
+    // 100x less noise amplitude is 40 dB of quieting. The reference holds
+    // the loudest segment, a little above the average.
+    const signal_meter_t *m = signal_meter_get();
+    CHECK(m->quieting_db10 > 390 && m->quieting_db10 < 420);
+    printf("  quieting %.1f dB at 1/100 of the noise, log off by at most %.1f tenths of dB\n",
+           m->quieting_db10 / 10.0, worst);
+}
+
+// Quieting rules near the floor, the RSSI once it is above it, and the
+// attenuation is added back to both
+static void test_level_fusion(void)
+{
+    // Back to no carrier, then 20 dB quieting
+    feed_noise(16000, 1000);
+    feed_noise(1600, 500);
+    const signal_meter_t *m = signal_meter_get();
+    int32_t audio_level = SIGNAL_METER_FLOOR_DBM * 10 + m->quieting_db10;
+    CHECK(abs(signal_meter_get_level_db10() - audio_level) <= 4);
+
+    atten_db = 10.0f;
+    feed_noise(1600, 500);
+    CHECK(abs(signal_meter_get_level_db10() - (audio_level + 100)) <= 8);
+
+    // Strong carrier, -75 dBm read by the RSSI behind 10 dB
+    unsigned before = redraws;
+    rssi = 50.0f;
+    feed_noise(1600, 500);
+    CHECK(abs(signal_meter_get_level_db10() - (SIGNAL_METER_RSSI_OFFSET_DBM + 60) * 10) <= 4);
+    CHECK(redraws > before);
+
+    // A steady level does not ask for redraws
+    before = redraws;
+    feed_noise(1600, 200);
+    CHECK(redraws == before);
+    printf("  level %.1f dB with RSSI 50 behind 10 dB\n", signal_meter_get_level_db10() / 10.0);
+
+    atten_db = 0.0f;
+    rssi = 0.0f;
+}
+
+// The calibration offset moves the fused level by as much, and is clamped
+static void test_offset(void)
+{
+    feed_noise(16000, 1000);
+    int16_t level = signal_meter_get_level_db10();
+
+    signal_meter_set_offset_db10(-45);
+    CHECK(signal_meter_get_offset_db10() == -45);
+    feed_noise(16000, 200);
+    CHECK(abs(signal_meter_get_level_db10() - (level - 45)) <= 4);
+
+    signal_meter_set_offset_db10(1000);
+    CHECK(signal_meter_get_offset_db10() == SIGNAL_METER_OFFSET_MAX_DB10);
+    signal_meter_set_offset_db10(-1000);
+    CHECK(signal_meter_get_offset_db10() == -SIGNAL_METER_OFFSET_MAX_DB10);
+
+    signal_meter_set_offset_db10(0);
+    feed_noise(16000, 200);
+    CHECK(abs(signal_meter_get_level_db10() - level) <= 4);
+}
+
+int main(void)
+{
+    audio_init();
+    signal_meter_init();
+    CHECK(signal_meter_get_level_db10() == SIGNAL_METER_FLOOR_DBM * 10);
+
+    test_update_rate();
+    test_rms_and_peak();
+    test_quieting();
+    test_level_fusion();
+    test_offset();
+
+    return host_report("test_signal_meter");
+}
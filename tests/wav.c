@@ -0,0 +1,151 @@
+/**
+ ******************************************************************************
+ * @file      wav.c
+ * @brief     Minimal WAV reader and writer for the audio host tests
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ * @details Only the "fmt " and "data" chunks are looked at, anything else in
+ *          the RIFF file is skipped.
+ ******************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "wav.h"
+
+// ---------------------------------------------------------------------------
+// Private helpers
+// ---------------------------------------------------------------------------
+static uint32_t wav_get_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t wav_get_le16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static void wav_put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void wav_put_le16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+// ---------------------------------------------------------------------------
+// Public functions
+// ---------------------------------------------------------------------------
+bool wav_read(const char *path, wav_t *wav)
+{
+    uint8_t header[12];
+    uint8_t chunk[8];
+    uint16_t channels = 0;
+    uint16_t bits = 0;
+    bool ok = false;
+
+    memset(wav, 0, sizeof(*wav));
+
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+        return false;
+
+    if (fread(header, 1, sizeof(header), f) != sizeof(header) ||
+        memcmp(header, "RIFF", 4) != 0 || memcmp(header + 8, "WAVE", 4) != 0)
+        goto done;
+
+    while (fread(chunk, 1, sizeof(chunk), f) == sizeof(chunk)) {
+        uint32_t size = wav_get_le32(chunk + 4);
+
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            uint8_t fmt[16];
+            if (fread(fmt, 1, sizeof(fmt), f) != sizeof(fmt))
+                goto done;
+            if (wav_get_le16(fmt) != 1)     // PCM
+                goto done;
+            channels = wav_get_le16(fmt + 2);
+            wav->rate = wav_get_le32(fmt + 4);
+            bits = wav_get_le16(fmt + 14);
+            size -= sizeof(fmt);
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            if (bits != 16 || channels == 0)
+                goto done;
+
+            uint32_t frames = size / (2u * channels);
+            int16_t *frame = malloc(2u * channels);
+            wav->samples = malloc(frames * sizeof(int16_t) + 1);
+            if (frame == NULL || wav->samples == NULL) {
+                free(frame);
+                goto done;
+            }
+
+            for (uint32_t i = 0; i < frames; i++) {
+                uint8_t *b = (uint8_t *)frame;
+                if (fread(b, 2u, channels, f) != channels)
+                    break;
+                wav->samples[wav->count++] = (int16_t)wav_get_le16(b);
+            }
+            free(frame);
+            ok = true;
+            goto done;
+        }
+
+        // Chunks are padded to an even size
+        if (fseek(f, (long)(size + (size & 1u)), SEEK_CUR) != 0)
+            goto done;
+    }
+
+done:
+    fclose(f);
+    if (!ok)
+        wav_free(wav);
+    return ok;
+}
+
+void wav_free(wav_t *wav)
+{
+    free(wav->samples);
+    wav->samples = NULL;
+    wav->count = 0;
+}
+
+bool wav_write(const char *path, const int16_t *samples, uint32_t count, uint32_t rate)
+{
+    uint8_t header[44];
+
+    memcpy(header, "RIFF", 4);
+    wav_put_le32(header + 4, 36 + count * 2u);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    wav_put_le32(header + 16, 16);
+    wav_put_le16(header + 20, 1);           // PCM
+    wav_put_le16(header + 22, 1);           // mono
+    wav_put_le32(header + 24, rate);
+    wav_put_le32(header + 28, rate * 2u);   // bytes per second
+    wav_put_le16(header + 32, 2);           // bytes per frame
+    wav_put_le16(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    wav_put_le32(header + 40, count * 2u);
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL)
+        return false;
+
+    bool ok = fwrite(header, 1, sizeof(header), f) == sizeof(header);
+    for (uint32_t i = 0; ok && i < count; i++) {
+        uint8_t b[2];
+        wav_put_le16(b, (uint16_t)samples[i]);
+        ok = fwrite(b, 1, 2, f) == 2;
+    }
+
+    return fclose(f) == 0 && ok;
+}
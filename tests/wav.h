@@ -0,0 +1,44 @@
+/**
+ ******************************************************************************
+ * @file      wav.h
+ * @brief     Minimal WAV reader and writer for the audio host tests
+ * @author    R. van Renswoude
+ * @date      2025
+ ******************************************************************************
+ */
+
+#ifndef __WAV_H
+#define __WAV_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    int16_t *samples;       // first channel only, malloc'ed
+    uint32_t count;
+    uint32_t rate;
+} wav_t;
+
+/**
+ * @brief Read 16 bit PCM, any rate, any channel count
+ * @return false when the file is missing or not 16 bit PCM
+ */
+bool wav_read(const char *path, wav_t *wav);
+
+void wav_free(wav_t *wav);
+
+/**
+ * @brief Write 16 bit mono PCM
+ * @return false when the file could not be written
+ */
+bool wav_write(const char *path, const int16_t *samples, uint32_t count, uint32_t rate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __WAV_H */